@@ -3,6 +3,7 @@
 // See the LICENSE file in the project root for more information.
 
 #include "apphost.windows.h"
+#include "env_snapshot.h"
 #include "error_codes.h"
 #include "pal.h"
 #include "trace.h"
@@ -57,8 +58,7 @@ namespace
             && error_code != StatusCode::FrameworkMissingFailure) // missing framework
             return;
 
-        pal::string_t gui_errors_disabled;
-        if (pal::getenv(_X("DOTNET_DISABLE_GUI_ERRORS"), &gui_errors_disabled) && pal::xtoi(gui_errors_disabled.c_str()) == 1)
+        if (env_snapshot::is_enabled(env_key_t::DOTNET_DISABLE_GUI_ERRORS))
             return;
 
         pal::string_t dialogMsg = _X("To run this application, you must install .NET Core.\n\n");
@@ -5,6 +5,7 @@
 #include "extractor.h"
 #include "error_codes.h"
 #include "dir_utils.h"
+#include "env_snapshot.h"
 #include "pal.h"
 #include "utils.h"
 
@@ -17,7 +18,7 @@ using namespace bundle;
 // base directory defaults to $TMPDIR/.net
 void extractor_t::determine_extraction_dir()
 {
-    if (!pal::getenv(_X("DOTNET_BUNDLE_EXTRACT_BASE_DIR"), &m_extraction_dir))
+    if (!env_snapshot::get(env_key_t::DOTNET_BUNDLE_EXTRACT_BASE_DIR, &m_extraction_dir))
     {
         if (!pal::get_temp_directory(m_extraction_dir))
         {
@@ -0,0 +1,192 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __CACHE_IO_H_
+#define __CACHE_IO_H_
+
+#include <cstring>
+#include <vector>
+#include "pal.h"
+#include "version.h"
+
+// Helpers to write and read the binary cache files of the host (deps cache, startup cache).
+// The files are only ever read by the same build of the host which wrote them, so values
+// are written in the native byte order and layout.
+
+// FNV-1a
+inline uint64_t get_content_hash(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+class cache_writer_t
+{
+public:
+    cache_writer_t(std::vector<char>* buffer)
+        : m_buffer(*buffer)
+    { }
+
+    template<typename T>
+    void write_value(T value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write_string(const pal::string_t& str)
+    {
+        write_value(static_cast<uint32_t>(str.length()));
+        const char* bytes = reinterpret_cast<const char*>(str.data());
+        m_buffer.insert(m_buffer.end(), bytes, bytes + str.length() * sizeof(pal::char_t));
+    }
+
+    void write_version(const version_t& version)
+    {
+        write_value(static_cast<int32_t>(version.get_major()));
+        write_value(static_cast<int32_t>(version.get_minor()));
+        write_value(static_cast<int32_t>(version.get_build()));
+        write_value(static_cast<int32_t>(version.get_revision()));
+    }
+
+private:
+    std::vector<char>& m_buffer;
+};
+
+// All reads are bounds checked, a truncated or corrupted cache file simply fails to load.
+class cache_reader_t
+{
+public:
+    cache_reader_t(const char* data, size_t size)
+        : m_pos(data)
+        , m_end(data + size)
+    { }
+
+    template<typename T>
+    bool read_value(T* value)
+    {
+        if (remaining() < sizeof(T))
+        {
+            return false;
+        }
+
+        memcpy(value, m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool read_string(pal::string_t* str)
+    {
+        uint32_t length;
+        if (!read_value(&length) || remaining() / sizeof(pal::char_t) < length)
+        {
+            return false;
+        }
+
+        str->resize(length);
+        memcpy(&(*str)[0], m_pos, length * sizeof(pal::char_t));
+        m_pos += length * sizeof(pal::char_t);
+        return true;
+    }
+
+    bool read_version(version_t* version)
+    {
+        int32_t major, minor, build, revision;
+        if (!read_value(&major) || !read_value(&minor) || !read_value(&build) || !read_value(&revision))
+        {
+            return false;
+        }
+
+        *version = version_t(major, minor, build, revision);
+        return true;
+    }
+
+    bool match_bytes(const std::vector<char>& bytes)
+    {
+        if (remaining() < bytes.size() || memcmp(m_pos, bytes.data(), bytes.size()) != 0)
+        {
+            return false;
+        }
+
+        m_pos += bytes.size();
+        return true;
+    }
+
+    bool at_end() const { return m_pos == m_end; }
+
+private:
+    size_t remaining() const { return static_cast<size_t>(m_end - m_pos); }
+
+    const char* m_pos;
+    const char* m_end;
+};
+
+enum class cache_write_status
+{
+    written,
+    create_failed,
+    write_failed,
+    inputs_too_recent,
+};
+
+// Writes a cache file through a temporary file which is moved in place, so that concurrently
+// starting processes never observe a partially written cache.
+//
+// A change made within the time stamp granularity of the file system, right after one of the
+// input_stamps was taken, would go unnoticed. So the cache is only written if all of them are
+// older than the cache file itself.
+inline cache_write_status write_cache_file(const pal::string_t& path, const std::vector<char>& buffer, const std::vector<pal::file_stamp_t>& input_stamps)
+{
+    pal::string_t temp_path = path;
+    temp_path.append(_X("."));
+    temp_path.append(pal::to_string(pal::get_pid()));
+    temp_path.append(_X(".tmp"));
+
+    FILE* file = pal::file_open(temp_path, _X("wb"));
+    if (file == nullptr)
+    {
+        return cache_write_status::create_failed;
+    }
+
+    bool written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    written = (fclose(file) == 0) && written;
+
+    pal::file_stamp_t cache_stamp;
+    if (written && !input_stamps.empty())
+    {
+        written = pal::get_file_stamp(temp_path, &cache_stamp);
+        for (const auto& stamp : input_stamps)
+        {
+            if (written && stamp.last_write_time >= cache_stamp.last_write_time)
+            {
+                pal::remove(temp_path.c_str());
+                return cache_write_status::inputs_too_recent;
+            }
+        }
+    }
+
+    if (written && pal::rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        // Renaming over an existing file fails on Windows
+        pal::remove(path.c_str());
+        written = pal::rename(temp_path.c_str(), path.c_str()) == 0;
+    }
+
+    if (!written)
+    {
+        pal::remove(temp_path.c_str());
+        return cache_write_status::write_failed;
+    }
+
+    return cache_write_status::written;
+}
+
+#endif // __CACHE_IO_H_
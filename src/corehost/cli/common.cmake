@@ -25,10 +25,12 @@ include_directories(${CMAKE_CURRENT_LIST_DIR}/../)
 include_directories(${CMAKE_CURRENT_LIST_DIR}/../common)
 
 list(APPEND SOURCES
+    ${CMAKE_CURRENT_LIST_DIR}/../common/env_snapshot.cpp
     ${CMAKE_CURRENT_LIST_DIR}/../common/trace.cpp
     ${CMAKE_CURRENT_LIST_DIR}/../common/utils.cpp)
 
 list(APPEND HEADERS
+    ${CMAKE_CURRENT_LIST_DIR}/../common/env_snapshot.h
     ${CMAKE_CURRENT_LIST_DIR}/../common/trace.h
     ${CMAKE_CURRENT_LIST_DIR}/../common/utils.h
     ${CMAKE_CURRENT_LIST_DIR}/../common/pal.h
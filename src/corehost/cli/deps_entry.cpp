@@ -5,10 +5,31 @@
 #include "pal.h"
 #include "utils.h"
 #include "deps_entry.h"
+#include "dir_listing_cache.h"
 #include "trace.h"
 
+const pal::string_t pooled_string_t::s_empty;
 
-bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str) const
+size_t package_key_t::get_hash(const pal::string_t& name, const pal::string_t& version)
+{
+    std::hash<pal::string_t> string_hash;
+    size_t hash = string_hash(name);
+    return hash ^ (string_hash(version) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+void deps_entry_t::move_to_pool(string_pool_t& pool)
+{
+    deps_file = pool.add(deps_file);
+    library_type = pool.add(library_type);
+    library_name = pool.add(library_name);
+    library_version = pool.add(library_version);
+    library_hash = pool.add(library_hash);
+    library_path = pool.add(library_path);
+    library_hash_path = pool.add(library_hash_path);
+    runtime_store_manifest_list = pool.add(runtime_store_manifest_list);
+}
+
+bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str, dir_listing_cache_t* dir_cache) const
 {
     pal::string_t& candidate = *str;
 
@@ -36,16 +57,16 @@ bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::st
     pal::string_t sub_path = look_in_base ? get_filename(pal_relative_path) : pal_relative_path;
     append_path(&candidate, sub_path.c_str());
 
-    bool exists = pal::file_exists(candidate);
+    bool exists = dir_cache != nullptr ? dir_cache->file_exists(candidate) : pal::file_exists(candidate);
     const pal::char_t* query_type = look_in_base ? _X("Local") : _X("Relative");
     if (!exists)
     {
-        trace::verbose(_X("    %s path query did not exist %s"), query_type, candidate.c_str());
+        TRACE_VERBOSE(_X("    %s path query did not exist %s"), query_type, candidate.c_str());
         candidate.clear();
     }
     else
     {
-        trace::verbose(_X("    %s path query exists %s"), query_type, candidate.c_str());
+        TRACE_VERBOSE(_X("    %s path query exists %s"), query_type, candidate.c_str());
     }
     return exists;
 }
@@ -61,7 +82,7 @@ bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::st
 // Returns:
 //    If the file exists in the path relative to the "base" directory.
 //
-bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str, dir_listing_cache_t* dir_cache) const
 {
     if (asset_type == asset_types::resources)
     {
@@ -84,10 +105,10 @@ bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str) co
         
         pal::string_t base_ietf_dir = base;
         append_path(&base_ietf_dir, ietf.c_str());
-        trace::verbose(_X("Detected a resource asset, will query dir/ietf-tag/resource base: %s asset: %s"), base_ietf_dir.c_str(), asset.name.c_str());
-        return to_path(base_ietf_dir, true, str);
+        TRACE_VERBOSE(_X("Detected a resource asset, will query dir/ietf-tag/resource base: %s asset: %s"), base_ietf_dir.c_str(), asset.name.c_str());
+        return to_path(base_ietf_dir, true, str, dir_cache);
     }
-    return to_path(base, true, str);
+    return to_path(base, true, str, dir_cache);
 }
 // -----------------------------------------------------------------------------
 // Given a "base" directory, yield the relative path of this file in the package
@@ -101,9 +122,9 @@ bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str) co
 // Returns:
 //    If the file exists in the path relative to the "base" directory.
 //
-bool deps_entry_t::to_rel_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_rel_path(const pal::string_t& base, pal::string_t* str, dir_listing_cache_t* dir_cache) const
 {
-    return to_path(base, false, str);
+    return to_path(base, false, str, dir_cache);
 }
 
 // -----------------------------------------------------------------------------
@@ -118,7 +139,7 @@ bool deps_entry_t::to_rel_path(const pal::string_t& base, pal::string_t* str) co
 // Returns:
 //    If the file exists in the path relative to the "base" directory.
 //
-bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str, dir_listing_cache_t* dir_cache) const
 {
     str->clear();
 
@@ -140,5 +161,5 @@ bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str) c
         append_path(&new_base, library_path.c_str());
     }
 
-    return to_rel_path(new_base, str);
+    return to_rel_path(new_base, str, dir_cache);
 }
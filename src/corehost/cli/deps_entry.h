@@ -7,10 +7,95 @@
 
 #include <iostream>
 #include <array>
+#include <unordered_set>
 #include <vector>
 #include "pal.h"
 #include "version.h"
 
+class dir_listing_cache_t;
+class string_pool_t;
+
+// A string which lives in a string_pool_t. It is only as big as a pointer and copying it
+// doesn't allocate, but it is only valid for as long as the pool which owns the string.
+class pooled_string_t
+{
+public:
+    pooled_string_t() : m_value(&s_empty) { }
+
+    operator const pal::string_t&() const { return *m_value; }
+    const pal::string_t& str() const { return *m_value; }
+    const pal::char_t* c_str() const { return m_value->c_str(); }
+    bool empty() const { return m_value->empty(); }
+    size_t length() const { return m_value->length(); }
+
+    bool operator==(const pooled_string_t& other) const { return m_value == other.m_value || *m_value == *other.m_value; }
+    bool operator!=(const pooled_string_t& other) const { return !(*this == other); }
+
+private:
+    friend class string_pool_t;
+
+    explicit pooled_string_t(const pal::string_t* value) : m_value(value) { }
+
+    static const pal::string_t s_empty;
+    const pal::string_t* m_value;
+};
+
+inline bool operator==(const pooled_string_t& left, const pal::string_t& right) { return left.str() == right; }
+inline bool operator==(const pal::string_t& left, const pooled_string_t& right) { return left == right.str(); }
+inline bool operator!=(const pooled_string_t& left, const pal::string_t& right) { return left.str() != right; }
+inline bool operator!=(const pal::string_t& left, const pooled_string_t& right) { return left != right.str(); }
+inline pal::string_t operator+(const pooled_string_t& left, const pal::char_t* right) { return left.str() + right; }
+inline pal::string_t operator+(const pal::string_t& left, const pooled_string_t& right) { return left + right.str(); }
+
+// Keeps a single copy of each string added to it. The strings never move, so the
+// pooled_string_t instances handed out stay valid until the pool is cleared or destroyed.
+class string_pool_t
+{
+public:
+    pooled_string_t add(const pal::string_t& value)
+    {
+        return pooled_string_t(&*m_strings.insert(value).first);
+    }
+
+    void clear() { m_strings.clear(); }
+    size_t size() const { return m_strings.size(); }
+
+private:
+    std::unordered_set<pal::string_t> m_strings;
+};
+
+// Identifies a package by its name and version. The hash is computed when the key is made, so
+// looking a key up in the package index of a deps file (see deps_json_t::has_package) neither
+// hashes the strings again nor allocates, even if the key comes from another deps file.
+struct package_key_t
+{
+    package_key_t() : hash(0) { }
+
+    package_key_t(const pooled_string_t& name, const pooled_string_t& version, size_t hash)
+        : name(name)
+        , version(version)
+        , hash(hash) { }
+
+    package_key_t(const pooled_string_t& name, const pooled_string_t& version)
+        : package_key_t(name, version, get_hash(name, version)) { }
+
+    bool operator==(const package_key_t& other) const
+    {
+        return hash == other.hash && name == other.name && version == other.version;
+    }
+
+    static size_t get_hash(const pal::string_t& name, const pal::string_t& version);
+
+    struct hasher
+    {
+        size_t operator()(const package_key_t& key) const { return key.hash; }
+    };
+
+    pooled_string_t name;
+    pooled_string_t version;
+    size_t hash;
+};
+
 struct deps_asset_t
 {
     deps_asset_t() : deps_asset_t(_X(""), _X(""), version_t(), version_t()) { }
@@ -39,30 +124,43 @@ struct deps_entry_t
 
     static const std::array<const pal::char_t*, deps_entry_t::asset_types::count> s_known_asset_types;
 
-    pal::string_t deps_file;
-    pal::string_t library_type;
-    pal::string_t library_name;
-    pal::string_t library_version;
-    pal::string_t library_hash;
-    pal::string_t library_path;
-    pal::string_t library_hash_path;
-    pal::string_t runtime_store_manifest_list;
+    // These are shared with the other entries from the same library or deps file, so they
+    // live in the string pool of the deps_json_t which owns the entry.
+    pooled_string_t deps_file;
+    pooled_string_t library_type;
+    pooled_string_t library_name;
+    pooled_string_t library_version;
+    pooled_string_t library_hash;
+    pooled_string_t library_path;
+    pooled_string_t library_hash_path;
+    pooled_string_t runtime_store_manifest_list;
+    size_t library_key_hash; // package_key_t::get_hash of the library name and version
     asset_types asset_type;
     deps_asset_t asset;
     bool is_serviceable;
     bool is_rid_specific;
 
+    // The methods below check whether the file exists through the dir_cache if it's specified.
+
     // Given a "base" dir, yield the filepath within this directory or relative to this directory based on "look_in_base"
-    bool to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str) const;
+    bool to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str, dir_listing_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the file path within this directory.
-    bool to_dir_path(const pal::string_t& base, pal::string_t* str) const;
+    bool to_dir_path(const pal::string_t& base, pal::string_t* str, dir_listing_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the relative path in the package layout.
-    bool to_rel_path(const pal::string_t& base, pal::string_t* str) const;
+    bool to_rel_path(const pal::string_t& base, pal::string_t* str, dir_listing_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the relative path with package name, version in the package layout.
-    bool to_full_path(const pal::string_t& root, pal::string_t* str) const;
+    bool to_full_path(const pal::string_t& root, pal::string_t* str, dir_listing_cache_t* dir_cache = nullptr) const;
+
+    package_key_t get_package_key() const
+    {
+        return package_key_t(library_name, library_version, library_key_hash);
+    }
+
+    // Moves the pooled strings of the entry to the given pool, which has to contain equal strings.
+    void move_to_pool(string_pool_t& pool);
 };
 
 #endif // __DEPS_ENTRY_H_
@@ -0,0 +1,483 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "deps_entry.h"
+#include "deps_format.h"
+#include "cache_io.h"
+#include "env_snapshot.h"
+#include "utils.h"
+#include "trace.h"
+#include <cassert>
+#include <set>
+
+// Binary cache of a loaded deps.json
+//
+// Loading a deps.json parses the whole JSON document and walks its targets, runtimeTargets
+// and libraries sections, even though the deps files of installed frameworks practically never
+// change. When enabled via DOTNET_DEPS_CACHE=1, the final state of deps_json_t is written to
+// a "<name>.deps.bin" file next to the deps.json, and subsequent loads read it back without
+// any JSON parsing.
+//
+// The cache file starts with a key which has to match exactly for the cache to be used. It covers
+// the path of the deps.json, the host RID, the host version and, for framework-dependent deps
+// files, the RID fallback list which was used to select the RID specific assets.
+// The key is followed by the size and last write time of the deps.json and a hash of its content.
+// If the size and time match, the cache is used without reading the deps.json at all. Otherwise
+// the content is hashed, so that a file which was only touched (or extracted from an archive which
+// restores an older time stamp) still uses the cache - which is then rewritten with the new stamp.
+// Then follow a string table and the entries, which refer to strings by index.
+
+namespace
+{
+    const uint32_t cache_magic = 0x53504544; // "DEPS"
+    const uint32_t cache_format_version = 4;
+
+    class string_table_t
+    {
+    public:
+        uint32_t add(const pal::string_t& str)
+        {
+            auto iter = m_indices.find(str);
+            if (iter != m_indices.end())
+            {
+                return iter->second;
+            }
+
+            uint32_t index = static_cast<uint32_t>(m_strings.size());
+            m_indices.emplace(str, index);
+            m_strings.push_back(str);
+            return index;
+        }
+
+        const std::vector<pal::string_t>& strings() const { return m_strings; }
+
+    private:
+        std::unordered_map<pal::string_t, uint32_t> m_indices;
+        std::vector<pal::string_t> m_strings;
+    };
+
+    bool read_string_index(cache_reader_t& reader, const std::vector<pal::string_t>& strings, pal::string_t* str)
+    {
+        uint32_t index;
+        if (!reader.read_value(&index) || index >= strings.size())
+        {
+            return false;
+        }
+
+        str->assign(strings[index]);
+        return true;
+    }
+
+    bool read_string_index(cache_reader_t& reader, const std::vector<pal::string_t>& strings, string_pool_t& pool, pooled_string_t* str)
+    {
+        uint32_t index;
+        if (!reader.read_value(&index) || index >= strings.size())
+        {
+            return false;
+        }
+
+        *str = pool.add(strings[index]);
+        return true;
+    }
+
+    void write_entry(cache_writer_t& writer, string_table_t& strings, const deps_entry_t& entry)
+    {
+        writer.write_value(strings.add(entry.deps_file));
+        writer.write_value(strings.add(entry.library_type));
+        writer.write_value(strings.add(entry.library_name));
+        writer.write_value(strings.add(entry.library_version));
+        writer.write_value(strings.add(entry.library_hash));
+        writer.write_value(strings.add(entry.library_path));
+        writer.write_value(strings.add(entry.library_hash_path));
+        writer.write_value(strings.add(entry.runtime_store_manifest_list));
+        writer.write_value(strings.add(entry.asset.name));
+        writer.write_value(strings.add(entry.asset.relative_path));
+        writer.write_version(entry.asset.assembly_version);
+        writer.write_version(entry.asset.file_version);
+        writer.write_value(static_cast<uint8_t>(entry.is_serviceable));
+        writer.write_value(static_cast<uint8_t>(entry.is_rid_specific));
+    }
+
+    bool read_entry(cache_reader_t& reader, const std::vector<pal::string_t>& strings, string_pool_t& pool, deps_entry_t::asset_types type, deps_entry_t* entry)
+    {
+        uint8_t is_serviceable, is_rid_specific;
+        if (!read_string_index(reader, strings, pool, &entry->deps_file)
+            || !read_string_index(reader, strings, pool, &entry->library_type)
+            || !read_string_index(reader, strings, pool, &entry->library_name)
+            || !read_string_index(reader, strings, pool, &entry->library_version)
+            || !read_string_index(reader, strings, pool, &entry->library_hash)
+            || !read_string_index(reader, strings, pool, &entry->library_path)
+            || !read_string_index(reader, strings, pool, &entry->library_hash_path)
+            || !read_string_index(reader, strings, pool, &entry->runtime_store_manifest_list)
+            || !read_string_index(reader, strings, &entry->asset.name)
+            || !read_string_index(reader, strings, &entry->asset.relative_path)
+            || !reader.read_version(&entry->asset.assembly_version)
+            || !reader.read_version(&entry->asset.file_version)
+            || !reader.read_value(&is_serviceable)
+            || !reader.read_value(&is_rid_specific))
+        {
+            return false;
+        }
+
+        entry->library_key_hash = package_key_t::get_hash(entry->library_name, entry->library_version);
+        entry->asset_type = type;
+        entry->is_serviceable = is_serviceable != 0;
+        entry->is_rid_specific = is_rid_specific != 0;
+        return true;
+    }
+
+    struct cache_contents_t
+    {
+        std::vector<deps_entry_t> entries[deps_entry_t::asset_types::count];
+        string_pool_t entry_strings;
+        std::unordered_map<pal::string_t, int> ni_entries;
+        std::vector<pal::string_t> packages;
+        deps_json_t::rid_fallback_graph_t rid_fallback_graph;
+    };
+
+    bool get_file_content_hash(const pal::string_t& path, const pal::file_stamp_t& stamp, uint64_t* hash)
+    {
+        if (stamp.size == 0)
+        {
+            *hash = get_content_hash(nullptr, 0);
+            return true;
+        }
+
+        size_t length = 0;
+        void* data = pal::map_file_readonly(path, length);
+        if (data == nullptr)
+        {
+            return false;
+        }
+
+        *hash = get_content_hash(data, length);
+        pal::unmap_file(data, length);
+        return true;
+    }
+
+    bool read_cache(
+        const char* data,
+        size_t size,
+        const std::vector<char>& key,
+        const pal::string_t& deps_path,
+        const pal::file_stamp_t& deps_stamp,
+        bool* stamp_outdated,
+        cache_contents_t* contents)
+    {
+        cache_reader_t reader(data, size);
+
+        uint32_t magic, format_version, key_size;
+        if (!reader.read_value(&magic) || magic != cache_magic
+            || !reader.read_value(&format_version) || format_version != cache_format_version
+            || !reader.read_value(&key_size) || key_size != key.size()
+            || !reader.match_bytes(key))
+        {
+            return false;
+        }
+
+        pal::file_stamp_t cached_stamp;
+        uint64_t cached_hash;
+        if (!reader.read_value(&cached_stamp.size)
+            || !reader.read_value(&cached_stamp.last_write_time)
+            || !reader.read_value(&cached_hash))
+        {
+            return false;
+        }
+
+        *stamp_outdated = cached_stamp != deps_stamp;
+        if (*stamp_outdated)
+        {
+            uint64_t content_hash;
+            if (cached_stamp.size != deps_stamp.size
+                || !get_file_content_hash(deps_path, deps_stamp, &content_hash)
+                || content_hash != cached_hash)
+            {
+                return false;
+            }
+
+            trace::verbose(_X("Deps file [%s] was touched, but its content is unchanged"), deps_path.c_str());
+        }
+
+        uint32_t count;
+        if (!reader.read_value(&count))
+        {
+            return false;
+        }
+
+        std::vector<pal::string_t> strings(count);
+        for (auto& str : strings)
+        {
+            if (!reader.read_string(&str))
+            {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            if (!reader.read_value(&count))
+            {
+                return false;
+            }
+
+            auto& entries = contents->entries[i];
+            entries.resize(count);
+            for (auto& entry : entries)
+            {
+                if (!read_entry(reader, strings, contents->entry_strings, static_cast<deps_entry_t::asset_types>(i), &entry))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (!reader.read_value(&count))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pal::string_t name;
+            int32_t index;
+            if (!read_string_index(reader, strings, &name)
+                || !reader.read_value(&index)
+                || index < 0 || static_cast<size_t>(index) >= contents->entries[deps_entry_t::asset_types::runtime].size())
+            {
+                return false;
+            }
+
+            contents->ni_entries[name] = index;
+        }
+
+        if (!reader.read_value(&count))
+        {
+            return false;
+        }
+
+        contents->packages.resize(count);
+        for (auto& package : contents->packages)
+        {
+            if (!read_string_index(reader, strings, &package))
+            {
+                return false;
+            }
+        }
+
+        if (!reader.read_value(&count))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pal::string_t rid;
+            uint32_t fallback_count;
+            if (!read_string_index(reader, strings, &rid) || !reader.read_value(&fallback_count))
+            {
+                return false;
+            }
+
+            auto& fallbacks = contents->rid_fallback_graph[rid];
+            fallbacks.resize(fallback_count);
+            for (auto& fallback : fallbacks)
+            {
+                if (!read_string_index(reader, strings, &fallback))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return reader.at_end();
+    }
+}
+
+bool deps_json_t::is_cache_enabled()
+{
+    return env_snapshot::is_enabled(env_key_t::DOTNET_DEPS_CACHE);
+}
+
+pal::string_t deps_json_t::get_cache_path(const pal::string_t& deps_path)
+{
+    pal::string_t cache_path = deps_path;
+    if (ends_with(cache_path, _X(".json"), false))
+    {
+        cache_path.resize(cache_path.length() - (sizeof(".json") - 1));
+    }
+
+    cache_path.append(_X(".bin"));
+    return cache_path;
+}
+
+bool deps_json_t::get_cache_key(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph, std::vector<char>* key)
+{
+    cache_writer_t writer(key);
+    writer.write_value(static_cast<uint32_t>(sizeof(pal::char_t)));
+    writer.write_string(deps_path);
+    writer.write_value(static_cast<uint8_t>(is_framework_dependent));
+    writer.write_string(get_current_runtime_id(false /*use_fallback*/));
+    writer.write_string(_STRINGIFY(HOST_POLICY_PKG_VER) _X("+") _STRINGIFY(REPO_COMMIT_HASH));
+    writer.write_value(static_cast<uint8_t>(m_rid_fallback_graph_mode));
+
+    if (is_framework_dependent)
+    {
+        // RID specific assets are selected based on the host RID fallbacks from the root framework's graph
+        pal::string_t host_rid = get_current_rid(rid_fallback_graph);
+        writer.write_string(host_rid);
+
+        auto iter = rid_fallback_graph.find(host_rid);
+        if (iter == rid_fallback_graph.end())
+        {
+            writer.write_value(static_cast<uint8_t>(0));
+        }
+        else
+        {
+            writer.write_value(static_cast<uint8_t>(1));
+            writer.write_value(static_cast<uint32_t>(iter->second.size()));
+            for (const auto& fallback : iter->second)
+            {
+                writer.write_string(fallback);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool deps_json_t::load_cache(const pal::string_t& cache_path, const std::vector<char>& key, const pal::file_stamp_t& deps_stamp, bool* stamp_outdated)
+{
+    if (!pal::file_exists(cache_path))
+    {
+        trace::verbose(_X("Deps cache [%s] does not exist"), cache_path.c_str());
+        return false;
+    }
+
+    size_t length = 0;
+    void* data = pal::map_file_readonly(cache_path, length);
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    cache_contents_t contents;
+    bool loaded = read_cache(static_cast<const char*>(data), length, key, m_deps_file, deps_stamp, stamp_outdated, &contents);
+    pal::unmap_file(data, length);
+
+    if (!loaded)
+    {
+        trace::verbose(_X("Deps cache [%s] is stale or invalid"), cache_path.c_str());
+        return false;
+    }
+
+    // Moving the pool keeps the strings the entries point to in place.
+    m_deps_entries.strings = std::move(contents.entry_strings);
+    for (size_t i = 0; i < deps_entry_t::asset_types::count; ++i)
+    {
+        m_deps_entries[i] = std::move(contents.entries[i]);
+    }
+
+    m_ni_entries = std::move(contents.ni_entries);
+    m_rid_fallback_graph = std::move(contents.rid_fallback_graph);
+
+    for (const auto& package : contents.packages)
+    {
+        add_package(package);
+    }
+
+    return true;
+}
+
+void deps_json_t::save_cache(const pal::string_t& cache_path, const std::vector<char>& key, const pal::file_stamp_t& deps_stamp) const
+{
+    // The hash has to describe the content which was loaded, so the cache is not written
+    // if the deps.json changed since its stamp was taken.
+    uint64_t content_hash;
+    pal::file_stamp_t current_stamp;
+    if (!get_file_content_hash(m_deps_file, deps_stamp, &content_hash)
+        || !pal::get_file_stamp(m_deps_file, &current_stamp)
+        || current_stamp != deps_stamp)
+    {
+        trace::verbose(_X("Could not write deps cache [%s]"), cache_path.c_str());
+        return;
+    }
+
+    std::vector<char> body;
+    cache_writer_t writer(&body);
+    string_table_t strings;
+
+    for (size_t i = 0; i < deps_entry_t::asset_types::count; ++i)
+    {
+        writer.write_value(static_cast<uint32_t>(m_deps_entries[i].size()));
+        for (const auto& entry : m_deps_entries[i])
+        {
+            write_entry(writer, strings, entry);
+        }
+    }
+
+    writer.write_value(static_cast<uint32_t>(m_ni_entries.size()));
+    for (const auto& ni_entry : m_ni_entries)
+    {
+        writer.write_value(strings.add(ni_entry.first));
+        writer.write_value(static_cast<int32_t>(ni_entry.second));
+    }
+
+    // has_package only checks for the presence of a package with assets, so only the package index is cached
+    std::set<pal::string_t> packages;
+    for (const auto& package : m_deps_entries.packages)
+    {
+        packages.insert(package.name + _X("/") + package.version);
+    }
+
+    writer.write_value(static_cast<uint32_t>(packages.size()));
+    for (const auto& package : packages)
+    {
+        writer.write_value(strings.add(package));
+    }
+
+    writer.write_value(static_cast<uint32_t>(m_rid_fallback_graph.size()));
+    for (const auto& rid : m_rid_fallback_graph)
+    {
+        writer.write_value(strings.add(rid.first));
+        writer.write_value(static_cast<uint32_t>(rid.second.size()));
+        for (const auto& fallback : rid.second)
+        {
+            writer.write_value(strings.add(fallback));
+        }
+    }
+
+    std::vector<char> buffer;
+    cache_writer_t header(&buffer);
+    header.write_value(cache_magic);
+    header.write_value(cache_format_version);
+    header.write_value(static_cast<uint32_t>(key.size()));
+    buffer.insert(buffer.end(), key.begin(), key.end());
+    header.write_value(deps_stamp.size);
+    header.write_value(deps_stamp.last_write_time);
+    header.write_value(content_hash);
+    header.write_value(static_cast<uint32_t>(strings.strings().size()));
+    for (const auto& str : strings.strings())
+    {
+        header.write_string(str);
+    }
+
+    buffer.insert(buffer.end(), body.begin(), body.end());
+
+    // The cache is validated by the stamp alone, so a change of the deps.json within the time stamp
+    // granularity of the file system has to be ruled out.
+    switch (write_cache_file(cache_path, buffer, std::vector<pal::file_stamp_t>{ deps_stamp }))
+    {
+    case cache_write_status::create_failed:
+        trace::verbose(_X("Could not create deps cache [%s]"), cache_path.c_str());
+        return;
+    case cache_write_status::write_failed:
+    case cache_write_status::inputs_too_recent:
+        trace::verbose(_X("Could not write deps cache [%s]"), cache_path.c_str());
+        return;
+    case cache_write_status::written:
+        break;
+    }
+
+    trace::verbose(_X("Wrote deps cache [%s]"), cache_path.c_str());
+}
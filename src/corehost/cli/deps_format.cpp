@@ -11,11 +11,65 @@
 #include <iterator>
 #include <cassert>
 #include <functional>
+#include <algorithm>
 
 const std::array<const pal::char_t*, deps_entry_t::asset_types::count> deps_entry_t::s_known_asset_types = {{
     _X("runtime"), _X("resources"), _X("native")
 }};
 
+namespace
+{
+    // Ranks of the RIDs whose assets can be used on the host: 0 for the host RID, and then the
+    // position in its fallback list. The assets of the lowest ranked RID are picked.
+    struct rid_ranks_t
+    {
+        pal::string_t host_rid;
+        bool has_fallbacks;
+        std::vector<pal::string_t> fallback_rids;
+        std::unordered_map<pal::string_t, size_t> ranks;
+    };
+
+    // All of the deps files loaded in the process use the same host RID and almost always the same fallback
+    // graph, so the ranks are only recomputed when the host RID's fallback list is different.
+    pal::mutex_t g_rid_ranks_lock;
+    std::shared_ptr<const rid_ranks_t> g_rid_ranks;
+
+    std::shared_ptr<const rid_ranks_t> get_rid_ranks(const pal::string_t& host_rid, const deps_json_t::rid_fallback_graph_t& rid_fallback_graph)
+    {
+        auto fallback_iter = rid_fallback_graph.find(host_rid);
+        bool has_fallbacks = fallback_iter != rid_fallback_graph.end();
+
+        {
+            std::lock_guard<pal::mutex_t> lock(g_rid_ranks_lock);
+            if (g_rid_ranks != nullptr
+                && g_rid_ranks->host_rid == host_rid
+                && g_rid_ranks->has_fallbacks == has_fallbacks
+                && (!has_fallbacks || g_rid_ranks->fallback_rids == fallback_iter->second))
+            {
+                return g_rid_ranks;
+            }
+        }
+
+        std::shared_ptr<rid_ranks_t> rid_ranks = std::make_shared<rid_ranks_t>();
+        rid_ranks->host_rid = host_rid;
+        rid_ranks->has_fallbacks = has_fallbacks;
+        rid_ranks->ranks.emplace(host_rid, 0);
+        if (has_fallbacks)
+        {
+            rid_ranks->fallback_rids = fallback_iter->second;
+            for (size_t i = 0; i < rid_ranks->fallback_rids.size(); ++i)
+            {
+                // The first occurrence of a RID wins, as with a search of the list
+                rid_ranks->ranks.emplace(rid_ranks->fallback_rids[i], i + 1);
+            }
+        }
+
+        std::lock_guard<pal::mutex_t> lock(g_rid_ranks_lock);
+        g_rid_ranks = rid_ranks;
+        return rid_ranks;
+    }
+}
+
 const deps_entry_t& deps_json_t::try_ni(const deps_entry_t& entry) const
 {
     if (m_ni_entries.count(entry.asset.name))
@@ -48,84 +102,180 @@ pal::string_t deps_json_t::get_optional_path(
     return path;
 }
 
-void deps_json_t::reconcile_libraries_with_targets(
-    const pal::string_t& deps_path,
-    const json_parser_t::value_t& json,
-    const std::function<bool(const pal::string_t&)>& library_exists_fn,
-    const std::function<const vec_asset_t&(const pal::string_t&, int, bool*)>& get_assets_fn)
+deps_asset_t deps_json_t::create_asset(
+    const pal::string_t& file_name,
+    const pal::string_t& assembly_version_str,
+    const pal::string_t& file_version_str)
 {
-    pal::string_t deps_file = get_filename(deps_path);
+    version_t assembly_version, file_version;
 
-    for (const auto& library : json[_X("libraries")].GetObject())
+    if (!assembly_version_str.empty())
+    {
+        version_t::parse(assembly_version_str, &assembly_version);
+    }
+
+    if (!file_version_str.empty())
     {
-        trace::info(_X("Reconciling library %s"), library.name.GetString());
+        version_t::parse(file_version_str, &file_version);
+    }
 
-        pal::string_t lib_name{library.name.GetString()};
-        if (!library_exists_fn(lib_name))
+    return deps_asset_t(get_filename_without_ext(file_name), file_name, assembly_version, file_version);
+}
+
+void deps_json_t::add_asset(deps_assets_t* p_assets, const pal::string_t& package, size_t asset_type_index, const deps_asset_t& asset)
+{
+    TRACE_INFO(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
+        deps_entry_t::s_known_asset_types[asset_type_index],
+        asset.relative_path.c_str(),
+        asset.assembly_version.as_str().c_str(),
+        asset.file_version.as_str().c_str(),
+        package.c_str());
+
+    p_assets->libs[package][asset_type_index].push_back(asset);
+}
+
+void deps_json_t::add_rid_asset(rid_specific_assets_t* p_assets, const pal::string_t& package, size_t asset_type_index, const pal::string_t& rid, const deps_asset_t& asset)
+{
+    TRACE_INFO(_X("Adding runtimeTargets %s asset %s rid=%s assemblyVersion=%s fileVersion=%s from %s"),
+        deps_entry_t::s_known_asset_types[asset_type_index],
+        asset.relative_path.c_str(),
+        rid.c_str(),
+        asset.assembly_version.as_str().c_str(),
+        asset.file_version.as_str().c_str(),
+        package.c_str());
+
+    p_assets->libs[package][asset_type_index].rid_assets[rid].push_back(asset);
+}
+
+bool deps_json_t::library_exists(const pal::string_t& package) const
+{
+    // Only framework dependent apps have rid specific assets
+    return m_rid_assets.libs.count(package) || m_assets.libs.count(package);
+}
+
+const deps_json_t::vec_asset_t& deps_json_t::get_library_assets(const pal::string_t& package, size_t asset_type_index, bool* rid_specific) const
+{
+    static const vec_asset_t empty;
+
+    *rid_specific = false;
+
+    // Is there any rid specific assets for this type ("native" or "runtime" or "resources")
+    auto rid_iter = m_rid_assets.libs.find(package);
+    if (rid_iter != m_rid_assets.libs.end() && !rid_iter->second[asset_type_index].rid_assets.empty())
+    {
+        const auto& assets_for_type = rid_iter->second[asset_type_index].rid_assets.begin()->second;
+        if (!assets_for_type.empty())
         {
-            trace::info(_X("Library %s does not exist"), library.name.GetString());
-            continue;
+            *rid_specific = true;
+            return assets_for_type;
         }
 
-        const pal::string_t& hash = library.value[_X("sha512")].GetString();
-        bool serviceable = library.value[_X("serviceable")].GetBool();
+        TRACE_VERBOSE(_X("There were no rid specific %s asset for %s"), deps_entry_t::s_known_asset_types[asset_type_index], package.c_str());
+    }
+
+    auto iter = m_assets.libs.find(package);
+    if (iter != m_assets.libs.end())
+    {
+        return iter->second[asset_type_index];
+    }
 
-        pal::string_t library_path = get_optional_path(library.value, _X("path"));
-        pal::string_t library_hash_path = get_optional_path(library.value, _X("hashPath"));
-        pal::string_t runtime_store_manifest_list = get_optional_path(library.value, _X("runtimeStoreManifestName"));
+    return empty;
+}
 
-        for (size_t i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+void deps_json_t::add_library_entries(const pal::string_t& deps_file, const library_t& library)
+{
+    size_t pos = library.name.find(_X("/"));
+    string_pool_t& strings = m_deps_entries.strings;
+    pooled_string_t library_name = strings.add(library.name.substr(0, pos));
+    pooled_string_t library_version = strings.add(library.name.substr(pos + 1));
+    pooled_string_t library_type = strings.add(pal::to_lower(library.type));
+    pooled_string_t library_hash = strings.add(library.hash);
+    pooled_string_t library_path = strings.add(library.path);
+    pooled_string_t library_hash_path = strings.add(library.hash_path);
+    pooled_string_t runtime_store_manifest_list = strings.add(library.runtime_store_manifest_list);
+    pooled_string_t pooled_deps_file = strings.add(deps_file);
+    size_t library_key_hash = package_key_t::get_hash(library_name, library_version);
+
+    for (size_t i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+    {
+        bool rid_specific = false;
+        for (const auto& asset : get_library_assets(library.name, i, &rid_specific))
         {
-            bool rid_specific = false;
-            for (const auto& asset : get_assets_fn(library.name.GetString(), i, &rid_specific))
+            bool ni_dll = false;
+            auto asset_name = asset.name;
+            if (ends_with(asset_name, _X(".ni"), false))
             {
-                bool ni_dll = false;
-                auto asset_name = asset.name;
-                if (ends_with(asset_name, _X(".ni"), false))
-                {
-                    ni_dll = true;
-                    asset_name = strip_file_ext(asset_name);
-                }
-
-                deps_entry_t entry;
-                size_t pos = lib_name.find(_X("/"));
-                entry.library_name = lib_name.substr(0, pos);
-                entry.library_version = lib_name.substr(pos + 1);
-                entry.library_type = pal::to_lower(library.value[_X("type")].GetString());
-                entry.library_hash = hash;
-                entry.library_path = library_path;
-                entry.library_hash_path = library_hash_path;
-                entry.runtime_store_manifest_list = runtime_store_manifest_list;
-                entry.asset_type = static_cast<deps_entry_t::asset_types>(i);
-                entry.is_serviceable = serviceable;
-                entry.is_rid_specific = rid_specific;
-                entry.deps_file = deps_file;
-                entry.asset = asset;
-                entry.asset.name = asset_name;
-
-                m_deps_entries[i].push_back(entry);
-
-                if (ni_dll)
-                {
-                    m_ni_entries[entry.asset.name] = m_deps_entries
-                        [deps_entry_t::asset_types::runtime].size() - 1;
-                }
+                ni_dll = true;
+                asset_name = strip_file_ext(asset_name);
+            }
 
-                trace::info(_X("Parsed %s deps entry %d for asset name: %s from %s: %s, library version: %s, relpath: %s, assemblyVersion %s, fileVersion %s"),
-                    deps_entry_t::s_known_asset_types[i],
-                    m_deps_entries[i].size() - 1,
-                    entry.asset.name.c_str(),
-                    entry.library_type.c_str(),
-                    entry.library_name.c_str(),
-                    entry.library_version.c_str(),
-                    entry.asset.relative_path.c_str(),
-                    entry.asset.assembly_version.as_str().c_str(),
-                    entry.asset.file_version.as_str().c_str());
+            deps_entry_t entry;
+            entry.library_name = library_name;
+            entry.library_version = library_version;
+            entry.library_key_hash = library_key_hash;
+            entry.library_type = library_type;
+            entry.library_hash = library_hash;
+            entry.library_path = library_path;
+            entry.library_hash_path = library_hash_path;
+            entry.runtime_store_manifest_list = runtime_store_manifest_list;
+            entry.asset_type = static_cast<deps_entry_t::asset_types>(i);
+            entry.is_serviceable = library.serviceable;
+            entry.is_rid_specific = rid_specific;
+            entry.deps_file = pooled_deps_file;
+            entry.asset = asset;
+            entry.asset.name = asset_name;
+
+            m_deps_entries[i].push_back(entry);
+
+            if (ni_dll)
+            {
+                m_ni_entries[entry.asset.name] = m_deps_entries
+                    [deps_entry_t::asset_types::runtime].size() - 1;
             }
+
+            TRACE_INFO(_X("Parsed %s deps entry %d for asset name: %s from %s: %s, library version: %s, relpath: %s, assemblyVersion %s, fileVersion %s"),
+                deps_entry_t::s_known_asset_types[i],
+                m_deps_entries[i].size() - 1,
+                entry.asset.name.c_str(),
+                entry.library_type.c_str(),
+                entry.library_name.c_str(),
+                entry.library_version.c_str(),
+                entry.asset.relative_path.c_str(),
+                entry.asset.assembly_version.as_str().c_str(),
+                entry.asset.file_version.as_str().c_str());
         }
     }
 }
 
+void deps_json_t::reconcile_libraries_with_targets(
+    const pal::string_t& deps_path,
+    const json_parser_t::value_t& json)
+{
+    pal::string_t deps_file = get_filename(deps_path);
+
+    for (const auto& library : json[_X("libraries")].GetObject())
+    {
+        TRACE_INFO(_X("Reconciling library %s"), library.name.GetString());
+
+        library_t lib;
+        lib.name = library.name.GetString();
+        if (!library_exists(lib.name))
+        {
+            TRACE_INFO(_X("Library %s does not exist"), library.name.GetString());
+            continue;
+        }
+
+        lib.type = library.value[_X("type")].GetString();
+        lib.hash = library.value[_X("sha512")].GetString();
+        lib.serviceable = library.value[_X("serviceable")].GetBool();
+        lib.path = get_optional_path(library.value, _X("path"));
+        lib.hash_path = get_optional_path(library.value, _X("hashPath"));
+        lib.runtime_store_manifest_list = get_optional_path(library.value, _X("runtimeStoreManifestName"));
+
+        add_library_entries(deps_file, lib);
+    }
+}
+
 // Returns the RID determined (computed or fallback) for the platform the host is running on.
 pal::string_t deps_json_t::get_current_rid(const rid_fallback_graph_t& rid_fallback_graph)
 {
@@ -148,48 +298,72 @@ pal::string_t deps_json_t::get_current_rid(const rid_fallback_graph_t& rid_fallb
     return currentRid;
 }
 
+// Returns the RIDs get_current_rid can return, whose entries are the only ones of the RID fallback graph it consults.
+std::vector<pal::string_t> deps_json_t::get_host_rid_candidates()
+{
+    std::vector<pal::string_t> rids;
+
+    pal::string_t current_rid = get_current_runtime_id(false /*use_fallback*/);
+    if (!current_rid.empty())
+    {
+        rids.push_back(current_rid);
+    }
+
+    pal::string_t base_rid = pal::get_current_os_fallback_rid() + pal::string_t(_X("-")) + get_arch();
+    if (base_rid != current_rid)
+    {
+        rids.push_back(base_rid);
+    }
+
+    return rids;
+}
+
+bool deps_json_t::is_rid_fallback_graph_entry_needed(const pal::string_t& rid, const std::vector<pal::string_t>& host_rid_candidates) const
+{
+    return m_rid_fallback_graph_mode == rid_fallback_graph_mode_t::full
+        || std::find(host_rid_candidates.begin(), host_rid_candidates.end(), rid) != host_rid_candidates.end();
+}
+
 bool deps_json_t::perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph)
 {
     pal::string_t host_rid = get_current_rid(rid_fallback_graph);
-    
+    std::shared_ptr<const rid_ranks_t> rid_ranks = get_rid_ranks(host_rid, rid_fallback_graph);
+
     for (auto& package : portable_assets->libs)
     {
         for (size_t asset_type_index = 0; asset_type_index < deps_entry_t::asset_types::count; asset_type_index++)
         {
             auto& rid_assets = package.second[asset_type_index].rid_assets;
-            pal::string_t matched_rid = rid_assets.count(host_rid) ? host_rid : _X("");
-            if (matched_rid.empty())
+            if (!rid_ranks->has_fallbacks && rid_assets.count(host_rid) == 0)
             {
-                auto rid_fallback_iter = rid_fallback_graph.find(host_rid);
-                if (rid_fallback_iter == rid_fallback_graph.end())
-                {
-                    trace::warning(_X("The targeted framework does not support the runtime '%s'. Some native libraries from [%s] may fail to load on this platform."), host_rid.c_str(), package.first.c_str());
-                }
-                else
+                trace::warning(_X("The targeted framework does not support the runtime '%s'. Some native libraries from [%s] may fail to load on this platform."), host_rid.c_str(), package.first.c_str());
+            }
+
+            // Pick the lowest ranked RID of the package in a single pass over its RIDs
+            const pal::string_t* matched_rid = nullptr;
+            size_t matched_rank = 0;
+            for (const auto& rid_asset : rid_assets)
+            {
+                auto rank = rid_ranks->ranks.find(rid_asset.first);
+                if (rank != rid_ranks->ranks.end() && (matched_rid == nullptr || rank->second < matched_rank))
                 {
-                    const auto& fallback_rids = rid_fallback_iter->second;
-                    auto iter = std::find_if(fallback_rids.begin(), fallback_rids.end(), [&rid_assets](const pal::string_t& rid) {
-                        return rid_assets.count(rid);
-                        });
-                    if (iter != fallback_rids.end())
-                    {
-                        matched_rid = *iter;
-                    }
+                    matched_rid = &rid_asset.first;
+                    matched_rank = rank->second;
                 }
             }
 
-            if (matched_rid.empty())
+            if (matched_rid == nullptr)
             {
                 rid_assets.clear();
             }
 
             for (auto iter = rid_assets.begin(); iter != rid_assets.end(); /* */)
             {
-                if (iter->first != matched_rid)
+                if (&iter->first != matched_rid)
                 {
-                    trace::verbose(
+                    TRACE_VERBOSE(
                         _X("Chose %s, so removing rid (%s) specific assets for package %s and asset type %s"),
-                        matched_rid.c_str(),
+                        matched_rid->c_str(),
                         iter->first.c_str(),
                         package.first.c_str(),
                         deps_entry_t::s_known_asset_types[asset_type_index]);
@@ -228,34 +402,12 @@ bool deps_json_t::process_runtime_targets(const json_parser_t::value_t& json, co
                     continue;
                 }
 
-                version_t assembly_version, file_version;
-
-                const pal::string_t& assembly_version_str = get_optional_property(file.value, _X("assemblyVersion"));
-                if (!assembly_version_str.empty())
-                {
-                    version_t::parse(assembly_version_str, &assembly_version);
-                }
-
-                const pal::string_t& file_version_str = get_optional_property(file.value, _X("fileVersion"));
-                if (!file_version_str.empty())
-                {
-                    version_t::parse(file_version_str, &file_version);
-                }
-
-                pal::string_t file_name{file.name.GetString()};
-                deps_asset_t asset(get_filename_without_ext(file_name), file_name, assembly_version, file_version);
+                deps_asset_t asset = create_asset(
+                    file.name.GetString(),
+                    get_optional_property(file.value, _X("assemblyVersion")),
+                    get_optional_property(file.value, _X("fileVersion")));
 
-                const auto& rid = file.value[_X("rid")].GetString();
-
-                trace::info(_X("Adding runtimeTargets %s asset %s rid=%s assemblyVersion=%s fileVersion=%s from %s"),
-                    deps_entry_t::s_known_asset_types[asset_type_index],
-                    asset.relative_path.c_str(),
-                    rid,
-                    asset.assembly_version.as_str().c_str(),
-                    asset.file_version.as_str().c_str(),
-                    package.name.GetString());
-
-                assets.libs[package.name.GetString()][asset_type_index].rid_assets[rid].push_back(asset);
+                add_rid_asset(&assets, package.name.GetString(), asset_type_index, file.value[_X("rid")].GetString(), asset);
             }
         }
     }
@@ -284,31 +436,12 @@ bool deps_json_t::process_targets(const json_parser_t::value_t& json, const pal:
 
             for (const auto& file : iter->value.GetObject())
             {
-                version_t assembly_version, file_version;
-
-                const pal::string_t& assembly_version_str = get_optional_property(file.value, _X("assemblyVersion"));
-                if (assembly_version_str.length() > 0)
-                {
-                    version_t::parse(assembly_version_str, &assembly_version);
-                }
-
-                const pal::string_t& file_version_str = get_optional_property(file.value, _X("fileVersion"));
-                if (file_version_str.length() > 0)
-                {
-                    version_t::parse(file_version_str, &file_version);
-                }
-
-                pal::string_t file_name{file.name.GetString()};
-                deps_asset_t asset(get_filename_without_ext(file_name), file_name, assembly_version, file_version);
+                deps_asset_t asset = create_asset(
+                    file.name.GetString(),
+                    get_optional_property(file.value, _X("assemblyVersion")),
+                    get_optional_property(file.value, _X("fileVersion")));
 
-                trace::info(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
-                    deps_entry_t::s_known_asset_types[i],
-                    asset.relative_path.c_str(),
-                    asset.assembly_version.as_str().c_str(),
-                    asset.file_version.as_str().c_str(),
-                    package.name.GetString());
-
-                assets.libs[package.name.GetString()][i].push_back(asset);
+                add_asset(&assets, package.name.GetString(), i, asset);
             }
         }
     }
@@ -327,37 +460,7 @@ bool deps_json_t::load_framework_dependent(const pal::string_t& deps_path, const
         return false;
     }
 
-    auto package_exists = [&](const pal::string_t& package) -> bool {
-        return m_rid_assets.libs.count(package) || m_assets.libs.count(package);
-    };
-
-    const vec_asset_t empty;
-    auto get_relpaths = [&](const pal::string_t& package, int asset_type_index, bool* rid_specific) -> const vec_asset_t& {
-
-        *rid_specific = false;
-
-        // Is there any rid specific assets for this type ("native" or "runtime" or "resources")
-        if (m_rid_assets.libs.count(package) && !m_rid_assets.libs[package][asset_type_index].rid_assets.empty())
-        {
-            const auto& assets_for_type = m_rid_assets.libs[package][asset_type_index].rid_assets.begin()->second;
-            if (!assets_for_type.empty())
-            {
-                *rid_specific = true;
-                return assets_for_type;
-            }
-
-            trace::verbose(_X("There were no rid specific %s asset for %s"), deps_entry_t::s_known_asset_types[asset_type_index], package.c_str());
-        }
-
-        if (m_assets.libs.count(package))
-        {
-            return m_assets.libs[package][asset_type_index];
-        }
-
-        return empty;
-    };
-
-    reconcile_libraries_with_targets(deps_path, json, package_exists, get_relpaths);
+    reconcile_libraries_with_targets(deps_path, json);
 
     return true;
 }
@@ -369,22 +472,19 @@ bool deps_json_t::load_self_contained(const pal::string_t& deps_path, const json
         return false;
     }
 
-    auto package_exists = [&](const pal::string_t& package) -> bool {
-        return m_assets.libs.count(package);
-    };
-
-    auto get_relpaths = [&](const pal::string_t& package, int type_index, bool* rid_specific) -> const vec_asset_t& {
-        *rid_specific = false;
-        return m_assets.libs[package][type_index];
-    };
-
-    reconcile_libraries_with_targets(deps_path, json, package_exists, get_relpaths);
+    reconcile_libraries_with_targets(deps_path, json);
 
     const auto& json_object = json.GetObject();
     if (json_object.HasMember(_X("runtimes")))
     {
+        std::vector<pal::string_t> host_rid_candidates = get_host_rid_candidates();
         for (const auto& rid : json[_X("runtimes")].GetObject())
         {
+            if (!is_rid_fallback_graph_entry_needed(rid.name.GetString(), host_rid_candidates))
+            {
+                continue;
+            }
+
             auto& vec = m_rid_fallback_graph[rid.name.GetString()];
             for (const auto& fallback : rid.value.GetArray())
             {
@@ -393,9 +493,16 @@ bool deps_json_t::load_self_contained(const pal::string_t& deps_path, const json
         }
     }
 
+    trace_rid_fallback_graph();
+    return true;
+}
+
+void deps_json_t::trace_rid_fallback_graph() const
+{
     if (trace::is_enabled())
     {
-        trace::verbose(_X("The rid fallback graph is: {"));
+        trace::verbose(_X("The rid fallback graph%s is: {"),
+            m_rid_fallback_graph_mode == rid_fallback_graph_mode_t::full ? _X("") : _X(" (host RID entries only)"));
         for (const auto& rid : m_rid_fallback_graph)
         {
             trace::verbose(_X("%s => ["), rid.first.c_str());
@@ -407,28 +514,102 @@ bool deps_json_t::load_self_contained(const pal::string_t& deps_path, const json
         }
         trace::verbose(_X("}"));
     }
-    return true;
 }
 
-bool deps_json_t::has_package(const pal::string_t& name, const pal::string_t& ver) const
+const pal::char_t* deps_json_t::get_layout_id()
+{
+    // Modules built from the same sources with the same standard library agree on the layout
+    static const pal::string_t layout_id =
+        pal::string_t(_STRINGIFY(HOST_POLICY_PKG_VER) _X("+") _STRINGIFY(REPO_COMMIT_HASH))
+        + _X("/") + pal::to_string(static_cast<int>(sizeof(deps_json_t)))
+        + _X("/") + pal::to_string(static_cast<int>(sizeof(deps_entry_t)))
+        + _X("/") + pal::to_string(static_cast<int>(sizeof(pal::string_t)));
+
+    return layout_id.c_str();
+}
+
+void deps_json_t::add_package(const pal::string_t& package)
 {
-    pal::string_t pv = name;
-    pv.push_back(_X('/'));
-    pv.append(ver);
-    
-    auto iter = m_rid_assets.libs.find(pv);
-    if (iter != m_rid_assets.libs.end())
+    size_t pos = package.find(_X('/'));
+    if (pos == pal::string_t::npos)
+    {
+        return;
+    }
+
+    string_pool_t& strings = m_deps_entries.strings;
+    m_deps_entries.packages.insert(package_key_t(strings.add(package.substr(0, pos)), strings.add(package.substr(pos + 1))));
+}
+
+// Indexes the packages which have any assets, which is all has_package needs once the deps file
+// is loaded. The assets themselves are only needed to create the entries, so they are released.
+void deps_json_t::build_package_index()
+{
+    for (const auto& package : m_assets.libs)
+    {
+        add_package(package.first);
+    }
+
+    for (const auto& package : m_rid_assets.libs)
     {
         for (size_t asset_type_index = 0; asset_type_index < deps_entry_t::asset_types::count; asset_type_index++)
         {
-            if (!iter->second[asset_type_index].rid_assets.empty())
+            if (!package.second[asset_type_index].rid_assets.empty())
             {
-                return true;
+                add_package(package.first);
+                break;
             }
         }
     }
-    
-    return m_assets.libs.count(pv);
+
+    m_assets.libs.clear();
+    m_rid_assets.libs.clear();
+}
+
+deps_json_t::entry_store_t::entry_store_t(const entry_store_t& other)
+{
+    *this = other;
+}
+
+deps_json_t::entry_store_t& deps_json_t::entry_store_t::operator=(const entry_store_t& other)
+{
+    strings = other.strings;
+    for (size_t i = 0; i < deps_entry_t::asset_types::count; ++i)
+    {
+        entries[i] = other.entries[i];
+        for (auto& entry : entries[i])
+        {
+            entry.move_to_pool(strings);
+        }
+    }
+
+    packages.clear();
+    for (const auto& package : other.packages)
+    {
+        packages.insert(package_key_t(strings.add(package.name), strings.add(package.version), package.hash));
+    }
+
+    return *this;
+}
+
+void deps_json_t::entry_store_t::clear()
+{
+    for (auto& entries_for_type : entries)
+    {
+        entries_for_type.clear();
+    }
+
+    packages.clear();
+    strings.clear();
+}
+
+void deps_json_t::clear()
+{
+    m_deps_entries.clear();
+
+    m_assets.libs.clear();
+    m_rid_assets.libs.clear();
+    m_ni_entries.clear();
+    m_rid_fallback_graph.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -447,21 +628,61 @@ bool deps_json_t::load(bool is_framework_dependent, const pal::string_t& deps_pa
         return true;
     }
 
-    json_parser_t json;
-    if (!json.parse_file(deps_path))
+    std::vector<char> cache_key;
+    pal::string_t cache_path;
+    pal::file_stamp_t deps_stamp;
+    bool use_cache = is_cache_enabled()
+        && pal::get_file_stamp(deps_path, &deps_stamp)
+        && get_cache_key(is_framework_dependent, deps_path, rid_fallback_graph, &cache_key);
+    if (use_cache)
     {
-        return false;
-    }
+        cache_path = get_cache_path(deps_path);
+        bool stamp_outdated = false;
+        if (load_cache(cache_path, cache_key, deps_stamp, &stamp_outdated))
+        {
+            trace::verbose(_X("Loaded deps file... %s from cache [%s]"), deps_path.c_str(), cache_path.c_str());
+
+            // The content didn't change, only the time stamp did. Record the new one so that
+            // the next load doesn't have to hash the file again.
+            if (stamp_outdated)
+            {
+                save_cache(cache_path, cache_key, deps_stamp);
+            }
 
-    const auto& runtime_target = json.document()[_X("runtimeTarget")];
-    const pal::string_t& name = runtime_target.IsString() ?
-        runtime_target.GetString() :
-        runtime_target[_X("name")].GetString();
+            return true;
+        }
+    }
 
     trace::verbose(_X("Loading deps file... %s as framework dependent=[%d]"), deps_path.c_str(), is_framework_dependent);
 
-    if (is_framework_dependent)
-        return load_framework_dependent(deps_path, json.document(), name, rid_fallback_graph);
+    bool loaded = false;
+    if (is_dom_loader_enabled() || !load_streaming(is_framework_dependent, deps_path, rid_fallback_graph, &loaded))
+    {
+        json_parser_t json;
+        if (!json.parse_file(deps_path))
+        {
+            return false;
+        }
+
+        const auto& runtime_target = json.document()[_X("runtimeTarget")];
+        const pal::string_t& name = runtime_target.IsString() ?
+            runtime_target.GetString() :
+            runtime_target[_X("name")].GetString();
+
+        loaded = is_framework_dependent
+            ? load_framework_dependent(deps_path, json.document(), name, rid_fallback_graph)
+            : load_self_contained(deps_path, json.document(), name);
+    }
+
+    if (loaded)
+    {
+        build_package_index();
+    }
+
+    if (loaded && use_cache)
+    {
+        save_cache(cache_path, cache_key, deps_stamp);
+    }
 
-    return load_self_contained(deps_path, json.document(), name);
+    return loaded;
 }
@@ -24,11 +24,32 @@ class deps_json_t
 
     typedef std::unordered_map<pal::string_t, std::vector<pal::string_t>> str_to_vector_map_t;
 
+    struct library_t
+    {
+        pal::string_t name;
+        pal::string_t type;
+        pal::string_t hash;
+        pal::string_t path;
+        pal::string_t hash_path;
+        pal::string_t runtime_store_manifest_list;
+        bool serviceable;
+    };
+
 public:
     typedef str_to_vector_map_t rid_fallback_graph_t;
 
+    // How much of the RID fallback graph ("runtimes") of a self-contained app or root framework is loaded.
+    // Only the fallbacks of the host RID are consulted to pick RID specific assets, so by default only
+    // the entries for the host RID and the base RID it falls back to are kept out of the hundreds there are.
+    enum class rid_fallback_graph_mode_t
+    {
+        host_rid,
+        full
+    };
+
     deps_json_t()
-        : m_file_exists(false)
+        : m_rid_fallback_graph_mode(rid_fallback_graph_mode_t::host_rid)
+        , m_file_exists(false)
         , m_valid(false)
     {
     }
@@ -44,8 +65,9 @@ public:
         m_valid = load(is_framework_dependent, deps_path, graph);
     }
 
-    void parse(bool is_framework_dependent, const pal::string_t& deps_path)
+    void parse(bool is_framework_dependent, const pal::string_t& deps_path, rid_fallback_graph_mode_t mode = rid_fallback_graph_mode_t::host_rid)
     {
+        m_rid_fallback_graph_mode = mode;
         m_valid = load(is_framework_dependent, deps_path, m_rid_fallback_graph /* dummy */);
     }
 
@@ -60,7 +82,11 @@ public:
         return m_deps_entries[type];
     }
 
-    bool has_package(const pal::string_t& name, const pal::string_t& ver) const;
+    // Whether the deps file has the package with any assets. The key can come from another deps file.
+    bool has_package(const package_key_t& package) const
+    {
+        return m_deps_entries.packages.count(package) != 0;
+    }
 
     bool exists() const
     {
@@ -77,6 +103,11 @@ public:
         return m_rid_fallback_graph;
     }
 
+    rid_fallback_graph_mode_t get_rid_fallback_graph_mode() const
+    {
+        return m_rid_fallback_graph_mode;
+    }
+
     const deps_entry_t& try_ni(const deps_entry_t& entry) const;
 
     pal::string_t get_deps_file() const
@@ -84,6 +115,10 @@ public:
         return m_deps_file;
     }
 
+    // Identifies the layout of this class. A loaded instance can only be shared with another
+    // module (hostfxr -> hostpolicy) if both modules report the same layout.
+    static const pal::char_t* get_layout_id();
+
 private:
     bool load_self_contained(const pal::string_t& deps_path, const json_parser_t::value_t& json, const pal::string_t& target_name);
     bool load_framework_dependent(const pal::string_t& deps_path, const json_parser_t::value_t& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph);
@@ -91,25 +126,67 @@ private:
     bool process_runtime_targets(const json_parser_t::value_t& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, rid_specific_assets_t* p_assets);
     bool process_targets(const json_parser_t::value_t& json, const pal::string_t& target_name, deps_assets_t* p_assets);
 
-    void reconcile_libraries_with_targets(
-        const pal::string_t& deps_path,
-        const json_parser_t::value_t& json,
-        const std::function<bool(const pal::string_t&)>& library_exists_fn,
-        const std::function<const vec_asset_t&(const pal::string_t&, int, bool*)>& get_assets_fn);
+    void reconcile_libraries_with_targets(const pal::string_t& deps_path, const json_parser_t::value_t& json);
+    void trace_rid_fallback_graph() const;
+
+    // Shared by the DOM based loader above and the streaming loader in deps_format.reader.cpp
+    static deps_asset_t create_asset(const pal::string_t& file_name, const pal::string_t& assembly_version, const pal::string_t& file_version);
+    static void add_asset(deps_assets_t* p_assets, const pal::string_t& package, size_t asset_type_index, const deps_asset_t& asset);
+    static void add_rid_asset(rid_specific_assets_t* p_assets, const pal::string_t& package, size_t asset_type_index, const pal::string_t& rid, const deps_asset_t& asset);
+    bool library_exists(const pal::string_t& package) const;
+    const vec_asset_t& get_library_assets(const pal::string_t& package, size_t asset_type_index, bool* rid_specific) const;
+    void add_library_entries(const pal::string_t& deps_file, const library_t& library);
+    void add_package(const pal::string_t& package);
+    void build_package_index();
+
+    // Streaming loader which builds the entries without a DOM, see deps_format.reader.cpp
+    class reader_t;
+    static bool is_dom_loader_enabled();
+    bool load_streaming(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph, bool* loaded);
+    void clear();
 
     pal::string_t get_optional_property(const json_parser_t::value_t& properties, const pal::string_t& key) const;
     pal::string_t get_optional_path(const json_parser_t::value_t& properties, const pal::string_t& key) const;
 
     pal::string_t get_current_rid(const rid_fallback_graph_t& rid_fallback_graph);
+    static std::vector<pal::string_t> get_host_rid_candidates();
+    bool is_rid_fallback_graph_entry_needed(const pal::string_t& rid, const std::vector<pal::string_t>& host_rid_candidates) const;
     bool perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph);
 
-    std::vector<deps_entry_t> m_deps_entries[deps_entry_t::asset_types::count];
+    // Binary cache of the loaded state (".deps.bin" next to the ".deps.json"), see deps_format.cache.cpp
+    static bool is_cache_enabled();
+    static pal::string_t get_cache_path(const pal::string_t& deps_path);
+    bool get_cache_key(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph, std::vector<char>* key);
+    bool load_cache(const pal::string_t& cache_path, const std::vector<char>& key, const pal::file_stamp_t& deps_stamp, bool* stamp_outdated);
+    void save_cache(const pal::string_t& cache_path, const std::vector<char>& key, const pal::file_stamp_t& deps_stamp) const;
+
+    // The entries and the package index point to strings in the pool, so copying them has to point the copies to the copied pool.
+    struct entry_store_t
+    {
+        entry_store_t() { }
+        entry_store_t(const entry_store_t& other);
+        entry_store_t(entry_store_t&& other) = default;
+        entry_store_t& operator=(const entry_store_t& other);
+        entry_store_t& operator=(entry_store_t&& other) = default;
+
+        std::vector<deps_entry_t>& operator[](size_t type) { return entries[type]; }
+        const std::vector<deps_entry_t>& operator[](size_t type) const { return entries[type]; }
+
+        void clear();
+
+        std::vector<deps_entry_t> entries[deps_entry_t::asset_types::count];
+        std::unordered_set<package_key_t, package_key_t::hasher> packages;
+        string_pool_t strings;
+    };
+
+    entry_store_t m_deps_entries;
 
     deps_assets_t m_assets;
     rid_specific_assets_t m_rid_assets;
 
     std::unordered_map<pal::string_t, int> m_ni_entries;
     rid_fallback_graph_t m_rid_fallback_graph;
+    rid_fallback_graph_mode_t m_rid_fallback_graph_mode;
     bool m_file_exists;
     bool m_valid;
 
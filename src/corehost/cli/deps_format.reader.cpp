@@ -0,0 +1,712 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "deps_entry.h"
+#include "deps_format.h"
+#include "env_snapshot.h"
+#include "utils.h"
+#include "trace.h"
+#include <cassert>
+
+// Streaming deps.json loader
+//
+// The DOM based loader in deps_format.cpp materializes the whole document before walking it.
+// This loader consumes the parser events directly instead: assets from the selected target go
+// straight into the per-package asset maps, and each library is turned into deps entries as soon
+// as its object ends. Nothing else from the file is kept.
+//
+// The result is identical to the DOM based loader. Layouts this loader does not handle (for example
+// "runtimeTarget" appearing after "targets", or values of unexpected types) make it give up, in which
+// case the caller falls back to the DOM based loader. DOTNET_DEPS_DOM_LOADER=1 always uses the DOM
+// based loader.
+
+namespace
+{
+    enum class state_t
+    {
+        document,       // Before the root object
+        root,           // Members of the root object
+        runtime_target, // Members of the "runtimeTarget" object
+        targets,        // Members of "targets" - one per target
+        target,         // Members of the selected target - one per package
+        package,        // Members of a package - asset groups, dependencies, ...
+        asset_group,    // Members of an asset group - one per file
+        asset,          // Members of an asset - its properties
+        libraries,      // Members of "libraries" - one per library
+        library,        // Members of a library - its properties
+        runtimes,       // Members of "runtimes" - one per RID
+        rid_fallbacks,  // Elements of the fallback list of a RID
+        done
+    };
+
+    enum class value_kind_t
+    {
+        object,
+        array,
+        string,
+        boolean,
+        other
+    };
+
+    // Asset group index used for "runtimeTargets", after the known asset types
+    const size_t runtime_targets_group = deps_entry_t::asset_types::count;
+
+    // The DOM based loader looks properties up by name, which finds the first member with
+    // that name, and treats values of the wrong type as missing (optional properties) or
+    // can't handle them at all (required properties).
+    struct property_t
+    {
+        property_t() : seen(false), is_string(false), is_bool(false), bool_value(false) { }
+
+        void set(value_kind_t kind, const pal::char_t* str, size_t length, bool b)
+        {
+            if (seen)
+            {
+                return;
+            }
+
+            seen = true;
+            if (kind == value_kind_t::string)
+            {
+                is_string = true;
+                value.assign(str, length);
+            }
+            else if (kind == value_kind_t::boolean)
+            {
+                is_bool = true;
+                bool_value = b;
+            }
+        }
+
+        const pal::string_t& get_optional_string() const
+        {
+            static const pal::string_t empty;
+            return is_string ? value : empty;
+        }
+
+        pal::string_t get_optional_path() const
+        {
+            pal::string_t path = get_optional_string();
+            if (path.length() > 0 && _X('/') != DIR_SEPARATOR)
+            {
+                replace_char(&path, _X('/'), DIR_SEPARATOR);
+            }
+
+            return path;
+        }
+
+        bool seen;
+        bool is_string;
+        bool is_bool;
+        bool bool_value;
+        pal::string_t value;
+    };
+
+    struct asset_properties_t
+    {
+        pal::string_t file_name;
+        property_t assembly_version;
+        property_t file_version;
+        property_t asset_type;
+        property_t rid;
+    };
+
+    struct library_properties_t
+    {
+        pal::string_t name;
+        property_t type;
+        property_t sha512;
+        property_t serviceable;
+        property_t path;
+        property_t hash_path;
+        property_t runtime_store_manifest_name;
+    };
+}
+
+class deps_json_t::reader_t : public json_parser_t::handler_t
+{
+public:
+    reader_t(deps_json_t& deps, const pal::string_t& deps_path, bool is_framework_dependent, const rid_fallback_graph_t& rid_fallback_graph)
+        : m_deps(deps)
+        , m_deps_file(get_filename(deps_path))
+        , m_is_framework_dependent(is_framework_dependent)
+        , m_rid_fallback_graph(rid_fallback_graph)
+        , m_state(state_t::document)
+        , m_skip_depth(0)
+        , m_unsupported(false)
+        , m_has_target_name(false)
+        , m_seen_runtime_target(false)
+        , m_seen_targets(false)
+        , m_seen_target(false)
+        , m_seen_libraries(false)
+        , m_seen_runtimes(false)
+        , m_seen_target_name(false)
+        , m_target_done(false)
+        , m_group(0)
+        , m_rid_fallbacks(nullptr)
+    {
+        if (!is_framework_dependent)
+        {
+            m_host_rid_candidates = get_host_rid_candidates();
+        }
+    }
+
+    bool Null() override { return scalar(value_kind_t::other, nullptr, 0, false); }
+    bool Bool(bool b) override { return scalar(value_kind_t::boolean, nullptr, 0, b); }
+    bool RawNumber(const Ch*, rapidjson::SizeType, bool) override { return scalar(value_kind_t::other, nullptr, 0, false); }
+    bool String(const Ch* str, rapidjson::SizeType length, bool) override { return scalar(value_kind_t::string, str, length, false); }
+    bool StartObject() override { return start(value_kind_t::object); }
+    bool StartArray() override { return start(value_kind_t::array); }
+
+    bool Key(const Ch* str, rapidjson::SizeType length, bool) override
+    {
+        if (m_skip_depth == 0)
+        {
+            m_key.assign(str, length);
+        }
+
+        return true;
+    }
+
+    bool EndObject(rapidjson::SizeType) override
+    {
+        if (m_skip_depth > 0)
+        {
+            m_skip_depth--;
+            return true;
+        }
+
+        switch (m_state)
+        {
+        case state_t::root:
+            m_state = state_t::done;
+            return true;
+        case state_t::runtime_target:
+        case state_t::targets:
+        case state_t::libraries:
+        case state_t::runtimes:
+            m_state = state_t::root;
+            return true;
+        case state_t::target:
+            m_state = state_t::targets;
+            return end_target();
+        case state_t::package:
+            m_state = state_t::target;
+            return true;
+        case state_t::asset_group:
+            m_state = state_t::package;
+            return true;
+        case state_t::asset:
+            m_state = state_t::asset_group;
+            return end_asset();
+        case state_t::library:
+            m_state = state_t::libraries;
+            return end_library();
+        default:
+            assert(false);
+            return unsupported();
+        }
+    }
+
+    bool EndArray(rapidjson::SizeType) override
+    {
+        if (m_skip_depth > 0)
+        {
+            m_skip_depth--;
+            return true;
+        }
+
+        assert(m_state == state_t::rid_fallbacks);
+        m_state = state_t::runtimes;
+        return true;
+    }
+
+    // Completes the load once the whole document has been read
+    bool finish()
+    {
+        assert(m_state == state_t::done);
+
+        if (!m_seen_target || !m_seen_libraries)
+        {
+            return unsupported();
+        }
+
+        if (!m_is_framework_dependent)
+        {
+            m_deps.trace_rid_fallback_graph();
+        }
+
+        return true;
+    }
+
+    bool is_unsupported() const
+    {
+        return m_unsupported;
+    }
+
+private:
+    bool unsupported()
+    {
+        m_unsupported = true;
+        return false;
+    }
+
+    // Skip the object or array which has just started, including everything nested in it
+    bool skip(value_kind_t kind)
+    {
+        if (kind == value_kind_t::object || kind == value_kind_t::array)
+        {
+            m_skip_depth = 1;
+        }
+
+        return true;
+    }
+
+    bool start(value_kind_t kind)
+    {
+        if (m_skip_depth > 0)
+        {
+            m_skip_depth++;
+            return true;
+        }
+
+        return value(kind, nullptr, 0, false);
+    }
+
+    bool scalar(value_kind_t kind, const pal::char_t* str, size_t length, bool b)
+    {
+        if (m_skip_depth > 0)
+        {
+            return true;
+        }
+
+        return value(kind, str, length, b);
+    }
+
+    // Called for each value which is not nested in a skipped value. For objects and arrays this is
+    // called when they start; m_key is the name of the member the value belongs to, if any.
+    bool value(value_kind_t kind, const pal::char_t* str, size_t length, bool b)
+    {
+        switch (m_state)
+        {
+        case state_t::document:
+            if (kind != value_kind_t::object)
+            {
+                return unsupported();
+            }
+
+            m_state = state_t::root;
+            return true;
+
+        case state_t::root:
+            return root_value(kind, str, length);
+
+        case state_t::runtime_target:
+            if (m_key != _X("name") || m_seen_target_name)
+            {
+                return skip(kind);
+            }
+
+            m_seen_target_name = true;
+            if (kind != value_kind_t::string)
+            {
+                return unsupported();
+            }
+
+            m_target_name.assign(str, length);
+            m_has_target_name = true;
+            return true;
+
+        case state_t::targets:
+            if (!m_has_target_name)
+            {
+                // The target to load is not known yet
+                return unsupported();
+            }
+
+            if (m_key != m_target_name || m_seen_target)
+            {
+                return skip(kind);
+            }
+
+            m_seen_target = true;
+            if (kind != value_kind_t::object)
+            {
+                return unsupported();
+            }
+
+            m_state = state_t::target;
+            return true;
+
+        case state_t::target:
+            if (kind != value_kind_t::object)
+            {
+                return unsupported();
+            }
+
+            m_package = m_key;
+            m_seen_groups.fill(false);
+            m_state = state_t::package;
+            return true;
+
+        case state_t::package:
+            return package_value(kind);
+
+        case state_t::asset_group:
+            if (kind != value_kind_t::object)
+            {
+                return unsupported();
+            }
+
+            m_asset = asset_properties_t();
+            m_asset.file_name = m_key;
+            m_state = state_t::asset;
+            return true;
+
+        case state_t::asset:
+            if (m_key == _X("assemblyVersion"))
+            {
+                m_asset.assembly_version.set(kind, str, length, b);
+            }
+            else if (m_key == _X("fileVersion"))
+            {
+                m_asset.file_version.set(kind, str, length, b);
+            }
+            else if (m_group == runtime_targets_group && m_key == _X("assetType"))
+            {
+                m_asset.asset_type.set(kind, str, length, b);
+            }
+            else if (m_group == runtime_targets_group && m_key == _X("rid"))
+            {
+                m_asset.rid.set(kind, str, length, b);
+            }
+
+            return skip(kind);
+
+        case state_t::libraries:
+            m_library = library_properties_t();
+            m_library.name = m_key;
+            if (kind != value_kind_t::object)
+            {
+                // Treated as a library without any properties
+                return end_library() && skip(kind);
+            }
+
+            m_state = state_t::library;
+            return true;
+
+        case state_t::library:
+            if (m_key == _X("type"))
+            {
+                m_library.type.set(kind, str, length, b);
+            }
+            else if (m_key == _X("sha512"))
+            {
+                m_library.sha512.set(kind, str, length, b);
+            }
+            else if (m_key == _X("serviceable"))
+            {
+                m_library.serviceable.set(kind, str, length, b);
+            }
+            else if (m_key == _X("path"))
+            {
+                m_library.path.set(kind, str, length, b);
+            }
+            else if (m_key == _X("hashPath"))
+            {
+                m_library.hash_path.set(kind, str, length, b);
+            }
+            else if (m_key == _X("runtimeStoreManifestName"))
+            {
+                m_library.runtime_store_manifest_name.set(kind, str, length, b);
+            }
+
+            return skip(kind);
+
+        case state_t::runtimes:
+            if (kind != value_kind_t::array)
+            {
+                return unsupported();
+            }
+
+            if (!m_deps.is_rid_fallback_graph_entry_needed(m_key, m_host_rid_candidates))
+            {
+                return skip(kind);
+            }
+
+            m_rid_fallbacks = &m_deps.m_rid_fallback_graph[m_key];
+            m_state = state_t::rid_fallbacks;
+            return true;
+
+        case state_t::rid_fallbacks:
+            if (kind != value_kind_t::string)
+            {
+                return unsupported();
+            }
+
+            m_rid_fallbacks->push_back(pal::string_t(str, length));
+            return true;
+
+        default:
+            assert(false);
+            return unsupported();
+        }
+    }
+
+    bool root_value(value_kind_t kind, const pal::char_t* str, size_t length)
+    {
+        if (m_key == _X("runtimeTarget") && !m_seen_runtime_target)
+        {
+            m_seen_runtime_target = true;
+            if (kind == value_kind_t::string)
+            {
+                m_target_name.assign(str, length);
+                m_has_target_name = true;
+                return true;
+            }
+
+            if (kind != value_kind_t::object)
+            {
+                return unsupported();
+            }
+
+            m_state = state_t::runtime_target;
+            return true;
+        }
+
+        state_t section_state;
+        bool* seen;
+        if (m_key == _X("targets"))
+        {
+            section_state = state_t::targets;
+            seen = &m_seen_targets;
+        }
+        else if (m_key == _X("libraries"))
+        {
+            section_state = state_t::libraries;
+            seen = &m_seen_libraries;
+        }
+        else if (m_key == _X("runtimes") && !m_is_framework_dependent)
+        {
+            section_state = state_t::runtimes;
+            seen = &m_seen_runtimes;
+        }
+        else
+        {
+            return skip(kind);
+        }
+
+        if (*seen)
+        {
+            return skip(kind);
+        }
+
+        *seen = true;
+        if (kind != value_kind_t::object)
+        {
+            return unsupported();
+        }
+
+        m_state = section_state;
+        return true;
+    }
+
+    bool package_value(value_kind_t kind)
+    {
+        size_t group = 0;
+        for (; group < deps_entry_t::s_known_asset_types.size(); ++group)
+        {
+            if (m_key == deps_entry_t::s_known_asset_types[group])
+            {
+                break;
+            }
+        }
+
+        if (group == deps_entry_t::s_known_asset_types.size()
+            && (!m_is_framework_dependent || m_key != _X("runtimeTargets")))
+        {
+            return skip(kind);
+        }
+
+        if (m_seen_groups[group])
+        {
+            return skip(kind);
+        }
+
+        m_seen_groups[group] = true;
+        if (kind != value_kind_t::object)
+        {
+            return unsupported();
+        }
+
+        m_group = group;
+        m_state = state_t::asset_group;
+        return true;
+    }
+
+    bool end_asset()
+    {
+        if (m_group != runtime_targets_group)
+        {
+            add_asset(&m_deps.m_assets, m_package, m_group, create_asset(
+                m_asset.file_name,
+                m_asset.assembly_version.get_optional_string(),
+                m_asset.file_version.get_optional_string()));
+            return true;
+        }
+
+        if (!m_asset.asset_type.is_string)
+        {
+            return unsupported();
+        }
+
+        for (size_t asset_type_index = 0; asset_type_index < deps_entry_t::s_known_asset_types.size(); ++asset_type_index)
+        {
+            if (pal::strcasecmp(m_asset.asset_type.value.c_str(), deps_entry_t::s_known_asset_types[asset_type_index]) != 0)
+            {
+                continue;
+            }
+
+            if (!m_asset.rid.is_string)
+            {
+                return unsupported();
+            }
+
+            add_rid_asset(&m_deps.m_rid_assets, m_package, asset_type_index, m_asset.rid.value, create_asset(
+                m_asset.file_name,
+                m_asset.assembly_version.get_optional_string(),
+                m_asset.file_version.get_optional_string()));
+        }
+
+        return true;
+    }
+
+    bool end_target()
+    {
+        m_target_done = true;
+
+        if (m_is_framework_dependent && !m_deps.perform_rid_fallback(&m_deps.m_rid_assets, m_rid_fallback_graph))
+        {
+            return false;
+        }
+
+        // Libraries which were listed before the targets can be reconciled now
+        for (const auto& library : m_pending_libraries)
+        {
+            if (!reconcile_library(library))
+            {
+                return false;
+            }
+        }
+
+        m_pending_libraries.clear();
+        return true;
+    }
+
+    bool end_library()
+    {
+        // Libraries can only be reconciled once all the assets of the target are known
+        if (!m_target_done)
+        {
+            m_pending_libraries.push_back(m_library);
+            return true;
+        }
+
+        return reconcile_library(m_library);
+    }
+
+    bool reconcile_library(const library_properties_t& properties)
+    {
+        TRACE_INFO(_X("Reconciling library %s"), properties.name.c_str());
+
+        if (!m_deps.library_exists(properties.name))
+        {
+            TRACE_INFO(_X("Library %s does not exist"), properties.name.c_str());
+            return true;
+        }
+
+        if (!properties.type.is_string || !properties.sha512.is_string || !properties.serviceable.is_bool)
+        {
+            return unsupported();
+        }
+
+        library_t library;
+        library.name = properties.name;
+        library.type = properties.type.value;
+        library.hash = properties.sha512.value;
+        library.serviceable = properties.serviceable.bool_value;
+        library.path = properties.path.get_optional_path();
+        library.hash_path = properties.hash_path.get_optional_path();
+        library.runtime_store_manifest_list = properties.runtime_store_manifest_name.get_optional_path();
+
+        m_deps.add_library_entries(m_deps_file, library);
+        return true;
+    }
+
+    deps_json_t& m_deps;
+    const pal::string_t m_deps_file;
+    const bool m_is_framework_dependent;
+    const rid_fallback_graph_t& m_rid_fallback_graph;
+
+    state_t m_state;
+    int m_skip_depth;
+    bool m_unsupported;
+    pal::string_t m_key;
+
+    pal::string_t m_target_name;
+    bool m_has_target_name;
+
+    // Sections which have already been processed - only the first one counts
+    bool m_seen_runtime_target;
+    bool m_seen_targets;
+    bool m_seen_target;
+    bool m_seen_libraries;
+    bool m_seen_runtimes;
+    bool m_seen_target_name;
+    bool m_target_done;
+
+    pal::string_t m_package;
+    std::array<bool, runtime_targets_group + 1> m_seen_groups;
+    size_t m_group;
+    asset_properties_t m_asset;
+
+    library_properties_t m_library;
+    std::vector<library_properties_t> m_pending_libraries;
+
+    std::vector<pal::string_t> m_host_rid_candidates;
+    std::vector<pal::string_t>* m_rid_fallbacks;
+};
+
+bool deps_json_t::is_dom_loader_enabled()
+{
+    return env_snapshot::is_enabled(env_key_t::DOTNET_DEPS_DOM_LOADER);
+}
+
+// -----------------------------------------------------------------------------
+// Load the deps file using the streaming loader.
+//
+// Returns false if the file has a layout the streaming loader doesn't handle, in
+// which case nothing is loaded and the DOM based loader should be used instead.
+// Otherwise returns true and sets 'loaded' to whether the file was loaded.
+//
+bool deps_json_t::load_streaming(bool is_framework_dependent, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph, bool* loaded)
+{
+    json_parser_t json;
+    reader_t reader(*this, deps_path, is_framework_dependent, rid_fallback_graph);
+    *loaded = json.parse_file(deps_path, reader) && reader.finish();
+
+    if (reader.is_unsupported())
+    {
+        trace::verbose(_X("The deps file [%s] can't be loaded by the streaming loader, falling back to the DOM based loader"), deps_path.c_str());
+        clear();
+        return false;
+    }
+
+    if (!*loaded)
+    {
+        clear();
+    }
+
+    return true;
+}
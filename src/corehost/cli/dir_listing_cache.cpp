@@ -0,0 +1,136 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "dir_listing_cache.h"
+#include "trace.h"
+
+bool dir_listing_cache_t::file_exists(const pal::string_t& path)
+{
+    m_queries++;
+
+#if defined(_WIN32)
+    size_t pos = path.find_last_of(_X("\\/"));
+#else
+    size_t pos = path.find_last_of(DIR_SEPARATOR);
+#endif
+    if (pos == pal::string_t::npos || pos == 0 || pos + 1 == path.length())
+    {
+        m_file_system_calls++;
+        return pal::file_exists(path);
+    }
+
+    pal::string_t dir = path.substr(0, pos);
+    auto iter = m_listings.find(dir);
+    if (iter == m_listings.end())
+    {
+        // The first query for a directory is answered by the file system, see the class comment.
+        listing_t& listing = m_listings[dir];
+        if (m_record_dir_stamps)
+        {
+            stamp_dir(dir, &listing);
+            if (!listing.exists)
+            {
+                return false;
+            }
+        }
+
+        m_file_system_calls++;
+        return pal::file_exists(path);
+    }
+
+    listing_t& listing = iter->second;
+    if (!listing.listing_attempted)
+    {
+        list_dir(dir, &listing);
+    }
+
+    if (!listing.exists)
+    {
+        return false;
+    }
+
+    pal::string_t name = path.substr(pos + 1);
+    if (listing.listed)
+    {
+        if (listing.names.count(name))
+        {
+            return true;
+        }
+
+        if (listing.lower_case_names.empty())
+        {
+            for (const auto& listed_name : listing.names)
+            {
+                listing.lower_case_names.insert(pal::to_lower(listed_name));
+            }
+        }
+
+        if (!listing.lower_case_names.count(pal::to_lower(name)))
+        {
+            return false;
+        }
+    }
+
+    // Whether the name matches depends on the file system, so ask it.
+    m_file_system_calls++;
+    return pal::file_exists(path);
+}
+
+void dir_listing_cache_t::stamp_dir(const pal::string_t& dir, listing_t* listing)
+{
+    m_file_system_calls++;
+    listing->stamped = true;
+    listing->exists = pal::get_file_stamp(dir, &listing->stamp);
+    if (!listing->exists)
+    {
+        listing->stamp = pal::file_stamp_t();
+    }
+}
+
+void dir_listing_cache_t::list_dir(const pal::string_t& dir, listing_t* listing)
+{
+    listing->listing_attempted = true;
+    if (!listing->stamped)
+    {
+        stamp_dir(dir, listing);
+    }
+
+    if (!listing->exists)
+    {
+        return;
+    }
+
+    // Opening, reading (at least once) and closing the directory
+    std::vector<pal::string_t> names;
+    m_file_system_calls += 3;
+    m_listed_dirs++;
+    pal::readdir(dir, &names);
+
+    listing->listed = !names.empty();
+    listing->names.insert(names.begin(), names.end());
+}
+
+void dir_listing_cache_t::trace_summary() const
+{
+    if (m_queries == 0)
+    {
+        return;
+    }
+
+    trace::verbose(_X("Answered %d file existence queries in %d directories using about %d file system calls, listing %d directories"),
+        m_queries, static_cast<int>(m_listings.size()), m_file_system_calls, m_listed_dirs);
+}
+
+void dir_listing_cache_t::get_dir_stamps(std::vector<dir_stamp_t>* stamps) const
+{
+    for (const auto& listing : m_listings)
+    {
+        if (!listing.second.stamped)
+        {
+            continue;
+        }
+
+        stamps->push_back({ listing.first, listing.second.exists, listing.second.stamp });
+    }
+}
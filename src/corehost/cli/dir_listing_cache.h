@@ -0,0 +1,94 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __DIR_LISTING_CACHE_H_
+#define __DIR_LISTING_CACHE_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include "pal.h"
+
+// Answers file existence queries by reading the directory the file would be in once and looking
+// the file name up in the listing, instead of checking the file system for every file. Probing
+// looks for many files in the same few directories, so this saves most of the file system calls.
+// Listing a directory takes several calls though, and many directories (e.g. the package
+// directories under the probe paths) are only queried once. So the first query for a directory
+// is answered by the file system, and the directory is only listed on its second query.
+//
+// A name which only differs in casing from a name in the listing, or a directory which exists but
+// can't be listed, falls back to pal::file_exists, so the answers are the same on case sensitive
+// and case insensitive file systems.
+class dir_listing_cache_t
+{
+public:
+    // The state of a directory when it was listed, which tells whether it could have changed since.
+    struct dir_stamp_t
+    {
+        pal::string_t dir;
+        bool exists;
+        pal::file_stamp_t stamp;
+    };
+
+    dir_listing_cache_t()
+        : m_queries(0)
+        , m_file_system_calls(0)
+        , m_listed_dirs(0)
+        , m_record_dir_stamps(false)
+    { }
+
+    bool file_exists(const pal::string_t& path);
+
+    // Stamps every directory on its first query, so that get_dir_stamps covers all the
+    // directories the answers depend on. Has to be called before the first query.
+    void record_dir_stamps()
+    {
+        m_record_dir_stamps = true;
+    }
+
+    // Traces how many file system calls the cache saved so far.
+    void trace_summary() const;
+
+    void get_dir_stamps(std::vector<dir_stamp_t>* stamps) const;
+
+private:
+    struct listing_t
+    {
+        listing_t()
+            : stamped(false)
+            , exists(true)
+            , stamp()
+            , listed(false)
+            , listing_attempted(false)
+        { }
+
+        // Whether the directory was stamped yet, which tells whether exists and stamp are known.
+        bool stamped;
+
+        // False if the directory doesn't exist, in which case none of the files in it do either.
+        bool exists;
+
+        // Taken before reading the directory, so any later change to it changes the stamp.
+        pal::file_stamp_t stamp;
+
+        // False if the directory wasn't read yet, or if it exists but reading it returned nothing.
+        bool listed;
+        bool listing_attempted;
+
+        std::unordered_set<pal::string_t> names;
+
+        // Built on the first query which doesn't match any name exactly.
+        std::unordered_set<pal::string_t> lower_case_names;
+    };
+
+    void stamp_dir(const pal::string_t& dir, listing_t* listing);
+    void list_dir(const pal::string_t& dir, listing_t* listing);
+
+    std::unordered_map<pal::string_t, listing_t> m_listings;
+    int m_queries;
+    int m_file_system_calls;
+    int m_listed_dirs;
+    bool m_record_dir_stamps;
+};
+
+#endif // __DIR_LISTING_CACHE_H_
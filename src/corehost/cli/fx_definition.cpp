@@ -7,8 +7,10 @@
 #include "fx_ver.h"
 #include "pal.h"
 #include "runtime_config.h"
+#include "trace.h"
 
 fx_definition_t::fx_definition_t()
+    : m_has_preloaded_deps(false)
 {
 }
 
@@ -21,6 +23,7 @@ fx_definition_t::fx_definition_t(
     , m_dir(dir)
     , m_requested_version(requested_version)
     , m_found_version(found_version)
+    , m_has_preloaded_deps(false)
 {
 }
 
@@ -33,9 +36,28 @@ void fx_definition_t::parse_runtime_config(
     m_runtime_config.parse(path, dev_path, override_settings);
 }
 
-void fx_definition_t::parse_deps()
+void fx_definition_t::set_preloaded_deps(const deps_json_t& deps)
 {
-    m_deps.parse(false, m_deps_file);
+    m_deps = deps;
+    m_has_preloaded_deps = true;
+}
+
+void fx_definition_t::parse_deps(deps_json_t::rid_fallback_graph_mode_t mode)
+{
+    if (m_has_preloaded_deps)
+    {
+        if (m_deps.get_deps_file() == m_deps_file && m_deps.get_rid_fallback_graph_mode() == mode)
+        {
+            return;
+        }
+
+        trace::verbose(_X("Not using preloaded deps file [%s] since [%s] is expected with the %s RID fallback graph"),
+            m_deps.get_deps_file().c_str(), m_deps_file.c_str(), mode == deps_json_t::rid_fallback_graph_mode_t::full ? _X("full") : _X("host RID"));
+        m_deps = deps_json_t();
+        m_has_preloaded_deps = false;
+    }
+
+    m_deps.parse(false, m_deps_file, mode);
 }
 
 void fx_definition_t::parse_deps(const deps_json_t::rid_fallback_graph_t& graph)
@@ -25,13 +25,18 @@ public:
     const pal::string_t& get_dir() const { return m_dir; }
     const runtime_config_t& get_runtime_config() const { return m_runtime_config; }
     void parse_runtime_config(const pal::string_t& path, const pal::string_t& dev_path, const runtime_config_t::settings_t& override_settings);
+    void set_runtime_config(const runtime_config_t& config) { m_runtime_config = config; }
 
     const pal::string_t& get_deps_file() const { return m_deps_file; }
     void set_deps_file(const pal::string_t value) { m_deps_file = value; }
     const deps_json_t& get_deps() const { return m_deps; }
-    void parse_deps();
+    void parse_deps(deps_json_t::rid_fallback_graph_mode_t mode = deps_json_t::rid_fallback_graph_mode_t::host_rid);
     void parse_deps(const deps_json_t::rid_fallback_graph_t& graph);
 
+    // Deps which were already loaded from the deps file (by hostfxr). parse_deps() uses
+    // them instead of parsing the file again, as long as the deps file is the same.
+    void set_preloaded_deps(const deps_json_t& deps);
+
 private:
     pal::string_t m_name;
     pal::string_t m_dir;
@@ -40,6 +45,7 @@ private:
     runtime_config_t m_runtime_config;
     pal::string_t m_deps_file;
     deps_json_t m_deps;
+    bool m_has_preloaded_deps;
 };
 
 typedef std::vector<std::unique_ptr<fx_definition_t>> fx_definition_vector_t;
@@ -279,7 +279,7 @@ int command_line::parse_args_for_sdk_command(
     return parse_args(host_info, 1, argc, argv, false, host_mode_t::muxer, new_argoff, app_candidate, opts);
 }
 
-void command_line::print_muxer_info(const pal::string_t &dotnet_root)
+void command_line::print_muxer_info(const pal::string_t &dotnet_root, install_index_cache_t& install_indexes)
 {
     trace::println();
     trace::println(_X("Host (useful for support):"));
@@ -290,14 +290,14 @@ void command_line::print_muxer_info(const pal::string_t &dotnet_root)
 
     trace::println();
     trace::println(_X(".NET Core SDKs installed:"));
-    if (!sdk_info::print_all_sdks(dotnet_root, _X("  ")))
+    if (!sdk_info::print_all_sdks(dotnet_root, _X("  "), install_indexes))
     {
         trace::println(_X("  No SDKs were found."));
     }
 
     trace::println();
     trace::println(_X(".NET Core runtimes installed:"));
-    if (!framework_info::print_all_frameworks(dotnet_root, _X("  ")))
+    if (!framework_info::print_all_frameworks(dotnet_root, _X("  "), install_indexes))
     {
         trace::println(_X("  No runtimes were found."));
     }
@@ -9,6 +9,8 @@
 #include <host_startup_info.h>
 #include <pal.h>
 
+class install_index_cache_t;
+
 enum class known_options
 {
     additional_probing_path,
@@ -58,7 +60,7 @@ namespace command_line
         /*out*/ pal::string_t &app_candidate,
         /*out*/ opt_map_t &opts);
 
-    void print_muxer_info(const pal::string_t &dotnet_root);
+    void print_muxer_info(const pal::string_t &dotnet_root, install_index_cache_t& install_indexes);
     void print_muxer_usage(bool is_sdk_present);
 };
 
@@ -37,6 +37,7 @@ private:
     const pal::string_t m_host_info_host_path;
     const pal::string_t m_host_info_dotnet_root;
     const pal::string_t m_host_info_app_path;
+    std::unique_ptr<deps_json_t> m_root_deps;
 public:
     corehost_init_t(
         const pal::string_t& host_command,
@@ -45,7 +46,8 @@ public:
         const pal::string_t& additional_deps_serialized,
         const std::vector<pal::string_t>& probe_paths,
         const host_mode_t mode,
-        const fx_definition_vector_t& fx_definitions);
+        const fx_definition_vector_t& fx_definitions,
+        std::unique_ptr<deps_json_t> root_deps);
 
     const host_interface_t& get_host_init_data();
 
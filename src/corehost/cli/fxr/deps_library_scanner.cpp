@@ -0,0 +1,129 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "deps_library_scanner.h"
+#include "json_parser.h"
+
+namespace
+{
+    // Tracks the nesting depth of the document and only looks at the keys directly under the
+    // root level "libraries" object. Everything else is skipped without copying it.
+    class library_scanner_t : public json_parser_t::handler_t
+    {
+    public:
+        library_scanner_t(const pal::string_t& prefix)
+            : m_prefix(prefix)
+            , m_depth(0)
+            , m_libraries_depth(0)
+            , m_in_libraries_key(false)
+            , m_found(false)
+        { }
+
+        bool found() const { return m_found; }
+        const pal::string_t& library_name() const { return m_library_name; }
+
+        bool Null() override { return value(); }
+        bool Bool(bool) override { return value(); }
+        bool RawNumber(const Ch*, rapidjson::SizeType, bool) override { return value(); }
+        bool String(const Ch*, rapidjson::SizeType, bool) override { return value(); }
+
+        bool StartObject() override
+        {
+            m_depth++;
+            if (m_in_libraries_key)
+            {
+                m_in_libraries_key = false;
+                m_libraries_depth = m_depth;
+            }
+
+            return true;
+        }
+
+        bool Key(const Ch* str, rapidjson::SizeType length, bool) override
+        {
+            if (m_libraries_depth != 0 && m_depth == m_libraries_depth)
+            {
+                if (length >= m_prefix.length() && pal::strncasecmp(str, m_prefix.c_str(), m_prefix.length()) == 0)
+                {
+                    m_library_name.assign(str, length);
+                    m_found = true;
+                    return stop();
+                }
+            }
+            else if (m_depth == 1 && pal::strcmp(str, _X("libraries")) == 0)
+            {
+                m_in_libraries_key = true;
+            }
+
+            return true;
+        }
+
+        bool EndObject(rapidjson::SizeType) override
+        {
+            if (m_libraries_depth != 0 && m_depth == m_libraries_depth)
+            {
+                // Only the first "libraries" section is looked at, just like with a DOM lookup.
+                return stop();
+            }
+
+            m_depth--;
+            return true;
+        }
+
+        bool StartArray() override
+        {
+            m_in_libraries_key = false;
+            m_depth++;
+            return true;
+        }
+
+        bool EndArray(rapidjson::SizeType) override
+        {
+            m_depth--;
+            return true;
+        }
+
+    private:
+        bool value()
+        {
+            if (m_in_libraries_key)
+            {
+                // "libraries" is not an object, so there is nothing to find.
+                return stop();
+            }
+
+            return true;
+        }
+
+        bool stop()
+        {
+            // Returning false from a callback terminates the parse.
+            return false;
+        }
+
+        const pal::string_t& m_prefix;
+        int m_depth;
+        int m_libraries_depth;
+        bool m_in_libraries_key;
+        bool m_found;
+        pal::string_t m_library_name;
+    };
+}
+
+bool deps_library_scanner::find_library(
+    const pal::string_t& deps_path,
+    const pal::string_t& prefix,
+    pal::string_t* library_name)
+{
+    library_scanner_t scanner(prefix);
+    json_parser_t json;
+    json.parse_file(deps_path, scanner);
+    if (!scanner.found())
+    {
+        return false;
+    }
+
+    library_name->assign(scanner.library_name());
+    return true;
+}
@@ -0,0 +1,22 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __DEPS_LIBRARY_SCANNER_H__
+#define __DEPS_LIBRARY_SCANNER_H__
+
+#include <pal.h>
+
+namespace deps_library_scanner
+{
+    // Finds the first library in the "libraries" section of the deps file whose name starts
+    // with the given prefix (compared case-insensitively). Stops reading the file as soon as
+    // the library is found and doesn't allocate anything for the parts of the file it skips.
+    // Returns false if the file can't be read or parsed, or if there is no such library.
+    bool find_library(
+        const pal::string_t& deps_path,
+        const pal::string_t& prefix,
+        pal::string_t* library_name);
+};
+
+#endif // __DEPS_LIBRARY_SCANNER_H__
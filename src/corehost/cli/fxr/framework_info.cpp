@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include "framework_info.h"
+#include "install_index.h"
 #include "pal.h"
 #include "trace.h"
 #include "utils.h"
@@ -26,6 +27,7 @@ bool compare_by_name_and_version(const framework_info &a, const framework_info &
 /*static*/ void framework_info::get_all_framework_infos(
     const pal::string_t& own_dir,
     const pal::string_t& fx_name,
+    install_index_cache_t& install_indexes,
     std::vector<framework_info>* framework_infos)
 {
     std::vector<pal::string_t> hive_dir;
@@ -38,12 +40,21 @@ bool compare_by_name_and_version(const framework_info &a, const framework_info &
 
         if (pal::directory_exists(fx_shared_dir))
         {
+            const install_index_t* index = install_indexes.get(dir);
+
             std::vector<pal::string_t> fx_names;
             if (fx_name.length())
             {
                 // Use the provided framework name
                 fx_names.push_back(fx_name);
             }
+            else if (index != nullptr)
+            {
+                for (const auto& framework : index->get_frameworks())
+                {
+                    fx_names.push_back(framework.name);
+                }
+            }
             else
             {
                 // Read all frameworks, including "Microsoft.NETCore.App"
@@ -57,22 +68,32 @@ bool compare_by_name_and_version(const framework_info &a, const framework_info &
 
                 if (pal::directory_exists(fx_dir))
                 {
+                    // The name may differ from the directory name in case only, which the index doesn't match
+                    const install_index_t::framework_t* indexed = index != nullptr ? index->find_framework(fx_name) : nullptr;
+                    if (indexed != nullptr)
+                    {
+                        for (const auto& parsed : indexed->versions)
+                        {
+                            framework_infos->push_back(framework_info(fx_name, fx_dir, parsed));
+                        }
+
+                        continue;
+                    }
+
                     trace::verbose(_X("Gathering FX locations in [%s]"), fx_dir.c_str());
 
-                    std::vector<pal::string_t> versions;
-                    pal::readdir_onlydirectories(fx_dir, &versions);
-                    for (const auto& ver : versions)
+                    pal::enumerate_dir(fx_dir, _X("*"), true, [&](const pal::char_t* ver)
                     {
                         // Make sure we filter out any non-version folders.
                         fx_ver_t parsed;
                         if (fx_ver_t::parse(ver, &parsed, false))
                         {
-                            trace::verbose(_X("Found FX version [%s]"), ver.c_str());
+                            trace::verbose(_X("Found FX version [%s]"), ver);
 
                             framework_info info(fx_name, fx_dir, parsed);
                             framework_infos->push_back(info);
                         }
-                    }
+                    });
                 }
             }
         }
@@ -81,10 +102,13 @@ bool compare_by_name_and_version(const framework_info &a, const framework_info &
     std::sort(framework_infos->begin(), framework_infos->end(), compare_by_name_and_version);
 }
 
-/*static*/ bool framework_info::print_all_frameworks(const pal::string_t& own_dir, const pal::string_t& leading_whitespace)
+/*static*/ bool framework_info::print_all_frameworks(
+    const pal::string_t& own_dir,
+    const pal::string_t& leading_whitespace,
+    install_index_cache_t& install_indexes)
 {
     std::vector<framework_info> framework_infos;
-    get_all_framework_infos(own_dir, _X(""), &framework_infos);
+    get_all_framework_infos(own_dir, _X(""), install_indexes, &framework_infos);
     for (framework_info info : framework_infos)
     {
         trace::println(_X("%s%s %s [%s]"), leading_whitespace.c_str(), info.name.c_str(), info.version.as_str().c_str(), info.path.c_str());
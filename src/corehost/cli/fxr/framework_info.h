@@ -8,6 +8,8 @@
 #include "pal.h"
 #include "fx_ver.h"
 
+class install_index_cache_t;
+
 struct framework_info
 {
     framework_info(pal::string_t name, pal::string_t path, fx_ver_t version)
@@ -18,9 +20,13 @@ struct framework_info
     static void get_all_framework_infos(
         const pal::string_t& own_dir,
         const pal::string_t& fx_name,
+        install_index_cache_t& install_indexes,
         std::vector<framework_info>* framework_infos);
 
-    static bool print_all_frameworks(const pal::string_t& own_dir, const pal::string_t& leading_whitespace);
+    static bool print_all_frameworks(
+        const pal::string_t& own_dir,
+        const pal::string_t& leading_whitespace,
+        install_index_cache_t& install_indexes);
 
     pal::string_t name;
     pal::string_t path;
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <condition_variable>
 #include <mutex>
+#include <env_snapshot.h>
 #include <error_codes.h>
 #include <pal.h>
 #include <trace.h>
@@ -23,6 +24,7 @@
 #include "fx_ver.h"
 #include "host_startup_info.h"
 #include "hostpolicy_resolver.h"
+#include "install_index.h"
 #include "runtime_config.h"
 #include "sdk_info.h"
 #include "sdk_resolver.h"
@@ -215,7 +217,7 @@ void append_probe_realpath(const pal::string_t& path, std::vector<pal::string_t>
 {
     pal::string_t probe_path = path;
 
-    if (pal::realpath(&probe_path, true))
+    if (pal::realpath_cached(&probe_path, true))
     {
         realpaths->push_back(probe_path);
     }
@@ -238,7 +240,7 @@ void append_probe_realpath(const pal::string_t& path, std::vector<pal::string_t>
             segment.append(tfm);
             probe_path.replace(pos_placeholder, placeholder.length(), segment);
 
-            if (pal::realpath(&probe_path, true))
+            if (pal::realpath_cached(&probe_path, true))
             {
                 realpaths->push_back(probe_path);
             }
@@ -262,7 +264,7 @@ namespace
         pal::string_t& runtime_config,
         const runtime_config_t::settings_t& override_settings)
     {
-        if (!runtime_config.empty() && !pal::realpath(&runtime_config))
+        if (!runtime_config.empty() && !pal::realpath_cached(&runtime_config))
         {
             trace::error(_X("The specified runtimeconfig.json [%s] does not exist"), runtime_config.c_str());
             return StatusCode::InvalidConfigFile;
@@ -352,13 +354,14 @@ namespace
         const pal::string_t &app_candidate,
         const opt_map_t &opts,
         host_mode_t mode,
+        install_index_cache_t& install_indexes,
         /*out*/ pal::string_t &hostpolicy_dir,
         /*out*/ std::unique_ptr<corehost_init_t> &init)
     {
         pal::string_t runtime_config = command_line::get_option_value(opts, known_options::runtime_config, _X(""));
 
         pal::string_t deps_file = command_line::get_option_value(opts, known_options::deps_file, _X(""));
-        if (!deps_file.empty() && !pal::realpath(&deps_file))
+        if (!deps_file.empty() && !pal::realpath_cached(&deps_file))
         {
             trace::error(_X("The specified deps.json [%s] does not exist"), deps_file.c_str());
             return StatusCode::InvalidArgFailure;
@@ -435,7 +438,7 @@ namespace
             if (additional_deps_serialized.empty())
             {
                 // additional_deps_serialized stays empty if DOTNET_ADDITIONAL_DEPS env var is not defined
-                pal::getenv(_X("DOTNET_ADDITIONAL_DEPS"), &additional_deps_serialized);
+                env_snapshot::get(env_key_t::DOTNET_ADDITIONAL_DEPS, &additional_deps_serialized);
             }
 
             // If invoking using FX dotnet.exe, use own directory.
@@ -446,7 +449,7 @@ namespace
             }
             else
             {
-                rc = fx_resolver_t::resolve_frameworks_for_app(host_info, override_settings, app_config, fx_definitions);
+                rc = fx_resolver_t::resolve_frameworks_for_app(host_info, override_settings, app_config, install_indexes, fx_definitions);
                 if (rc != StatusCode::Success)
                 {
                     return rc;
@@ -461,12 +464,13 @@ namespace
         trace::verbose(_X("Executing as a %s app as per config file [%s]"),
             (is_framework_dependent ? _X("framework-dependent") : _X("self-contained")), app_config.get_path().c_str());
 
-        if (!hostpolicy_resolver::try_get_dir(mode, host_info.dotnet_root, fx_definitions, app_candidate, deps_file, probe_realpaths, &hostpolicy_dir))
+        std::unique_ptr<deps_json_t> root_deps;
+        if (!hostpolicy_resolver::try_get_dir(mode, host_info.dotnet_root, fx_definitions, app_candidate, deps_file, probe_realpaths, &hostpolicy_dir, &root_deps))
         {
             return CoreHostLibMissingFailure;
         }
 
-        init.reset(new corehost_init_t(host_command, host_info, deps_file, additional_deps_serialized, probe_realpaths, mode, fx_definitions));
+        init.reset(new corehost_init_t(host_command, host_info, deps_file, additional_deps_serialized, probe_realpaths, mode, fx_definitions, std::move(root_deps)));
 
         return StatusCode::Success;
     }
@@ -479,6 +483,7 @@ namespace
         int new_argc,
         const pal::char_t** new_argv,
         host_mode_t mode,
+        install_index_cache_t& install_indexes,
         pal::char_t out_buffer[],
         int32_t buffer_size,
         int32_t* required_buffer_size)
@@ -491,6 +496,7 @@ namespace
             app_candidate,
             opts,
             mode,
+            install_indexes,
             hostpolicy_dir,
             init);
         if (rc != StatusCode::Success)
@@ -528,10 +534,11 @@ int fx_muxer_t::execute(
     int new_argoff;
     pal::string_t app_candidate;
     opt_map_t opts;
+    install_index_cache_t install_indexes;
     int result = command_line::parse_args_for_mode(mode, host_info, argc, argv, &new_argoff, app_candidate, opts);
     if (static_cast<StatusCode>(result) == AppArgNotRunnable)
     {
-        return handle_cli(host_info, argc, argv);
+        return handle_cli(host_info, argc, argv, install_indexes);
     }
 
     if (!result)
@@ -546,6 +553,7 @@ int fx_muxer_t::execute(
             argv,
             new_argoff,
             mode,
+            install_indexes,
             result_buffer,
             buffer_size,
             required_buffer_size);
@@ -580,7 +588,8 @@ namespace
             return StatusCode::InvalidConfigFile;
         }
 
-        rc = fx_resolver_t::resolve_frameworks_for_app(host_info, override_settings, app_config, fx_definitions);
+        install_index_cache_t install_indexes;
+        rc = fx_resolver_t::resolve_frameworks_for_app(host_info, override_settings, app_config, install_indexes, fx_definitions);
         if (rc != StatusCode::Success)
             return rc;
 
@@ -589,13 +598,14 @@ namespace
         trace::verbose(_X("Libhost loading occurring for a framework-dependent component per config file [%s]"), app_config.get_path().c_str());
 
         const pal::string_t deps_file;
-        if (!hostpolicy_resolver::try_get_dir(mode, host_info.dotnet_root, fx_definitions, host_info.app_path, deps_file, probe_realpaths, &hostpolicy_dir))
+        std::unique_ptr<deps_json_t> root_deps;
+        if (!hostpolicy_resolver::try_get_dir(mode, host_info.dotnet_root, fx_definitions, host_info.app_path, deps_file, probe_realpaths, &hostpolicy_dir, &root_deps))
         {
             return StatusCode::CoreHostLibMissingFailure;
         }
 
         const pal::string_t additional_deps_serialized;
-        init.reset(new corehost_init_t(pal::string_t{}, host_info, deps_file, additional_deps_serialized, probe_realpaths, mode, fx_definitions));
+        init.reset(new corehost_init_t(pal::string_t{}, host_info, deps_file, additional_deps_serialized, probe_realpaths, mode, fx_definitions, std::move(root_deps)));
 
         return StatusCode::Success;
     }
@@ -691,6 +701,7 @@ int fx_muxer_t::initialize_for_app(
     }
 
     host_mode_t mode = host_mode_t::apphost;
+    install_index_cache_t install_indexes;
     pal::string_t hostpolicy_dir;
     std::unique_ptr<corehost_init_t> init;
     int rc = get_init_info_for_app(
@@ -699,6 +710,7 @@ int fx_muxer_t::initialize_for_app(
         host_info.app_path,
         opts,
         mode,
+        install_indexes,
         hostpolicy_dir,
         init);
     if (rc != StatusCode::Success)
@@ -928,6 +940,7 @@ int fx_muxer_t::handle_exec_host_command(
     const pal::char_t* argv[],
     int argoff,
     host_mode_t mode,
+    install_index_cache_t& install_indexes,
     pal::char_t result_buffer[],
     int32_t buffer_size,
     int32_t* required_buffer_size)
@@ -956,6 +969,7 @@ int fx_muxer_t::handle_exec_host_command(
         new_argc,
         new_argv,
         mode,
+        install_indexes,
         result_buffer,
         buffer_size,
         required_buffer_size);
@@ -964,17 +978,18 @@ int fx_muxer_t::handle_exec_host_command(
 int fx_muxer_t::handle_cli(
     const host_startup_info_t& host_info,
     int argc,
-    const pal::char_t* argv[])
+    const pal::char_t* argv[],
+    install_index_cache_t& install_indexes)
 {
     // Check for commands that don't depend on the CLI SDK to be loaded
     if (pal::strcasecmp(_X("--list-sdks"), argv[1]) == 0)
     {
-        sdk_info::print_all_sdks(host_info.dotnet_root, _X(""));
+        sdk_info::print_all_sdks(host_info.dotnet_root, _X(""), install_indexes);
         return StatusCode::Success;
     }
     else if (pal::strcasecmp(_X("--list-runtimes"), argv[1]) == 0)
     {
-        framework_info::print_all_frameworks(host_info.dotnet_root, _X(""));
+        framework_info::print_all_frameworks(host_info.dotnet_root, _X(""), install_indexes);
         return StatusCode::Success;
     }
 
@@ -982,7 +997,7 @@ int fx_muxer_t::handle_cli(
     // Did not exececute the app or run other commands, so try the CLI SDK dotnet.dll
     //
 
-    auto sdk_dotnet = sdk_resolver::from_nearest_global_file().resolve(host_info.dotnet_root);
+    auto sdk_dotnet = sdk_resolver::from_nearest_global_file().resolve(host_info.dotnet_root, install_indexes);
     if (sdk_dotnet.empty())
     {
         assert(argc > 1);
@@ -996,7 +1011,7 @@ int fx_muxer_t::handle_cli(
         }
         else if (pal::strcasecmp(_X("--info"), argv[1]) == 0)
         {
-            command_line::print_muxer_info(host_info.dotnet_root);
+            command_line::print_muxer_info(host_info.dotnet_root, install_indexes);
             return StatusCode::Success;
         }
 
@@ -1037,6 +1052,7 @@ int fx_muxer_t::handle_cli(
             new_argv.data(),
             new_argoff,
             host_mode_t::muxer,
+            install_indexes,
             nullptr /*result_buffer*/,
             0 /*buffer_size*/,
             nullptr/*required_buffer_size*/);
@@ -1044,7 +1060,7 @@ int fx_muxer_t::handle_cli(
 
     if (pal::strcasecmp(_X("--info"), argv[1]) == 0)
     {
-        command_line::print_muxer_info(host_info.dotnet_root);
+        command_line::print_muxer_info(host_info.dotnet_root, install_indexes);
     }
 
     return result;
@@ -10,6 +10,8 @@
 #include "host_interface.h"
 #include "host_startup_info.h"
 
+class install_index_cache_t;
+
 class fx_muxer_t
 {
 public:
@@ -48,11 +50,13 @@ private:
         const pal::char_t* argv[],
         int argoff,
         host_mode_t mode,
+        install_index_cache_t& install_indexes,
         pal::char_t result_buffer[],
         int32_t buffer_size,
         int32_t* required_buffer_size);
     static int handle_cli(
         const host_startup_info_t& host_info,
         int argc,
-        const pal::char_t* argv[]);
+        const pal::char_t* argv[],
+        install_index_cache_t& install_indexes);
 };
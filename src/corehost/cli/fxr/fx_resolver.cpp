@@ -4,6 +4,7 @@
 
 #include "fx_resolver.h"
 #include "host_startup_info.h"
+#include "install_index.h"
 #include "trace.h"
 
 namespace
@@ -16,6 +17,74 @@ namespace
     static_assert(roll_forward_option::Major > roll_forward_option::LatestMinor, "Code assumes ordering of roll-forward options from least restrictive to most restrictive");
     static_assert(roll_forward_option::LatestMajor > roll_forward_option::Major, "Code assumes ordering of roll-forward options from least restrictive to most restrictive");
 
+    typedef std::vector<fx_ver_t>::const_iterator version_iterator;
+
+    // Returns how many of the major, minor and patch numbers a higher version has to share with the
+    // framework reference to be compatible with it.
+    int get_fixed_parts(const fx_reference_t& fx_ref)
+    {
+        switch (fx_ref.get_version_compatibility_range())
+        {
+        case version_compatibility_range_t::major:
+            return 0;
+        case version_compatibility_range_t::minor:
+            return 1;
+        case version_compatibility_range_t::patch:
+            return fx_ref.get_apply_patches() ? 2 : 3;
+        default:
+            return 3;
+        }
+    }
+
+    // Compares the first parts of the major, minor and patch numbers of the versions
+    bool is_lower_in_parts(const fx_ver_t& a, const fx_ver_t& b, int parts)
+    {
+        if (parts > 0 && a.get_major() != b.get_major())
+        {
+            return a.get_major() < b.get_major();
+        }
+
+        if (parts > 1 && a.get_minor() != b.get_minor())
+        {
+            return a.get_minor() < b.get_minor();
+        }
+
+        return parts > 2 && a.get_patch() < b.get_patch();
+    }
+
+    // Returns the end of the versions in the sorted range [first, last), which have the same first parts
+    // of the major, minor and patch numbers as the given version. Versions before first must be lower.
+    version_iterator end_of_same_parts(version_iterator first, version_iterator last, const fx_ver_t& ver, int parts)
+    {
+        return std::upper_bound(first, last, ver,
+            [parts](const fx_ver_t& a, const fx_ver_t& b) { return is_lower_in_parts(a, b, parts); });
+    }
+
+    // Returns the lowest version in the sorted range which is a release version if release_only is set, or last if there is none
+    version_iterator find_lowest(version_iterator first, version_iterator last, bool release_only)
+    {
+        return std::find_if(first, last, [release_only](const fx_ver_t& ver) { return !release_only || !ver.is_prerelease(); });
+    }
+
+    // Returns the highest version in the sorted range which is a release version if release_only is set, or last if there is none
+    version_iterator find_highest(version_iterator first, version_iterator last, bool release_only)
+    {
+        for (version_iterator it = last; it != first;)
+        {
+            --it;
+            if (!release_only || !it->is_prerelease())
+            {
+                return it;
+            }
+        }
+
+        return last;
+    }
+
+    // The version lists are sorted, and the versions which are compatible with a framework reference (or which
+    // the reference can roll to as a patch) form one range of them, so the searches only look at the ends of the
+    // range. Versions which are equal but differ in the build label keep their directory listing order, and the
+    // searches pick the same one of them as a scan of the directory listing would.
     fx_ver_t search_for_best_framework_match_without_roll_to_latest_patch(
         const std::vector<fx_ver_t>& version_list,
         const fx_reference_t& fx_ref,
@@ -39,28 +108,24 @@ namespace
                 release_only ? _X("release") : _X("release/pre-release"),
                 fx_ref.get_fx_version().c_str());
 
-            for (const auto& ver : version_list)
-            {
-                if ((!release_only || !ver.is_prerelease()) && ver >= fx_ref.get_fx_version_number())
-                {
-                    // Ignore incompatible versions
-                    if (!fx_ref.is_compatible_with_higher_version(ver))
-                    {
-                        continue;
-                    }
-
-                    best_match_version = (best_match_version == fx_ver_t())
-                        ? ver
-                        : (roll_to_highest_version ? std::max(best_match_version, ver) : std::min(best_match_version, ver));
-                }
-            }
+            // Compatible versions are greater than or equal to the reference and share the numbers with it
+            // which the compatibility range doesn't allow to roll forward over.
+            const fx_ver_t& fx_ver = fx_ref.get_fx_version_number();
+            version_iterator first = std::lower_bound(version_list.begin(), version_list.end(), fx_ver);
+            version_iterator last = end_of_same_parts(first, version_list.end(), fx_ver, get_fixed_parts(fx_ref));
 
-            if (best_match_version == fx_ver_t())
+            version_iterator match = roll_to_highest_version
+                ? find_highest(first, last, release_only)
+                : find_lowest(first, last, release_only);
+
+            if (match == last)
             {
                 trace::verbose(_X("No match greater than or equal to [%s] found."), fx_ref.get_fx_version().c_str());
             }
             else
             {
+                // Of equal versions the first one listed wins
+                best_match_version = *std::lower_bound(first, match, *match);
                 trace::verbose(_X("Found version [%s]"), best_match_version.as_str().c_str());
             }
         }
@@ -95,19 +160,15 @@ namespace
                 apply_patch_from_version.as_str().c_str(),
                 release_only ? _X("release only") : _X("release/pre-release"));
 
-            for (const auto& ver : version_list)
-            {
-                trace::verbose(_X("Inspecting version... [%s]"), ver.as_str().c_str());
+            // Pick the greatest that differs only in patch, or only in the pre-release label if patches are not applied.
+            version_iterator first = std::lower_bound(version_list.begin(), version_list.end(), apply_patch_from_version);
+            version_iterator last = end_of_same_parts(first, version_list.end(), apply_patch_from_version, fx_ref.get_apply_patches() ? 2 : 3);
 
-                if ((!release_only || !ver.is_prerelease()) &&
-                    (fx_ref.get_apply_patches() || ver.get_patch() == apply_patch_from_version.get_patch()) &&
-                    ver >= apply_patch_from_version &&
-                    ver.get_major() == apply_patch_from_version.get_major() &&
-                    ver.get_minor() == apply_patch_from_version.get_minor())
-                {
-                    // Pick the greatest that differs only in patch.
-                    best_match_version = std::max(ver, best_match_version);
-                }
+            // Of equal versions the last one listed wins
+            version_iterator match = find_highest(first, last, release_only);
+            if (match != last && *match >= best_match_version)
+            {
+                best_match_version = *match;
             }
         }
 
@@ -178,114 +239,182 @@ namespace
 
         return best_match;
     }
+}
 
-    fx_definition_t* resolve_framework_reference(
-        const fx_reference_t & fx_ref,
-        const pal::string_t & oldest_requested_version,
-        const pal::string_t & dotnet_dir)
-    {
+fx_definition_t* fx_resolver_t::resolve_framework_reference(
+    const fx_reference_t & fx_ref,
+    const pal::string_t & oldest_requested_version,
+    const pal::string_t & dotnet_dir)
+{
 #if defined(DEBUG)
-        assert(!fx_ref.get_fx_name().empty());
-        assert(!fx_ref.get_fx_version().empty());
+    assert(!fx_ref.get_fx_name().empty());
+    assert(!fx_ref.get_fx_version().empty());
 
-        fx_ver_t _debug_ver;
-        assert(fx_ver_t::parse(fx_ref.get_fx_version(), &_debug_ver, false));
-        assert(_debug_ver == fx_ref.get_fx_version_number());
+    fx_ver_t _debug_ver;
+    assert(fx_ver_t::parse(fx_ref.get_fx_version(), &_debug_ver, false));
+    assert(_debug_ver == fx_ref.get_fx_version_number());
 #endif // defined(DEBUG)
 
-        trace::verbose(_X("--- Resolving FX directory, name '%s' version '%s'"),
-            fx_ref.get_fx_name().c_str(), fx_ref.get_fx_version().c_str());
+    trace::verbose(_X("--- Resolving FX directory, name '%s' version '%s'"),
+        fx_ref.get_fx_name().c_str(), fx_ref.get_fx_version().c_str());
 
-        std::vector<pal::string_t> hive_dir;
-        get_framework_and_sdk_locations(dotnet_dir, &hive_dir);
+    std::vector<pal::string_t> hive_dir;
+    get_framework_and_sdk_locations(dotnet_dir, &hive_dir);
 
-        pal::string_t selected_fx_dir;
-        pal::string_t selected_fx_version;
-        fx_ver_t selected_ver;
+    pal::string_t selected_fx_dir;
+    pal::string_t selected_fx_version;
+    fx_ver_t selected_ver;
 
-        for (pal::string_t dir : hive_dir)
+    for (pal::string_t dir : hive_dir)
+    {
+        auto fx_dir = dir;
+        trace::verbose(_X("Searching FX directory in [%s]"), fx_dir.c_str());
+
+        append_path(&fx_dir, _X("shared"));
+        append_path(&fx_dir, fx_ref.get_fx_name().c_str());
+
+        // Roll forward is disabled when:
+        //   roll_forward is set to Disable
+        //   roll_forward is set to LatestPatch AND
+        //     apply_patches is false AND
+        //     release framework reference (this is for backward compat with pre-release rolling over pre-release portion of version ignoring apply_patches)
+        //   use exact version is set (this is when --fx-version was used on the command line)
+        if ((fx_ref.get_version_compatibility_range() == version_compatibility_range_t::exact) ||
+            ((fx_ref.get_version_compatibility_range() == version_compatibility_range_t::patch) && (!fx_ref.get_apply_patches() && !fx_ref.get_fx_version_number().is_prerelease())))
         {
-            auto fx_dir = dir;
-            trace::verbose(_X("Searching FX directory in [%s]"), fx_dir.c_str());
-
-            append_path(&fx_dir, _X("shared"));
-            append_path(&fx_dir, fx_ref.get_fx_name().c_str());
-
-            // Roll forward is disabled when:
-            //   roll_forward is set to Disable
-            //   roll_forward is set to LatestPatch AND
-            //     apply_patches is false AND
-            //     release framework reference (this is for backward compat with pre-release rolling over pre-release portion of version ignoring apply_patches)
-            //   use exact version is set (this is when --fx-version was used on the command line)
-            if ((fx_ref.get_version_compatibility_range() == version_compatibility_range_t::exact) ||
-                ((fx_ref.get_version_compatibility_range() == version_compatibility_range_t::patch) && (!fx_ref.get_apply_patches() && !fx_ref.get_fx_version_number().is_prerelease())))
+            trace::verbose(
+                _X("Did not roll forward because apply_patches=%d, version_compatibility_range=%s chose [%s]"),
+                fx_ref.get_apply_patches(),
+                version_compatibility_range_to_string(fx_ref.get_version_compatibility_range()).c_str(),
+                fx_ref.get_fx_version().c_str());
+
+            append_path(&fx_dir, fx_ref.get_fx_version().c_str());
+            if (directory_exists(fx_dir))
             {
-                trace::verbose(
-                    _X("Did not roll forward because apply_patches=%d, version_compatibility_range=%s chose [%s]"),
-                    fx_ref.get_apply_patches(),
-                    version_compatibility_range_to_string(fx_ref.get_version_compatibility_range()).c_str(),
-                    fx_ref.get_fx_version().c_str());
-
-                append_path(&fx_dir, fx_ref.get_fx_version().c_str());
-                if (pal::directory_exists(fx_dir))
-                {
-                    selected_fx_dir = fx_dir;
-                    selected_fx_version = fx_ref.get_fx_version();
-                    break;
-                }
+                selected_fx_dir = fx_dir;
+                selected_fx_version = fx_ref.get_fx_version();
+                break;
             }
-            else
-            {
-                std::vector<pal::string_t> list;
-                std::vector<fx_ver_t> version_list;
-                pal::readdir_onlydirectories(fx_dir, &list);
+        }
+        else
+        {
+            const std::vector<fx_ver_t>& version_list = get_framework_versions(dir, fx_dir, fx_ref.get_fx_name());
 
-                for (const auto& version : list)
-                {
-                    fx_ver_t ver;
-                    if (fx_ver_t::parse(version, &ver, false))
-                    {
-                        version_list.push_back(ver);
-                    }
-                }
+            fx_ver_t resolved_ver = resolve_framework_reference_from_version_list(version_list, fx_ref);
 
-                fx_ver_t resolved_ver = resolve_framework_reference_from_version_list(version_list, fx_ref);
+            pal::string_t resolved_ver_str = resolved_ver.as_str();
+            append_path(&fx_dir, resolved_ver_str.c_str());
 
-                pal::string_t resolved_ver_str = resolved_ver.as_str();
-                append_path(&fx_dir, resolved_ver_str.c_str());
+            if (directory_exists(fx_dir))
+            {
+                if (selected_ver != fx_ver_t())
+                {
+                    // Compare the previous hive_dir selection with the current hive_dir to see which one is the better match
+                    std::vector<fx_ver_t> version_list;
+                    version_list.push_back(resolved_ver);
+                    version_list.push_back(selected_ver);
+                    std::stable_sort(version_list.begin(), version_list.end());
+                    resolved_ver = resolve_framework_reference_from_version_list(version_list, fx_ref);
+                }
 
-                if (pal::directory_exists(fx_dir))
+                if (resolved_ver != selected_ver)
                 {
-                    if (selected_ver != fx_ver_t())
-                    {
-                        // Compare the previous hive_dir selection with the current hive_dir to see which one is the better match
-                        std::vector<fx_ver_t> version_list;
-                        version_list.push_back(resolved_ver);
-                        version_list.push_back(selected_ver);
-                        resolved_ver = resolve_framework_reference_from_version_list(version_list, fx_ref);
-                    }
-
-                    if (resolved_ver != selected_ver)
-                    {
-                        trace::verbose(_X("Changing Selected FX version from [%s] to [%s]"), selected_fx_dir.c_str(), fx_dir.c_str());
-                        selected_ver = resolved_ver;
-                        selected_fx_dir = fx_dir;
-                        selected_fx_version = resolved_ver_str;
-                    }
+                    trace::verbose(_X("Changing Selected FX version from [%s] to [%s]"), selected_fx_dir.c_str(), fx_dir.c_str());
+                    selected_ver = resolved_ver;
+                    selected_fx_dir = fx_dir;
+                    selected_fx_version = resolved_ver_str;
                 }
             }
         }
+    }
+
+    if (selected_fx_dir.empty())
+    {
+        trace::error(_X("It was not possible to find any compatible framework version"));
+        return nullptr;
+    }
+
+    trace::verbose(_X("Chose FX version [%s]"), selected_fx_dir.c_str());
+
+    return new fx_definition_t(fx_ref.get_fx_name(), selected_fx_dir, oldest_requested_version, selected_fx_version);
+}
+
+const std::vector<fx_ver_t>& fx_resolver_t::get_framework_versions(
+    const pal::string_t& dotnet_dir,
+    const pal::string_t& fx_dir,
+    const pal::string_t& fx_name)
+{
+    auto existing = m_framework_versions.find(fx_dir);
+    if (existing != m_framework_versions.end())
+    {
+        return existing->second;
+    }
 
-        if (selected_fx_dir.empty())
+    trace::verbose(_X("Reading FX versions in [%s]"), fx_dir.c_str());
+
+    std::vector<fx_ver_t>& version_list = m_framework_versions[fx_dir];
+    const install_index_t::framework_t* indexed = nullptr;
+    const install_index_t* index = m_install_indexes.get(dotnet_dir);
+    if (index != nullptr)
+    {
+        indexed = index->find_framework(fx_name);
+    }
+
+    if (indexed != nullptr)
+    {
+        version_list = indexed->versions;
+    }
+    else
+    {
+        std::vector<pal::string_t> list;
+        pal::readdir_onlydirectories(fx_dir, &list);
+
+        for (const auto& version : list)
         {
-            trace::error(_X("It was not possible to find any compatible framework version"));
-            return nullptr;
+            fx_ver_t ver;
+            if (fx_ver_t::parse(version, &ver, false))
+            {
+                version_list.push_back(ver);
+            }
         }
+    }
 
-        trace::verbose(_X("Chose FX version [%s]"), selected_fx_dir.c_str());
+    // The searches rely on the versions being sorted, with equal versions in their listing order
+    std::stable_sort(version_list.begin(), version_list.end());
+    return version_list;
+}
 
-        return new fx_definition_t(fx_ref.get_fx_name(), selected_fx_dir, oldest_requested_version, selected_fx_version);
+bool fx_resolver_t::directory_exists(const pal::string_t& dir)
+{
+    auto existing = m_existing_directories.find(dir);
+    if (existing != m_existing_directories.end())
+    {
+        return existing->second;
     }
+
+    bool exists = pal::directory_exists(dir);
+    m_existing_directories[dir] = exists;
+    return exists;
+}
+
+void fx_resolver_t::read_runtime_config(
+    fx_definition_t& fx,
+    const runtime_config_t::settings_t& override_settings)
+{
+    pal::string_t config_file;
+    pal::string_t dev_config_file;
+    get_runtime_config_paths(fx.get_dir(), fx.get_name(), &config_file, &dev_config_file);
+
+    // The override settings are the same for the whole resolution, so the file path identifies the result
+    auto existing = m_runtime_configs.find(config_file);
+    if (existing != m_runtime_configs.end())
+    {
+        fx.set_runtime_config(existing->second);
+        return;
+    }
+
+    fx.parse_runtime_config(config_file, dev_config_file, override_settings);
+    m_runtime_configs.emplace(config_file, fx.get_runtime_config());
 }
 
 StatusCode fx_resolver_t::reconcile_fx_references_helper(
@@ -434,7 +563,7 @@ StatusCode fx_resolver_t::read_framework(
             fx_definition_t* fx = resolve_framework_reference(new_effective_fx_ref, m_oldest_fx_references[fx_name].get_fx_version(), host_info.dotnet_root);
             if (fx == nullptr)
             {
-                display_missing_framework_error(fx_name, new_effective_fx_ref.get_fx_version(), pal::string_t(), host_info.dotnet_root);
+                display_missing_framework_error(fx_name, new_effective_fx_ref.get_fx_version(), pal::string_t(), host_info.dotnet_root, m_install_indexes);
                 return FrameworkMissingFailure;
             }
 
@@ -451,10 +580,7 @@ StatusCode fx_resolver_t::read_framework(
             fx_definitions.push_back(std::unique_ptr<fx_definition_t>(fx));
 
             // Recursively process the base frameworks
-            pal::string_t config_file;
-            pal::string_t dev_config_file;
-            get_runtime_config_paths(fx->get_dir(), fx_name, &config_file, &dev_config_file);
-            fx->parse_runtime_config(config_file, dev_config_file, override_settings);
+            read_runtime_config(*fx, override_settings);
 
             runtime_config_t new_config = fx->get_runtime_config();
             if (!new_config.is_valid())
@@ -497,7 +623,8 @@ StatusCode fx_resolver_t::read_framework(
     return rc;
 }
 
-fx_resolver_t::fx_resolver_t()
+fx_resolver_t::fx_resolver_t(install_index_cache_t& install_indexes)
+    : m_install_indexes(install_indexes)
 {
 }
 
@@ -505,9 +632,10 @@ StatusCode fx_resolver_t::resolve_frameworks_for_app(
     const host_startup_info_t & host_info,
     const runtime_config_t::settings_t& override_settings,
     const runtime_config_t & app_config,
+    install_index_cache_t& install_indexes,
     fx_definition_vector_t & fx_definitions)
 {
-    fx_resolver_t resolver;
+    fx_resolver_t resolver(install_indexes);
 
     // Read the shared frameworks; retry is necessary when a framework is already resolved, but then a newer compatible version is processed.
     StatusCode rc = StatusCode::Success;
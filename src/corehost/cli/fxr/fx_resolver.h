@@ -9,6 +9,7 @@
 #include "fx_reference.h"
 #include "fx_definition.h"
 
+class install_index_cache_t;
 class runtime_config_t;
 struct host_startup_info_t;
 
@@ -19,6 +20,7 @@ public:
         const host_startup_info_t& host_info,
         const runtime_config_t::settings_t& override_settings,
         const runtime_config_t& app_config,
+        install_index_cache_t& install_indexes,
         fx_definition_vector_t& fx_definitions);
 
     static bool is_config_compatible_with_frameworks(
@@ -26,7 +28,7 @@ public:
         const std::unordered_map<pal::string_t, const fx_ver_t> &existing_framework_versions_by_name);
 
 private:
-    fx_resolver_t();
+    fx_resolver_t(install_index_cache_t& install_indexes);
 
     void update_newest_references(
         const runtime_config_t& config);
@@ -37,6 +39,22 @@ private:
         const fx_reference_t * effective_parent_fx_ref,
         fx_definition_vector_t& fx_definitions);
 
+    fx_definition_t* resolve_framework_reference(
+        const fx_reference_t& fx_ref,
+        const pal::string_t& oldest_requested_version,
+        const pal::string_t& dotnet_dir);
+
+    // Reading the disk is memoized for the whole resolution, so that retries of read_framework
+    // only recompute the resolution in memory.
+    const std::vector<fx_ver_t>& get_framework_versions(
+        const pal::string_t& dotnet_dir,
+        const pal::string_t& fx_dir,
+        const pal::string_t& fx_name);
+    bool directory_exists(const pal::string_t& dir);
+    void read_runtime_config(
+        fx_definition_t& fx,
+        const runtime_config_t::settings_t& override_settings);
+
     static StatusCode reconcile_fx_references_helper(
         const fx_reference_t& lower_fx_ref,
         const fx_reference_t& higher_fx_ref,
@@ -50,7 +68,8 @@ private:
         const pal::string_t& fx_name,
         const pal::string_t& fx_version,
         const pal::string_t& fx_dir,
-        const pal::string_t& dotnet_root);
+        const pal::string_t& dotnet_root,
+        install_index_cache_t& install_indexes);
     static void display_incompatible_framework_error(
         const pal::string_t& higher,
         const fx_reference_t& lower);
@@ -79,6 +98,18 @@ private:
     // to fill the "oldest reference" for each resolved framework in the end. It does not affect the behavior
     // of the algorithm.
     fx_name_to_fx_reference_map_t m_oldest_fx_references;
+
+    // Map of FX directory -> versions found in it, in ascending order
+    std::unordered_map<pal::string_t, std::vector<fx_ver_t>> m_framework_versions;
+
+    // Indexes of the install locations, shared with the rest of the hostfxr call
+    install_index_cache_t& m_install_indexes;
+
+    // Map of directory -> whether it exists
+    std::unordered_map<pal::string_t, bool> m_existing_directories;
+
+    // Map of runtime config path -> parsed framework runtime config
+    std::unordered_map<pal::string_t, runtime_config_t> m_runtime_configs;
 };
 
 #endif // __FX_RESOLVER_H__
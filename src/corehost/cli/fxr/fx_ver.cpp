@@ -7,7 +7,117 @@
 #include "utils.h"
 #include "fx_ver.h"
 
-static bool validIdentifiers(const pal::string_t& ids);
+static bool validIdentifiers(const pal::char_t* ids, size_t length);
+
+namespace
+{
+    // Releases order after all prereleases
+    const uint64_t release_key = UINT64_MAX;
+
+    // Numeric identifiers order before text ones. The keys of text identifiers have the top bit set.
+    const uint64_t text_key_flag = 1ull << 63;
+
+    // Numeric identifiers with more digits than fit into the key all get this key
+    const size_t numeric_key_max_digits = 18;
+    const uint64_t numeric_key_max = 1000000000000000000ull;
+
+    // Characters of a text identifier which are part of the key, 7 bits each
+    const size_t text_key_chars = 8;
+
+    bool is_numeric(const pal::char_t* id, size_t length)
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (id[i] < _X('0') || id[i] > _X('9'))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t find_dot(const pal::string_t& ids, size_t start)
+    {
+        size_t dot = ids.find(_X('.'), start);
+        return dot == pal::string_t::npos ? ids.length() : dot;
+    }
+
+    int compare_identifiers(const pal::char_t* a, size_t a_length, const pal::char_t* b, size_t b_length)
+    {
+        bool a_is_num = is_numeric(a, a_length);
+        bool b_is_num = is_numeric(b, b_length);
+
+        if (a_is_num && b_is_num)
+        {
+            // Numeric identifiers have no leading zeros, so a longer one is the larger number
+            if (a_length != b_length)
+            {
+                return (a_length > b_length) ? 1 : -1;
+            }
+        }
+        else if (a_is_num || b_is_num)
+        {
+            // Mixed compare.  Spec: Number < Text
+            return b_is_num ? 1 : -1;
+        }
+
+        // Ascii compare, which is also the numeric one for numbers of the same length
+        size_t length = std::min(a_length, b_length);
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (a[i] != b[i])
+            {
+                return (a[i] > b[i]) ? 1 : -1;
+            }
+        }
+
+        return (a_length == b_length) ? 0 : (a_length > b_length) ? 1 : -1;
+    }
+
+    int compare_prerelease(const pal::string_t& a, const pal::string_t& b)
+    {
+        // First character of pre is '-' when it is not empty
+        assert(a[0] == _X('-'));
+        assert(b[0] == _X('-'));
+
+        // First idenitifier starts at position 1
+        size_t a_start = 1;
+        size_t b_start = 1;
+        while (true)
+        {
+            size_t a_end = find_dot(a, a_start);
+            size_t b_end = find_dot(b, b_start);
+
+            int result = compare_identifiers(&a[a_start], a_end - a_start, &b[b_start], b_end - b_start);
+            if (result != 0)
+            {
+                return result;
+            }
+
+            bool a_has_more = a_end < a.length();
+            bool b_has_more = b_end < b.length();
+            if (!a_has_more || !b_has_more)
+            {
+                // The version with an additional identifier is the greater one
+                return (a_has_more == b_has_more) ? 0 : a_has_more ? 1 : -1;
+            }
+
+            a_start = a_end + 1;
+            b_start = b_end + 1;
+        }
+    }
+
+    // Writes "major.minor.patch" and returns its length. The buffer must have room for 35 characters.
+    size_t write_numbers(int major, int minor, int patch, pal::char_t* buffer)
+    {
+        size_t length = write_int(major, buffer);
+        buffer[length++] = _X('.');
+        length += write_int(minor, buffer + length);
+        buffer[length++] = _X('.');
+        length += write_int(patch, buffer + length);
+        return length;
+    }
+}
 
 fx_ver_t::fx_ver_t(int major, int minor, int patch, const pal::string_t& pre, const pal::string_t& build)
     : m_major(major)
@@ -15,13 +125,14 @@ fx_ver_t::fx_ver_t(int major, int minor, int patch, const pal::string_t& pre, co
     , m_patch(patch)
     , m_pre(pre)
     , m_build(build)
+    , m_pre_key(get_prerelease_key(pre))
 {
     // verify preconditions
     assert(is_empty() || m_major >= 0);
     assert(is_empty() || m_minor >= 0);
     assert(is_empty() || m_patch >= 0);
-    assert(m_pre[0] == 0 || validIdentifiers(m_pre));
-    assert(m_build[0] == 0 || validIdentifiers(m_build));
+    assert(m_pre[0] == 0 || validIdentifiers(m_pre.c_str(), m_pre.length()));
+    assert(m_build[0] == 0 || validIdentifiers(m_build.c_str(), m_build.length()));
 }
 
 fx_ver_t::fx_ver_t(int major, int minor, int patch, const pal::string_t& pre)
@@ -71,38 +182,90 @@ bool fx_ver_t::operator >=(const fx_ver_t& b) const
 
 pal::string_t fx_ver_t::as_str() const
 {
-    pal::stringstream_t stream;
-    stream << m_major << _X(".") << m_minor << _X(".") << m_patch;
-    if (!m_pre.empty())
-    {
-        stream << m_pre;
-    }
-    if (!m_build.empty())
+    pal::char_t numbers[35];
+    size_t length = write_numbers(m_major, m_minor, m_patch, numbers);
+
+    pal::string_t str;
+    str.reserve(length + m_pre.length() + m_build.length());
+    str.append(numbers, length);
+    str.append(m_pre);
+    str.append(m_build);
+    return str;
+}
+
+size_t fx_ver_t::as_str(pal::char_t* buffer, size_t size) const
+{
+    pal::char_t numbers[35];
+    size_t length = write_numbers(m_major, m_minor, m_patch, numbers);
+
+    size_t total = length + m_pre.length() + m_build.length();
+    if (total < size)
     {
-        stream << m_build;
+        std::copy(numbers, numbers + length, buffer);
+        m_pre.copy(buffer + length, m_pre.length());
+        m_build.copy(buffer + length + m_pre.length(), m_build.length());
+        buffer[total] = 0;
     }
-    return stream.str();
+
+    return total;
 }
 
 pal::string_t fx_ver_t::prerelease_glob() const
 {
-    pal::stringstream_t stream;
-    stream << m_major << _X(".") << m_minor << _X(".") << m_patch << _X("-*");
-    return stream.str();
+    pal::char_t buffer[37];
+    size_t length = write_numbers(m_major, m_minor, m_patch, buffer);
+    buffer[length++] = _X('-');
+    buffer[length++] = _X('*');
+    return pal::string_t(buffer, length);
 }
 
 pal::string_t fx_ver_t::patch_glob() const
 {
-    pal::stringstream_t stream;
-    stream << m_major << _X(".") << m_minor << _X(".*");
-    return stream.str();
+    pal::char_t buffer[25];
+    size_t length = write_int(m_major, buffer);
+    buffer[length++] = _X('.');
+    length += write_int(m_minor, buffer + length);
+    buffer[length++] = _X('.');
+    buffer[length++] = _X('*');
+    return pal::string_t(buffer, length);
 }
 
-static pal::string_t getId(const pal::string_t &ids, size_t idStart)
+/* static */
+uint64_t fx_ver_t::get_prerelease_key(const pal::string_t& pre)
 {
-    size_t next = ids.find(_X('.'), idStart);
+    if (pre.empty())
+    {
+        return release_key;
+    }
+
+    // The key is made from the first identifier only. Keys of different identifiers are ordered
+    // the same as the identifiers, or are equal if the key can't tell them apart.
+    const pal::char_t* id = pre.c_str() + 1;
+    size_t length = find_dot(pre, 1) - 1;
+
+    if (is_numeric(id, length))
+    {
+        if (length > numeric_key_max_digits)
+        {
+            return numeric_key_max;
+        }
 
-    return next == pal::string_t::npos ? ids.substr(idStart) : ids.substr(idStart, next - idStart);
+        uint64_t key = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            key = key * 10 + static_cast<uint64_t>(id[i] - _X('0'));
+        }
+        return key;
+    }
+
+    // Identifier characters are ASCII. Shorter identifiers are padded with zeros, which order
+    // before any character, the same as a prefix orders before a longer identifier.
+    uint64_t key = text_key_flag;
+    for (size_t i = 0; i < text_key_chars && i < length; ++i)
+    {
+        key |= static_cast<uint64_t>(id[i] & 0x7f) << (7 * (text_key_chars - 1 - i));
+    }
+    return key;
 }
 
 /* static */
@@ -124,77 +287,22 @@ int fx_ver_t::compare(const fx_ver_t&a, const fx_ver_t& b)
         return (a.m_patch > b.m_patch) ? 1 : -1;
     }
 
-    if (a.m_pre.empty() || b.m_pre.empty())
+    if (a.m_pre_key != b.m_pre_key)
     {
-        // Either a is empty or b is empty or both are empty
-        return a.m_pre.empty() ? !b.m_pre.empty() : -1;
+        return (a.m_pre_key > b.m_pre_key) ? 1 : -1;
     }
 
-    // Both are non-empty (may be equal)
-
-    // First character of pre is '-' when it is not empty
-    assert(a.m_pre[0] == _X('-'));
-    assert(b.m_pre[0] == _X('-'));
-
-    // First idenitifier starts at position 1
-    size_t idStart = 1;
-    for (size_t i = idStart; true; ++i)
+    if (a.m_pre_key == release_key)
     {
-        if (a.m_pre[i] != b.m_pre[i])
-        {
-            // Found first character with a difference
-            if (a.m_pre[i] == 0 && b.m_pre[i] == _X('.'))
-            {
-                // identifiers both complete, b has an additional idenitifier
-                return -1;
-            }
-
-            if (b.m_pre[i] == 0 && a.m_pre[i] == _X('.'))
-            {
-                // identifiers both complete, a has an additional idenitifier
-                return 1;
-            }
-
-            // identifiers must not be empty
-            pal::string_t ida = getId(a.m_pre, idStart);
-            pal::string_t idb = getId(b.m_pre, idStart);
-
-            unsigned idanum = 0;
-            bool idaIsNum = try_stou(ida, &idanum);
-            unsigned idbnum = 0;
-            bool idbIsNum = try_stou(idb, &idbnum);
-
-            if (idaIsNum && idbIsNum)
-            {
-                // Numeric comparison
-                return (idanum > idbnum) ? 1 : -1;
-            }
-            else if (idaIsNum || idbIsNum)
-            {
-                // Mixed compare.  Spec: Number < Text
-                return idbIsNum ? 1 : -1;
-            }
-            // Ascii compare
-            return ida.compare(idb);
-        }
-        else
-        {
-            // a.m_pre[i] == b.m_pre[i]
-            if (a.m_pre[i] == 0)
-            {
-                break;
-            }
-            if (a.m_pre[i] == _X('.'))
-            {
-                idStart = i + 1;
-            }
-        }
+        // Neither is a prerelease
+        return 0;
     }
 
-    return 0;
+    // Both are prereleases with the same key (may be equal)
+    return compare_prerelease(a.m_pre, b.m_pre);
 }
 
-static bool validIdentifierCharSet(const pal::string_t& id)
+static bool validIdentifierCharSet(const pal::char_t* id, size_t length)
 {
     // ids must be of the set [0-9a-zA-Z-]
 
@@ -206,7 +314,7 @@ static bool validIdentifierCharSet(const pal::string_t& id)
     static_assert(_X('Z') < _X('a'), "Code assumes ordering - < 0 < 9 < A < Z < a < z");
     static_assert(_X('a') < _X('z'), "Code assumes ordering - < 0 < 9 < A < Z < a < z");
 
-    for (size_t i = 0; id[i] != 0; ++i)
+    for (size_t i = 0; i < length; ++i)
     {
         if (id[i] >= _X('A'))
         {
@@ -226,21 +334,21 @@ static bool validIdentifierCharSet(const pal::string_t& id)
     return true;
 }
 
-static bool validIdentifier(const pal::string_t& id, bool buildMeta)
+static bool validIdentifier(const pal::char_t* id, size_t length, bool buildMeta)
 {
-    if (id.empty())
+    if (length == 0)
     {
         // Identifier must not be empty
         return false;
     }
 
-    if (!validIdentifierCharSet(id))
+    if (!validIdentifierCharSet(id, length))
     {
         // ids must be of the set [0-9a-zA-Z-]
         return false;
     }
 
-    if (!buildMeta && id[0] == _X('0') && id[1] != 0 && index_of_non_numeric(id, 1) == pal::string_t::npos)
+    if (!buildMeta && id[0] == _X('0') && length > 1 && is_numeric(id, length))
     {
         // numeric identifiers must not be padded with 0s
         return false;
@@ -248,9 +356,9 @@ static bool validIdentifier(const pal::string_t& id, bool buildMeta)
     return true;
 }
 
-static bool validIdentifiers(const pal::string_t& ids)
+static bool validIdentifiers(const pal::char_t* ids, size_t length)
 {
-    if (ids.empty())
+    if (length == 0)
     {
         return true;
     }
@@ -265,17 +373,19 @@ static bool validIdentifiers(const pal::string_t& ids)
     }
 
     size_t idStart = 1;
-    size_t nextId;
-    while ((nextId = ids.find(_X('.'), idStart)) != pal::string_t::npos)
+    for (size_t i = idStart; i < length; ++i)
     {
-        if (!validIdentifier(ids.substr(idStart, nextId - idStart), buildMeta))
+        if (ids[i] == _X('.'))
         {
-            return false;
+            if (!validIdentifier(ids + idStart, i - idStart, buildMeta))
+            {
+                return false;
+            }
+            idStart = i + 1;
         }
-        idStart = nextId + 1;
     }
 
-    if (!validIdentifier(ids.substr(idStart), buildMeta))
+    if (!validIdentifier(ids + idStart, length - idStart, buildMeta))
     {
         return false;
     }
@@ -283,7 +393,21 @@ static bool validIdentifiers(const pal::string_t& ids)
     return true;
 }
 
-bool parse_internal(const pal::string_t& ver, fx_ver_t* fx_ver, bool parse_only_production)
+static bool parse_number(const pal::string_t& ver, size_t start, size_t end, unsigned* num)
+{
+    if (end - start > 1 && ver[start] == _X('0'))
+    {
+        // if leading character is 0, and strlen > 1
+        // then the numeric substring has leading zeroes which is prohibited by the specification.
+        return false;
+    }
+
+    return try_stou(ver.c_str() + start, end - start, num);
+}
+
+// Finds the parts of the version without copying them. The prerelease label is [pre_start, build_start)
+// and the build label is [build_start, end of ver), either may be empty.
+static bool parse_internal(const pal::string_t& ver, bool parse_only_production, unsigned* major, unsigned* minor, unsigned* patch, size_t* pre_start, size_t* build_start)
 {
     size_t maj_start = 0;
     size_t maj_sep = ver.find(_X('.'));
@@ -291,17 +415,10 @@ bool parse_internal(const pal::string_t& ver, fx_ver_t* fx_ver, bool parse_only_
     {
         return false;
     }
-    unsigned major = 0;
-    if (!try_stou(ver.substr(maj_start, maj_sep), &major))
+    if (!parse_number(ver, maj_start, maj_sep, major))
     {
         return false;
     }
-    if (maj_sep > 1 && ver[maj_start] == _X('0'))
-    {
-        // if leading character is 0, and strlen > 1
-        // then the numeric substring has leading zeroes which is prohibited by the specification.
-        return false;
-    }
 
     size_t min_start = maj_sep + 1;
     size_t min_sep = ver.find(_X('.'), min_start);
@@ -309,36 +426,25 @@ bool parse_internal(const pal::string_t& ver, fx_ver_t* fx_ver, bool parse_only_
     {
         return false;
     }
-
-    unsigned minor = 0;
-    if (!try_stou(ver.substr(min_start, min_sep - min_start), &minor))
+    if (!parse_number(ver, min_start, min_sep, minor))
     {
         return false;
     }
-    if (min_sep - min_start > 1 && ver[min_start] == _X('0'))
+
+    size_t pat_start = min_sep + 1;
+    size_t pat_sep = pat_start;
+    while (pat_sep < ver.length() && ver[pat_sep] >= _X('0') && ver[pat_sep] <= _X('9'))
+    {
+        pat_sep++;
+    }
+    if (!parse_number(ver, pat_start, pat_sep, patch))
     {
-        // if leading character is 0, and strlen > 1
-        // then the numeric substring has leading zeroes which is prohibited by the specification.
         return false;
     }
 
-    unsigned patch = 0;
-    size_t pat_start = min_sep + 1;
-    size_t pat_sep = index_of_non_numeric(ver, pat_start);
-    if (pat_sep == pal::string_t::npos)
+    if (pat_sep == ver.length())
     {
-        if (!try_stou(ver.substr(pat_start), &patch))
-        {
-            return false;
-        }
-        if (ver[pat_start + 1] != 0 && ver[pat_start] == _X('0'))
-        {
-            // if leading character is 0, and strlen != 1
-            // then the numeric substring has leading zeroes which is prohibited by the specification.
-            return false;
-        }
-
-        *fx_ver = fx_ver_t(major, minor, patch);
+        *pre_start = *build_start = pat_sep;
         return true;
     }
 
@@ -348,45 +454,47 @@ bool parse_internal(const pal::string_t& ver, fx_ver_t* fx_ver, bool parse_only_
         return false;
     }
 
-    if (!try_stou(ver.substr(pat_start, pat_sep - pat_start), &patch))
-    {
-        return false;
-    }
-    if (pat_sep - pat_start > 1 && ver[pat_start] == _X('0'))
+    size_t pre_sep = ver.find(_X('+'), pat_sep);
+    if (pre_sep == pal::string_t::npos)
     {
-        return false;
+        pre_sep = ver.length();
     }
 
-    size_t pre_start = pat_sep;
-    size_t pre_sep = ver.find(_X('+'), pat_sep);
-
-    pal::string_t pre = (pre_sep == pal::string_t::npos) ? ver.substr(pre_start) : ver.substr(pre_start, pre_sep - pre_start);
-
-    if (!validIdentifiers(pre))
+    if (!validIdentifiers(ver.c_str() + pat_sep, pre_sep - pat_sep))
     {
         return false;
     }
 
-    pal::string_t build;
-
-    if (pre_sep != pal::string_t::npos)
+    if (!validIdentifiers(ver.c_str() + pre_sep, ver.length() - pre_sep))
     {
-        build = ver.substr(pre_sep);
-
-        if (!validIdentifiers(build))
-        {
-            return false;
-        }
+        return false;
     }
 
-    *fx_ver = fx_ver_t(major, minor, patch, pre, build);
+    *pre_start = pat_sep;
+    *build_start = pre_sep;
     return true;
 }
 
 /* static */
 bool fx_ver_t::parse(const pal::string_t& ver, fx_ver_t* fx_ver, bool parse_only_production)
 {
-    bool valid = parse_internal(ver, fx_ver, parse_only_production);
+    unsigned major = 0;
+    unsigned minor = 0;
+    unsigned patch = 0;
+    size_t pre_start = 0;
+    size_t build_start = 0;
+    bool valid = parse_internal(ver, parse_only_production, &major, &minor, &patch, &pre_start, &build_start);
+    if (valid)
+    {
+        // Assign the labels in place, so that parsing into an existing version reuses its strings
+        fx_ver->m_major = major;
+        fx_ver->m_minor = minor;
+        fx_ver->m_patch = patch;
+        fx_ver->m_pre.assign(ver, pre_start, build_start - pre_start);
+        fx_ver->m_build.assign(ver, build_start, pal::string_t::npos);
+        fx_ver->m_pre_key = get_prerelease_key(fx_ver->m_pre);
+    }
+
     assert(!valid || fx_ver->as_str() == ver);
     return valid;
 }
@@ -31,6 +31,9 @@ struct fx_ver_t
     bool is_empty() const { return m_major == -1; }
 
     pal::string_t as_str() const;
+    // Writes the version to buffer, null terminated, if it fits into size characters.
+    // Returns the length of the version either way, so that the caller can tell whether it fit.
+    size_t as_str(pal::char_t* buffer, size_t size) const;
     pal::string_t prerelease_glob() const;
     pal::string_t patch_glob() const;
 
@@ -50,6 +53,11 @@ private:
     pal::string_t m_pre;
     pal::string_t m_build;
 
+    // Orders prerelease labels by their first identifier, so that most comparisons don't need to look
+    // at the label itself. Labels with the same key are compared identifier by identifier.
+    uint64_t m_pre_key;
+
+    static uint64_t get_prerelease_key(const pal::string_t& pre);
     static int compare(const fx_ver_t&a, const fx_ver_t& b);
 };
 
@@ -10,8 +10,7 @@
 #include "fx_muxer.h"
 #include "error_codes.h"
 #include "runtime_config.h"
-#include "sdk_info.h"
-#include "sdk_resolver.h"
+#include "sdk_resolution_memo.h"
 #include "hostfxr.h"
 #include "host_context.h"
 
@@ -21,6 +20,9 @@ namespace
     {
         trace::setup();
         trace::info(_X("--- Invoked %s [commit hash: %s]"), entry_point, _STRINGIFY(REPO_COMMIT_HASH));
+
+        // Symlinks might have changed since the last call
+        pal::clear_realpath_cache();
     }
 }
 
@@ -110,8 +112,9 @@ SHARED_API int32_t HOSTFXR_CALLTYPE hostfxr_resolve_sdk(
         working_dir = _X("");
     }
 
-    auto sdk_path = sdk_resolver::from_nearest_global_file(working_dir).resolve(exe_dir);
-    if (sdk_path.empty())
+    pal::string_t sdk_path;
+    pal::string_t global_file;
+    if (!sdk_resolution_memo::resolve_sdk(exe_dir, working_dir, /*allow_prerelease*/ true, &sdk_path, &global_file))
     {
         // sdk_resolver::resolve handles tracing for this error case.
         return 0;
@@ -218,11 +221,15 @@ SHARED_API int32_t HOSTFXR_CALLTYPE hostfxr_resolve_sdk2(
         working_dir = _X("");
     }
 
-    auto resolver = sdk_resolver::from_nearest_global_file(
+    pal::string_t resolved_sdk_dir;
+    pal::string_t global_file;
+    sdk_resolution_memo::resolve_sdk(
+        exe_dir,
         working_dir,
-        (flags & hostfxr_resolve_sdk2_flags_t::disallow_prerelease) == 0);
+        (flags & hostfxr_resolve_sdk2_flags_t::disallow_prerelease) == 0,
+        &resolved_sdk_dir,
+        &global_file);
 
-    auto resolved_sdk_dir = resolver.resolve(exe_dir);
     if (!resolved_sdk_dir.empty())
     {
         result(
@@ -230,11 +237,11 @@ SHARED_API int32_t HOSTFXR_CALLTYPE hostfxr_resolve_sdk2(
             resolved_sdk_dir.c_str());
     }
 
-    if (!resolver.global_file_path().empty())
+    if (!global_file.empty())
     {
         result(
             hostfxr_resolve_sdk2_result_key_t::global_json_path,
-            resolver.global_file_path().c_str());
+            global_file.c_str());
     }
 
     return !resolved_sdk_dir.empty()
@@ -280,21 +287,21 @@ SHARED_API int32_t HOSTFXR_CALLTYPE hostfxr_get_available_sdks(
         exe_dir = _X("");
     }
 
-    std::vector<sdk_info> sdk_infos;
-    sdk_info::get_all_sdk_infos(exe_dir, &sdk_infos);
+    std::vector<pal::string_t> available_sdk_dirs;
+    sdk_resolution_memo::get_available_sdks(exe_dir, &available_sdk_dirs);
 
-    if (sdk_infos.empty())
+    if (available_sdk_dirs.empty())
     {
         result(0, nullptr);
     }
     else
     {
         std::vector<const pal::char_t*> sdk_dirs;
-        sdk_dirs.reserve(sdk_infos.size());
+        sdk_dirs.reserve(available_sdk_dirs.size());
 
-        for (const auto& sdk_info : sdk_infos)
+        for (const auto& sdk_dir : available_sdk_dirs)
         {
-            sdk_dirs.push_back(sdk_info.full_path.c_str());
+            sdk_dirs.push_back(sdk_dir.c_str());
         }
 
         result(sdk_dirs.size(), &sdk_dirs[0]);
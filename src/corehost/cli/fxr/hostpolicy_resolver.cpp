@@ -3,6 +3,7 @@
 // See the LICENSE file in the project root for more information.
 
 #include <cassert>
+#include <env_snapshot.h>
 #include <error_codes.h>
 #include <fx_definition.h>
 #include "hostpolicy_resolver.h"
@@ -11,7 +12,8 @@
 #include <trace.h>
 #include <utils.h>
 
-#include "json_parser.h"
+#include "deps_format.h"
+#include "deps_library_scanner.h"
 
 namespace
 {
@@ -20,9 +22,14 @@ namespace
     hostpolicy_contract_t g_hostpolicy_contract;
     pal::string_t g_hostpolicy_dir;
 
+    // Look up the root package instead of the "runtime" package because we can't do a full rid resolution.
+    // i.e., look for "Microsoft.NETCore.DotNetHostPolicy/" followed by version.
+    const pal::char_t* hostpolicy_library_prefix = _X("Microsoft.NETCore.DotNetHostPolicy/");
+
     /**
     * Resolve the hostpolicy version from deps.
     *  - Scan the deps file's libraries section and find the hostpolicy version in the file.
+    *  - Only reads the file up to the hostpolicy library.
     */
     pal::string_t resolve_hostpolicy_version_from_deps(const pal::string_t& deps_json)
     {
@@ -30,28 +37,53 @@ namespace
 
         pal::string_t retval;
 
-        json_parser_t json;
-        if (!json.parse_file(deps_json))
+        pal::string_t prefix = hostpolicy_library_prefix;
+        pal::string_t lib_name;
+        if (deps_library_scanner::find_library(deps_json, prefix, &lib_name))
         {
-            return retval;
+            // Extract the version information that occurs after '/'
+            retval = lib_name.substr(prefix.size());
         }
 
-        // Look up the root package instead of the "runtime" package because we can't do a full rid resolution.
-        // i.e., look for "Microsoft.NETCore.DotNetHostPolicy/" followed by version.
-        pal::string_t prefix = _X("Microsoft.NETCore.DotNetHostPolicy/");
-        for (const auto& library : json.document()[_X("libraries")].GetObject())
+        trace::verbose(_X("Resolved version %s from dependency manifest file [%s]"), retval.c_str(), deps_json.c_str());
+        return retval;
+    }
+
+    /**
+    * Whether the deps file should be fully loaded here and handed over to hostpolicy.
+    * When disabled only the hostpolicy version is read from the file.
+    */
+    bool is_deps_handoff_enabled()
+    {
+        return !env_snapshot::is_enabled(env_key_t::DOTNET_DISABLE_DEPS_HANDOFF);
+    }
+
+    /**
+    * Whether the resolved hostpolicy is of the same build as this hostfxr.
+    *  - A hostpolicy listed in the deps file is identified by its package version.
+    *  - Otherwise a framework-dependent app uses the root framework's hostpolicy, which
+    *    is identified by the framework version.
+    *  - Otherwise a self-contained app uses the hostpolicy it carries along with hostfxr.
+    */
+    bool is_same_build_as_hostfxr(
+        const pal::string_t& dotnet_root,
+        const fx_definition_vector_t& fx_definitions,
+        bool is_framework_dependent,
+        const pal::string_t& version,
+        const pal::string_t& impl_dir)
+    {
+        const pal::string_t hostfxr_version = _STRINGIFY(HOST_POLICY_PKG_VER);
+        if (!version.empty())
         {
-            pal::string_t lib_name{library.name.GetString()};
-            if (starts_with(lib_name, prefix, false))
-            {
-                // Extract the version information that occurs after '/'
-                retval = lib_name.substr(prefix.size());
-                break;
-            }
+            return version == hostfxr_version;
         }
 
-        trace::verbose(_X("Resolved version %s from dependency manifest file [%s]"), retval.c_str(), deps_json.c_str());
-        return retval;
+        if (is_framework_dependent)
+        {
+            return get_root_framework(fx_definitions).get_found_version() == hostfxr_version;
+        }
+
+        return pal::are_paths_equal_with_normalized_casing(impl_dir, dotnet_root);
     }
 
     /**
@@ -219,6 +251,94 @@ int hostpolicy_resolver::load(
     return StatusCode::Success;
 }
 
+namespace
+{
+    /**
+    * Find the directory containing the given version of hostpolicy
+    */
+    bool resolve_hostpolicy_dir(
+        host_mode_t mode,
+        const pal::string_t& dotnet_root,
+        const fx_definition_vector_t& fx_definitions,
+        const pal::string_t& app_candidate,
+        const pal::string_t& specified_deps_file,
+        const std::vector<pal::string_t>& probe_realpaths,
+        bool is_framework_dependent,
+        const pal::string_t& version,
+        pal::string_t* impl_dir)
+    {
+        // Check if the given version of the hostpolicy exists in servicing.
+        if (hostpolicy_exists_in_svc(version, impl_dir))
+        {
+            return true;
+        }
+
+        // Get the expected directory that would contain hostpolicy.
+        pal::string_t expected;
+        if (is_framework_dependent)
+        {
+            // The hostpolicy is required to be in the root framework's location
+            expected.assign(get_root_framework(fx_definitions).get_dir());
+            assert(pal::directory_exists(expected));
+        }
+        else
+        {
+            // Native apps can be activated by muxer, native exe host or "corehost"
+            // 1. When activated with dotnet.exe or corehost.exe, check for hostpolicy in the deps dir or
+            //    app dir.
+            // 2. When activated with native exe, the standalone host, check own directory.
+            assert(mode != host_mode_t::invalid);
+            switch (mode)
+            {
+            case host_mode_t::apphost:
+            case host_mode_t::libhost:
+                expected = dotnet_root;
+                break;
+
+            default:
+                expected = get_directory(specified_deps_file.empty() ? app_candidate : specified_deps_file);
+                break;
+            }
+        }
+
+        // Check if hostpolicy exists in "expected" directory.
+        trace::verbose(_X("The expected %s directory is [%s]"), LIBHOSTPOLICY_NAME, expected.c_str());
+        if (library_exists_in_dir(expected, LIBHOSTPOLICY_NAME, nullptr))
+        {
+            impl_dir->assign(expected);
+            return true;
+        }
+
+        trace::verbose(_X("The %s was not found in [%s]"), LIBHOSTPOLICY_NAME, expected.c_str());
+
+        // Start probing for hostpolicy in the specified probe paths.
+        pal::string_t candidate;
+        if (resolve_hostpolicy_dir_from_probe_paths(version, probe_realpaths, &candidate))
+        {
+            impl_dir->assign(candidate);
+            return true;
+        }
+
+        // If it still couldn't be found, somebody upstack messed up. Flag an error for the "expected" location.
+        trace::error(_X("A fatal error was encountered. The library '%s' required to execute the application was not found in '%s'."),
+            LIBHOSTPOLICY_NAME, expected.c_str());
+        if (mode == host_mode_t::muxer && !is_framework_dependent)
+        {
+            if (!pal::file_exists(get_app(fx_definitions).get_runtime_config().get_path()))
+            {
+                trace::error(_X("Failed to run as a self-contained app. If this should be a framework-dependent app, add the %s file specifying the appropriate framework."),
+                    get_app(fx_definitions).get_runtime_config().get_path().c_str());
+            }
+            else if (get_app(fx_definitions).get_name().empty())
+            {
+                trace::error(_X("Failed to run as a self-contained app. If this should be a framework-dependent app, specify the appropriate framework in %s."),
+                    get_app(fx_definitions).get_runtime_config().get_path().c_str());
+            }
+        }
+        return false;
+    }
+}
+
 /**
 * Return location that is expected to contain hostpolicy
 */
@@ -229,7 +349,8 @@ bool hostpolicy_resolver::try_get_dir(
     const pal::string_t& app_candidate,
     const pal::string_t& specified_deps_file,
     const std::vector<pal::string_t>& probe_realpaths,
-    pal::string_t* impl_dir)
+    pal::string_t* impl_dir,
+    std::unique_ptr<deps_json_t>* root_deps)
 {
     bool is_framework_dependent = get_app(fx_definitions).get_runtime_config().get_is_framework_dependent();
 
@@ -244,73 +365,19 @@ bool hostpolicy_resolver::try_get_dir(
             resolved_deps.c_str(), _STRINGIFY(HOST_POLICY_PKG_NAME));
     }
 
-    // Check if the given version of the hostpolicy exists in servicing.
-    if (hostpolicy_exists_in_svc(version, impl_dir))
-    {
-        return true;
-    }
-
-    // Get the expected directory that would contain hostpolicy.
-    pal::string_t expected;
-    if (is_framework_dependent)
-    {
-        // The hostpolicy is required to be in the root framework's location
-        expected.assign(get_root_framework(fx_definitions).get_dir());
-        assert(pal::directory_exists(expected));
-    }
-    else
-    {
-        // Native apps can be activated by muxer, native exe host or "corehost"
-        // 1. When activated with dotnet.exe or corehost.exe, check for hostpolicy in the deps dir or
-        //    app dir.
-        // 2. When activated with native exe, the standalone host, check own directory.
-        assert(mode != host_mode_t::invalid);
-        switch (mode)
-        {
-        case host_mode_t::apphost:
-        case host_mode_t::libhost:
-            expected = dotnet_root;
-            break;
-
-        default:
-            expected = get_directory(specified_deps_file.empty() ? app_candidate : specified_deps_file);
-            break;
-        }
-    }
-
-    // Check if hostpolicy exists in "expected" directory.
-    trace::verbose(_X("The expected %s directory is [%s]"), LIBHOSTPOLICY_NAME, expected.c_str());
-    if (library_exists_in_dir(expected, LIBHOSTPOLICY_NAME, nullptr))
+    if (!resolve_hostpolicy_dir(mode, dotnet_root, fx_definitions, app_candidate, specified_deps_file, probe_realpaths, is_framework_dependent, version, impl_dir))
     {
-        impl_dir->assign(expected);
-        return true;
+        return false;
     }
 
-    trace::verbose(_X("The %s was not found in [%s]"), LIBHOSTPOLICY_NAME, expected.c_str());
-
-    // Start probing for hostpolicy in the specified probe paths.
-    pal::string_t candidate;
-    if (resolve_hostpolicy_dir_from_probe_paths(version, probe_realpaths, &candidate))
+    // hostpolicy only reuses the deps loaded here if it is the same build as hostfxr (see deps_json_t::get_layout_id),
+    // otherwise it would load the file a second time. So the file is only loaded for hostpolicy of the same build.
+    if (is_deps_handoff_enabled() && is_same_build_as_hostfxr(dotnet_root, fx_definitions, is_framework_dependent, version, *impl_dir))
     {
-        impl_dir->assign(candidate);
-        return true;
+        // Load the deps file the same way hostpolicy loads the root framework's (or the self-contained app's)
+        // deps file, so that hostpolicy can reuse it instead of parsing the file again.
+        root_deps->reset(new deps_json_t(false /*is_framework_dependent*/, resolved_deps));
     }
 
-    // If it still couldn't be found, somebody upstack messed up. Flag an error for the "expected" location.
-    trace::error(_X("A fatal error was encountered. The library '%s' required to execute the application was not found in '%s'."),
-        LIBHOSTPOLICY_NAME, expected.c_str());
-    if (mode == host_mode_t::muxer && !is_framework_dependent)
-    {
-        if (!pal::file_exists(get_app(fx_definitions).get_runtime_config().get_path()))
-        {
-            trace::error(_X("Failed to run as a self-contained app. If this should be a framework-dependent app, add the %s file specifying the appropriate framework."),
-                get_app(fx_definitions).get_runtime_config().get_path().c_str());
-        }
-        else if (get_app(fx_definitions).get_name().empty())
-        {
-            trace::error(_X("Failed to run as a self-contained app. If this should be a framework-dependent app, specify the appropriate framework in %s."),
-                get_app(fx_definitions).get_runtime_config().get_path().c_str());
-        }
-    }
-    return false;
+    return true;
 }
@@ -35,7 +35,8 @@ namespace hostpolicy_resolver
         const pal::string_t& app_candidate,
         const pal::string_t& specified_deps_file,
         const std::vector<pal::string_t>& probe_realpaths,
-        pal::string_t* impl_dir);
+        pal::string_t* impl_dir,
+        std::unique_ptr<deps_json_t>* root_deps);
 };
 
 #endif // __HOSTPOLICY_RESOLVER_H__
\ No newline at end of file
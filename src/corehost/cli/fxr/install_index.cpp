@@ -0,0 +1,354 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "install_index.h"
+#include "cache_io.h"
+#include "env_snapshot.h"
+#include "trace.h"
+#include "utils.h"
+
+// Install index file layout
+//
+// The file starts with a header identifying the format and the install location, followed by the
+// shared directory and each framework directory in it, and then by the sdk directory. Each directory
+// is stored with its stamp and the version directories in it. All of the directory stamps have to
+// match the current state of the directories for the index to be used.
+
+namespace
+{
+    const uint32_t index_magic = 0x58444e49; // "INDX"
+    const uint32_t index_format_version = 1;
+
+    const pal::char_t* index_file_name = _X("install.index.bin");
+
+    void read_version_dirs(const pal::string_t& dir, std::vector<fx_ver_t>* versions)
+    {
+        std::vector<pal::string_t> list;
+        pal::readdir_onlydirectories(dir, &list);
+
+        fx_ver_t parsed;
+        for (const auto& ver : list)
+        {
+            // Make sure we filter out any non-version folders.
+            if (fx_ver_t::parse(ver, &parsed, false))
+            {
+                versions->push_back(parsed);
+            }
+        }
+    }
+
+    void write_stamp(cache_writer_t& writer, bool exists, const pal::file_stamp_t& stamp)
+    {
+        writer.write_value(static_cast<uint8_t>(exists));
+        if (exists)
+        {
+            writer.write_value(stamp.size);
+            writer.write_value(stamp.last_write_time);
+        }
+    }
+
+    bool read_stamp(cache_reader_t& reader, bool* exists, pal::file_stamp_t* stamp)
+    {
+        uint8_t exists_value;
+        if (!reader.read_value(&exists_value))
+        {
+            return false;
+        }
+
+        *exists = exists_value != 0;
+        *stamp = pal::file_stamp_t();
+        return !*exists || (reader.read_value(&stamp->size) && reader.read_value(&stamp->last_write_time));
+    }
+
+    // Versions are stored as their strings, which are valid versions and are parsed back without allocating
+    void write_versions(cache_writer_t& writer, const std::vector<fx_ver_t>& versions)
+    {
+        writer.write_value(static_cast<uint32_t>(versions.size()));
+        for (const auto& ver : versions)
+        {
+            writer.write_string(ver.as_str());
+        }
+    }
+
+    bool read_versions(cache_reader_t& reader, std::vector<fx_ver_t>* versions)
+    {
+        uint32_t count;
+        if (!reader.read_value(&count))
+        {
+            return false;
+        }
+
+        pal::string_t str;
+        fx_ver_t ver;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!reader.read_string(&str) || !fx_ver_t::parse(str, &ver, false))
+            {
+                return false;
+            }
+
+            versions->push_back(ver);
+        }
+
+        return true;
+    }
+
+    bool stamp_matches(const pal::string_t& dir, bool exists, const pal::file_stamp_t& stamp)
+    {
+        pal::file_stamp_t current;
+        bool current_exists = pal::get_file_stamp(dir, &current);
+        return current_exists == exists && (!exists || current == stamp);
+    }
+}
+
+bool install_index_t::is_enabled()
+{
+    return env_snapshot::is_enabled(env_key_t::DOTNET_INSTALL_INDEX);
+}
+
+install_index_t::install_index_t()
+    : m_shared_exists(false)
+    , m_shared_stamp()
+    , m_sdk_exists(false)
+    , m_sdk_stamp()
+{
+}
+
+void install_index_t::load(const pal::string_t& dotnet_dir)
+{
+    pal::string_t index_path = dotnet_dir;
+    append_path(&index_path, index_file_name);
+
+    if (read(index_path, dotnet_dir))
+    {
+        if (is_up_to_date(dotnet_dir))
+        {
+            trace::verbose(_X("Using install index [%s]"), index_path.c_str());
+            return;
+        }
+
+        trace::verbose(_X("Install index [%s] is stale"), index_path.c_str());
+    }
+
+    scan(dotnet_dir);
+    write(index_path, dotnet_dir);
+}
+
+const install_index_t* install_index_cache_t::get(const pal::string_t& dotnet_dir)
+{
+    if (!install_index_t::is_enabled())
+    {
+        return nullptr;
+    }
+
+    auto existing = m_indexes.find(dotnet_dir);
+    if (existing != m_indexes.end())
+    {
+        return &existing->second;
+    }
+
+    install_index_t& index = m_indexes[dotnet_dir];
+    index.load(dotnet_dir);
+    return &index;
+}
+
+const install_index_t::framework_t* install_index_t::find_framework(const pal::string_t& fx_name) const
+{
+    for (const auto& framework : m_frameworks)
+    {
+        if (framework.name == fx_name)
+        {
+            return &framework;
+        }
+    }
+
+    return nullptr;
+}
+
+bool install_index_t::read(const pal::string_t& index_path, const pal::string_t& dotnet_dir)
+{
+    if (!pal::file_exists(index_path))
+    {
+        trace::verbose(_X("Install index [%s] does not exist"), index_path.c_str());
+        return false;
+    }
+
+    size_t length = 0;
+    void* data = pal::map_file_readonly(index_path, length);
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    cache_reader_t reader(static_cast<const char*>(data), length);
+
+    uint32_t magic;
+    uint32_t format_version;
+    uint32_t char_size;
+    pal::string_t dir;
+    bool shared_exists;
+    pal::file_stamp_t shared_stamp;
+    uint32_t framework_count;
+    bool loaded = reader.read_value(&magic) && magic == index_magic
+        && reader.read_value(&format_version) && format_version == index_format_version
+        && reader.read_value(&char_size) && char_size == sizeof(pal::char_t)
+        && reader.read_string(&dir) && dir == dotnet_dir
+        && read_stamp(reader, &shared_exists, &shared_stamp)
+        && reader.read_value(&framework_count);
+
+    std::vector<framework_t> frameworks;
+    for (uint32_t i = 0; loaded && i < framework_count; ++i)
+    {
+        framework_t framework;
+        bool exists;
+        loaded = reader.read_string(&framework.name)
+            && read_stamp(reader, &exists, &framework.stamp) && exists
+            && read_versions(reader, &framework.versions);
+
+        frameworks.push_back(std::move(framework));
+    }
+
+    bool sdk_exists;
+    pal::file_stamp_t sdk_stamp;
+    std::vector<fx_ver_t> sdk_versions;
+    loaded = loaded
+        && read_stamp(reader, &sdk_exists, &sdk_stamp)
+        && read_versions(reader, &sdk_versions)
+        && reader.at_end();
+
+    pal::unmap_file(data, length);
+
+    if (!loaded)
+    {
+        trace::verbose(_X("Install index [%s] is invalid"), index_path.c_str());
+        return false;
+    }
+
+    m_shared_exists = shared_exists;
+    m_shared_stamp = shared_stamp;
+    m_frameworks = std::move(frameworks);
+    m_sdk_exists = sdk_exists;
+    m_sdk_stamp = sdk_stamp;
+    m_sdk_versions = std::move(sdk_versions);
+    return true;
+}
+
+bool install_index_t::is_up_to_date(const pal::string_t& dotnet_dir) const
+{
+    pal::string_t shared_dir = dotnet_dir;
+    append_path(&shared_dir, _X("shared"));
+    if (!stamp_matches(shared_dir, m_shared_exists, m_shared_stamp))
+    {
+        return false;
+    }
+
+    for (const auto& framework : m_frameworks)
+    {
+        pal::string_t fx_dir = shared_dir;
+        append_path(&fx_dir, framework.name.c_str());
+        if (!stamp_matches(fx_dir, true, framework.stamp))
+        {
+            return false;
+        }
+    }
+
+    pal::string_t sdk_dir = dotnet_dir;
+    append_path(&sdk_dir, _X("sdk"));
+    return stamp_matches(sdk_dir, m_sdk_exists, m_sdk_stamp);
+}
+
+void install_index_t::scan(const pal::string_t& dotnet_dir)
+{
+    // Each directory is stamped before it is listed, so that a change made while it is being
+    // listed leaves the stamp stale rather than the index.
+    pal::string_t shared_dir = dotnet_dir;
+    append_path(&shared_dir, _X("shared"));
+
+    m_frameworks.clear();
+    m_shared_stamp = pal::file_stamp_t();
+    m_shared_exists = pal::get_file_stamp(shared_dir, &m_shared_stamp);
+    if (m_shared_exists)
+    {
+        std::vector<pal::string_t> fx_names;
+        pal::readdir_onlydirectories(shared_dir, &fx_names);
+        for (const auto& fx_name : fx_names)
+        {
+            framework_t framework;
+            framework.name = fx_name;
+
+            pal::string_t fx_dir = shared_dir;
+            append_path(&fx_dir, fx_name.c_str());
+            if (!pal::get_file_stamp(fx_dir, &framework.stamp))
+            {
+                continue;
+            }
+
+            trace::verbose(_X("Gathering FX locations in [%s]"), fx_dir.c_str());
+            read_version_dirs(fx_dir, &framework.versions);
+            m_frameworks.push_back(std::move(framework));
+        }
+    }
+
+    pal::string_t sdk_dir = dotnet_dir;
+    append_path(&sdk_dir, _X("sdk"));
+
+    m_sdk_versions.clear();
+    m_sdk_stamp = pal::file_stamp_t();
+    m_sdk_exists = pal::get_file_stamp(sdk_dir, &m_sdk_stamp);
+    if (m_sdk_exists)
+    {
+        trace::verbose(_X("Gathering SDK locations in [%s]"), sdk_dir.c_str());
+        read_version_dirs(sdk_dir, &m_sdk_versions);
+    }
+}
+
+void install_index_t::write(const pal::string_t& index_path, const pal::string_t& dotnet_dir) const
+{
+    std::vector<char> buffer;
+    cache_writer_t writer(&buffer);
+    writer.write_value(index_magic);
+    writer.write_value(index_format_version);
+    writer.write_value(static_cast<uint32_t>(sizeof(pal::char_t)));
+    writer.write_string(dotnet_dir);
+
+    std::vector<pal::file_stamp_t> stamps;
+    write_stamp(writer, m_shared_exists, m_shared_stamp);
+    if (m_shared_exists)
+    {
+        stamps.push_back(m_shared_stamp);
+    }
+
+    writer.write_value(static_cast<uint32_t>(m_frameworks.size()));
+    for (const auto& framework : m_frameworks)
+    {
+        writer.write_string(framework.name);
+        write_stamp(writer, true, framework.stamp);
+        write_versions(writer, framework.versions);
+        stamps.push_back(framework.stamp);
+    }
+
+    write_stamp(writer, m_sdk_exists, m_sdk_stamp);
+    write_versions(writer, m_sdk_versions);
+    if (m_sdk_exists)
+    {
+        stamps.push_back(m_sdk_stamp);
+    }
+
+    switch (write_cache_file(index_path, buffer, stamps))
+    {
+    case cache_write_status::create_failed:
+        trace::verbose(_X("Could not create install index [%s]"), index_path.c_str());
+        return;
+    case cache_write_status::write_failed:
+        trace::verbose(_X("Could not write install index [%s]"), index_path.c_str());
+        return;
+    case cache_write_status::inputs_too_recent:
+        trace::verbose(_X("Not writing install index [%s], the install location changed too recently"), index_path.c_str());
+        return;
+    case cache_write_status::written:
+        break;
+    }
+
+    trace::verbose(_X("Wrote install index [%s]"), index_path.c_str());
+}
@@ -0,0 +1,77 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __INSTALL_INDEX_H__
+#define __INSTALL_INDEX_H__
+
+#include <unordered_map>
+#include "pal.h"
+#include "fx_ver.h"
+
+// Index of the frameworks and SDKs installed in one install location, that is of the version
+// directories under shared/<name> and sdk.
+//
+// The index is persisted in an "install.index.bin" file in the install location, so that launches
+// don't have to list and parse all of the version directories. It is validated by the size and last
+// write time of every directory it lists: installing or removing a framework or an SDK adds or
+// removes a directory, which changes the last write time of its parent. A stale index is rebuilt
+// from the directories and rewritten.
+class install_index_t
+{
+public:
+    struct framework_t
+    {
+        pal::string_t name;
+        pal::file_stamp_t stamp;
+
+        // Versions of the directories which are valid version numbers, in directory listing order
+        std::vector<fx_ver_t> versions;
+    };
+
+    // Enabled via DOTNET_INSTALL_INDEX=1
+    static bool is_enabled();
+
+    install_index_t();
+
+    // Reads the index of the install location from its index file, or rebuilds it if the index
+    // file is missing or stale.
+    void load(const pal::string_t& dotnet_dir);
+
+    // Frameworks in the shared directory, in directory listing order
+    const std::vector<framework_t>& get_frameworks() const { return m_frameworks; }
+
+    // Returns nullptr if there is no directory for the framework in the shared directory
+    const framework_t* find_framework(const pal::string_t& fx_name) const;
+
+    // Returns nullptr if there is no sdk directory
+    const std::vector<fx_ver_t>* get_sdk_versions() const { return m_sdk_exists ? &m_sdk_versions : nullptr; }
+
+private:
+    bool read(const pal::string_t& index_path, const pal::string_t& dotnet_dir);
+    bool is_up_to_date(const pal::string_t& dotnet_dir) const;
+    void scan(const pal::string_t& dotnet_dir);
+    void write(const pal::string_t& index_path, const pal::string_t& dotnet_dir) const;
+
+    bool m_shared_exists;
+    pal::file_stamp_t m_shared_stamp;
+    std::vector<framework_t> m_frameworks;
+
+    bool m_sdk_exists;
+    pal::file_stamp_t m_sdk_stamp;
+    std::vector<fx_ver_t> m_sdk_versions;
+};
+
+// The indexes of the install locations used by one hostfxr call. Each index is loaded on its first use
+// only, so that resolving several frameworks (and the SDK before them) doesn't load it again.
+class install_index_cache_t
+{
+public:
+    // Returns nullptr if the index is disabled
+    const install_index_t* get(const pal::string_t& dotnet_dir);
+
+private:
+    std::unordered_map<pal::string_t, install_index_t> m_indexes;
+};
+
+#endif // __INSTALL_INDEX_H__
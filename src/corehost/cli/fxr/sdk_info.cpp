@@ -3,6 +3,7 @@
 // See the LICENSE file in the project root for more information.
 
 #include <cassert>
+#include "install_index.h"
 #include "pal.h"
 #include "sdk_info.h"
 #include "trace.h"
@@ -43,6 +44,7 @@ bool compare_by_version_ascending_then_hive_depth_descending(const sdk_info &a,
 
 void sdk_info::get_all_sdk_infos(
     const pal::string_t& own_dir,
+    install_index_cache_t& install_indexes,
     std::vector<sdk_info>* sdk_infos)
 {
     std::vector<pal::string_t> hive_dir;
@@ -57,26 +59,36 @@ void sdk_info::get_all_sdk_infos(
 
         append_path(&base_dir, _X("sdk"));
 
-        if (pal::directory_exists(base_dir))
+        const install_index_t* index = install_indexes.get(dir);
+        if (index != nullptr)
         {
-            std::vector<pal::string_t> versions;
-            pal::readdir_onlydirectories(base_dir, &versions);
-            for (const auto& ver : versions)
+            const std::vector<fx_ver_t>* versions = index->get_sdk_versions();
+            for (size_t i = 0; versions != nullptr && i < versions->size(); ++i)
+            {
+                auto full_dir = base_dir;
+                append_path(&full_dir, (*versions)[i].as_str().c_str());
+
+                sdk_infos->push_back(sdk_info(base_dir, full_dir, (*versions)[i], hive_depth));
+            }
+        }
+        else if (pal::directory_exists(base_dir))
+        {
+            pal::enumerate_dir(base_dir, _X("*"), true, [&](const pal::char_t* ver)
             {
                 // Make sure we filter out any non-version folders.
                 fx_ver_t parsed;
                 if (fx_ver_t::parse(ver, &parsed, false))
                 {
-                    trace::verbose(_X("Found SDK version [%s]"), ver.c_str());
+                    trace::verbose(_X("Found SDK version [%s]"), ver);
 
                     auto full_dir = base_dir;
-                    append_path(&full_dir, ver.c_str());
+                    append_path(&full_dir, ver);
 
                     sdk_info info(base_dir, full_dir, parsed, hive_depth);
 
                     sdk_infos->push_back(info);
                 }
-            }
+            });
         }
 
         hive_depth++;
@@ -85,10 +97,13 @@ void sdk_info::get_all_sdk_infos(
     std::sort(sdk_infos->begin(), sdk_infos->end(), compare_by_version_ascending_then_hive_depth_descending);
 }
 
-/*static*/ bool sdk_info::print_all_sdks(const pal::string_t& own_dir, const pal::string_t& leading_whitespace)
+/*static*/ bool sdk_info::print_all_sdks(
+    const pal::string_t& own_dir,
+    const pal::string_t& leading_whitespace,
+    install_index_cache_t& install_indexes)
 {
     std::vector<sdk_info> sdk_infos;
-    get_all_sdk_infos(own_dir, &sdk_infos);
+    get_all_sdk_infos(own_dir, install_indexes, &sdk_infos);
     for (sdk_info info : sdk_infos)
     {
         trace::println(_X("%s%s [%s]"), leading_whitespace.c_str(), info.version.as_str().c_str(), info.base_path.c_str());
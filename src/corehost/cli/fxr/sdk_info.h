@@ -8,6 +8,8 @@
 #include "pal.h"
 #include "fx_ver.h"
 
+class install_index_cache_t;
+
 struct sdk_info
 {
     sdk_info(const pal::string_t& base_path, const pal::string_t& full_path, const fx_ver_t& version, int32_t hive_depth)
@@ -18,9 +20,13 @@ struct sdk_info
 
     static void get_all_sdk_infos(
         const pal::string_t& own_dir,
+        install_index_cache_t& install_indexes,
         std::vector<sdk_info>* sdk_infos);
 
-    static bool print_all_sdks(const pal::string_t& own_dir, const pal::string_t& leading_whitespace);
+    static bool print_all_sdks(
+        const pal::string_t& own_dir,
+        const pal::string_t& leading_whitespace,
+        install_index_cache_t& install_indexes);
 
     pal::string_t base_path;
     pal::string_t full_path;
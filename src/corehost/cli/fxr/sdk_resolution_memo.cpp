@@ -0,0 +1,201 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "install_index.h"
+#include "sdk_resolution_memo.h"
+#include "sdk_info.h"
+#include "sdk_resolver.h"
+#include "trace.h"
+#include "utils.h"
+
+namespace
+{
+    struct dir_stamp_t
+    {
+        pal::string_t dir;
+        bool exists;
+        pal::file_stamp_t stamp;
+
+        bool operator==(const dir_stamp_t& other) const
+        {
+            return dir == other.dir && exists == other.exists && (!exists || stamp == other.stamp);
+        }
+    };
+
+    struct resolution_t
+    {
+        std::vector<dir_stamp_t> sdk_dirs;
+        pal::string_t nearest_global_file;
+        pal::file_stamp_t nearest_global_file_stamp;
+
+        pal::string_t sdk_dir;
+        pal::string_t global_file;
+    };
+
+    struct available_sdks_t
+    {
+        std::vector<dir_stamp_t> sdk_dirs;
+        std::vector<pal::string_t> available_sdk_dirs;
+    };
+
+    pal::mutex_t g_memo_lock;
+    std::unordered_map<pal::string_t, resolution_t> g_resolutions;
+    std::unordered_map<pal::string_t, available_sdks_t> g_available_sdks;
+
+    // The sdk directories are stamped before they are listed, so that an SDK installed while they
+    // are being listed leaves the memoized result stale.
+    void get_sdk_dir_stamps(const pal::string_t& exe_dir, std::vector<dir_stamp_t>* sdk_dirs)
+    {
+        std::vector<pal::string_t> locations;
+        get_framework_and_sdk_locations(exe_dir, &locations);
+
+        for (const auto& location : locations)
+        {
+            dir_stamp_t sdk_dir;
+            sdk_dir.dir = location;
+            append_path(&sdk_dir.dir, _X("sdk"));
+            sdk_dir.stamp = pal::file_stamp_t();
+            sdk_dir.exists = pal::get_file_stamp(sdk_dir.dir, &sdk_dir.stamp);
+            sdk_dirs->push_back(std::move(sdk_dir));
+        }
+    }
+
+    // A change made within the time stamp granularity of the file system right after a stamp was taken
+    // leaves the stamp unchanged, like an edit of a global.json which keeps its size. As with the
+    // inputs_too_recent rule of write_cache_file, a result is only memoized if its stamps are older
+    // than the time its resolution started. The file system times are truncated to their granularity,
+    // so they must be older than that by the coarsest one in use (the two seconds of FAT).
+    bool is_too_recent(const pal::file_stamp_t& stamp, int64_t start_time)
+    {
+        return stamp.last_write_time >= start_time - pal::file_time_from_seconds(2);
+    }
+
+    bool are_too_recent(const std::vector<dir_stamp_t>& sdk_dirs, int64_t start_time)
+    {
+        for (const auto& sdk_dir : sdk_dirs)
+        {
+            if (sdk_dir.exists && is_too_recent(sdk_dir.stamp, start_time))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    pal::string_t get_resolution_key(const pal::string_t& exe_dir, const pal::string_t& working_dir, bool allow_prerelease)
+    {
+        // Paths don't contain null characters, so they separate the parts of the key
+        pal::string_t key = exe_dir;
+        key.push_back(_X('\0'));
+        key.append(working_dir);
+        key.push_back(_X('\0'));
+        key.push_back(allow_prerelease ? _X('1') : _X('0'));
+        return key;
+    }
+}
+
+bool sdk_resolution_memo::resolve_sdk(
+    const pal::string_t& exe_dir,
+    const pal::string_t& working_dir,
+    bool allow_prerelease,
+    pal::string_t* sdk_dir,
+    pal::string_t* global_file)
+{
+    int64_t start_time = pal::get_file_time_now();
+
+    resolution_t resolution;
+    get_sdk_dir_stamps(exe_dir, &resolution.sdk_dirs);
+
+    resolution.nearest_global_file = sdk_resolver::find_nearest_global_file(working_dir);
+    resolution.nearest_global_file_stamp = pal::file_stamp_t();
+    bool can_memoize = resolution.nearest_global_file.empty()
+        || pal::get_file_stamp(resolution.nearest_global_file, &resolution.nearest_global_file_stamp);
+    if (can_memoize && (are_too_recent(resolution.sdk_dirs, start_time)
+        || (!resolution.nearest_global_file.empty() && is_too_recent(resolution.nearest_global_file_stamp, start_time))))
+    {
+        trace::verbose(_X("Not memoizing the SDK resolution for working dir [%s], its inputs changed too recently"), working_dir.c_str());
+        can_memoize = false;
+    }
+
+    pal::string_t key = get_resolution_key(exe_dir, working_dir, allow_prerelease);
+    {
+        std::lock_guard<pal::mutex_t> lock(g_memo_lock);
+
+        auto existing = g_resolutions.find(key);
+        if (existing != g_resolutions.end()
+            && existing->second.nearest_global_file == resolution.nearest_global_file
+            && existing->second.nearest_global_file_stamp == resolution.nearest_global_file_stamp
+            && existing->second.sdk_dirs == resolution.sdk_dirs)
+        {
+            trace::verbose(_X("Using the memoized SDK resolution [%s] for working dir [%s]"), existing->second.sdk_dir.c_str(), working_dir.c_str());
+            *sdk_dir = existing->second.sdk_dir;
+            *global_file = existing->second.global_file;
+            return true;
+        }
+    }
+
+    auto resolver = sdk_resolver::from_global_file(resolution.nearest_global_file, allow_prerelease);
+    install_index_cache_t install_indexes;
+    *sdk_dir = resolver.resolve(exe_dir, install_indexes);
+    *global_file = resolver.global_file_path();
+    if (sdk_dir->empty())
+    {
+        return false;
+    }
+
+    if (can_memoize)
+    {
+        resolution.sdk_dir = *sdk_dir;
+        resolution.global_file = *global_file;
+
+        std::lock_guard<pal::mutex_t> lock(g_memo_lock);
+        g_resolutions[key] = std::move(resolution);
+    }
+
+    return true;
+}
+
+void sdk_resolution_memo::get_available_sdks(
+    const pal::string_t& exe_dir,
+    std::vector<pal::string_t>* sdk_dirs)
+{
+    int64_t start_time = pal::get_file_time_now();
+
+    available_sdks_t available_sdks;
+    get_sdk_dir_stamps(exe_dir, &available_sdks.sdk_dirs);
+
+    {
+        std::lock_guard<pal::mutex_t> lock(g_memo_lock);
+
+        auto existing = g_available_sdks.find(exe_dir);
+        if (existing != g_available_sdks.end() && existing->second.sdk_dirs == available_sdks.sdk_dirs)
+        {
+            trace::verbose(_X("Using the memoized list of available SDKs for [%s]"), exe_dir.c_str());
+            *sdk_dirs = existing->second.available_sdk_dirs;
+            return;
+        }
+    }
+
+    std::vector<sdk_info> sdk_infos;
+    install_index_cache_t install_indexes;
+    sdk_info::get_all_sdk_infos(exe_dir, install_indexes, &sdk_infos);
+
+    available_sdks.available_sdk_dirs.reserve(sdk_infos.size());
+    for (const auto& info : sdk_infos)
+    {
+        available_sdks.available_sdk_dirs.push_back(info.full_path);
+    }
+
+    *sdk_dirs = available_sdks.available_sdk_dirs;
+
+    if (are_too_recent(available_sdks.sdk_dirs, start_time))
+    {
+        trace::verbose(_X("Not memoizing the list of available SDKs for [%s], the sdk directories changed too recently"), exe_dir.c_str());
+        return;
+    }
+
+    std::lock_guard<pal::mutex_t> lock(g_memo_lock);
+    g_available_sdks[exe_dir] = std::move(available_sdks);
+}
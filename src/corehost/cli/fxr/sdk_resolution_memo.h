@@ -0,0 +1,38 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __SDK_RESOLUTION_MEMO_H__
+#define __SDK_RESOLUTION_MEMO_H__
+
+#include "pal.h"
+
+// Memo of the SDK resolutions done in this process. MSBuild SDK resolvers and IDEs call
+// hostfxr_resolve_sdk2 and hostfxr_get_available_sdks repeatedly, often once per project, and
+// each call would otherwise look for global.json, parse it and list the sdk directories again.
+//
+// A memoized result is used as long as the nearest global.json is the same file with the same
+// stamp, and the sdk directories of the install locations have the same stamps. Installing or
+// removing an SDK changes the stamp of its sdk directory. Resolutions which didn't find an SDK
+// are not memoized, so that they keep reporting why, and neither are resolutions whose stamps
+// are too recent to tell a later change apart.
+//
+// The functions can be called from multiple threads at once.
+namespace sdk_resolution_memo
+{
+    // Returns false if no SDK was resolved. global_file is set to the global.json which was used
+    // for the resolution, or cleared if there was none.
+    bool resolve_sdk(
+        const pal::string_t& exe_dir,
+        const pal::string_t& working_dir,
+        bool allow_prerelease,
+        pal::string_t* sdk_dir,
+        pal::string_t* global_file);
+
+    // Directories of all of the available SDKs, in the order of sdk_info::get_all_sdk_infos
+    void get_available_sdks(
+        const pal::string_t& exe_dir,
+        std::vector<pal::string_t>* sdk_dirs);
+}
+
+#endif // __SDK_RESOLUTION_MEMO_H__
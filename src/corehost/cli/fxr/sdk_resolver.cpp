@@ -7,6 +7,7 @@
 #include "trace.h"
 #include "utils.h"
 #include "sdk_info.h"
+#include "install_index.h"
 #include "json_parser.h"
 
 using namespace std;
@@ -27,6 +28,66 @@ namespace
         _X("latestMinor"),
         _X("latestMajor"),
     };
+
+    struct sdk_dir_t
+    {
+        fx_ver_t version;
+        pal::string_t name;
+    };
+
+    typedef vector<sdk_dir_t>::const_iterator sdk_dir_iterator;
+
+    // Returns how many of the major, minor and feature band numbers a version has to share with the
+    // requested version to match the policy.
+    int get_fixed_parts(sdk_roll_forward_policy roll_forward)
+    {
+        switch (roll_forward)
+        {
+        case sdk_roll_forward_policy::patch:
+        case sdk_roll_forward_policy::latest_patch:
+            return 3;
+        case sdk_roll_forward_policy::feature:
+        case sdk_roll_forward_policy::latest_feature:
+            return 2;
+        case sdk_roll_forward_policy::minor:
+        case sdk_roll_forward_policy::latest_minor:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    // Compares the first parts of the major, minor and feature band numbers of the versions
+    bool is_lower_in_parts(const fx_ver_t& a, const fx_ver_t& b, int parts)
+    {
+        if (parts > 0 && a.get_major() != b.get_major())
+        {
+            return a.get_major() < b.get_major();
+        }
+
+        if (parts > 1 && a.get_minor() != b.get_minor())
+        {
+            return a.get_minor() < b.get_minor();
+        }
+
+        return parts > 2 && (a.get_patch() / 100) < (b.get_patch() / 100);
+    }
+
+    // Returns the last of the sdk directories which matches, or last if there is none
+    template<typename Predicate>
+    sdk_dir_iterator find_last(sdk_dir_iterator first, sdk_dir_iterator last, Predicate matches)
+    {
+        for (sdk_dir_iterator it = last; it != first;)
+        {
+            --it;
+            if (matches(*it))
+            {
+                return it;
+            }
+        }
+
+        return last;
+    }
 }
 
 sdk_resolver::sdk_resolver(bool allow_prerelease) :
@@ -46,7 +107,7 @@ pal::string_t const& sdk_resolver::global_file_path() const
     return global_file;
 }
 
-pal::string_t sdk_resolver::resolve(const pal::string_t& dotnet_root) const
+pal::string_t sdk_resolver::resolve(const pal::string_t& dotnet_root, install_index_cache_t& install_indexes) const
 {
     auto requested = version.is_empty() ? pal::string_t{} : version.as_str();
 
@@ -64,9 +125,7 @@ pal::string_t sdk_resolver::resolve(const pal::string_t& dotnet_root) const
 
     for (auto&& dir : locations)
     {
-        append_path(&dir, _X("sdk"));
-
-        if (resolve_sdk_path_and_version(dir, resolved_sdk_path, resolved_version))
+        if (resolve_sdk_path_and_version(dir, install_indexes, resolved_sdk_path, resolved_version))
         {
             break;
         }
@@ -92,7 +151,7 @@ pal::string_t sdk_resolver::resolve(const pal::string_t& dotnet_root) const
         }
     }
 
-    if (requested.empty() || !sdk_info::print_all_sdks(dotnet_root, _X("  ")))
+    if (requested.empty() || !sdk_info::print_all_sdks(dotnet_root, _X("  "), install_indexes))
     {
         trace::error(_X("  It was not possible to find any installed .NET Core SDKs"));
         trace::error(_X("  Did you mean to run .NET Core SDK commands? Install a .NET Core SDK from:"));
@@ -117,10 +176,15 @@ sdk_resolver sdk_resolver::from_nearest_global_file(bool allow_prerelease)
 }
 
 sdk_resolver sdk_resolver::from_nearest_global_file(const pal::string_t& cwd, bool allow_prerelease)
+{
+    return from_global_file(find_nearest_global_file(cwd), allow_prerelease);
+}
+
+sdk_resolver sdk_resolver::from_global_file(const pal::string_t& global_file_path, bool allow_prerelease)
 {
     sdk_resolver resolver{ allow_prerelease };
 
-    if (!resolver.parse_global_file(find_nearest_global_file(cwd)))
+    if (!resolver.parse_global_file(global_file_path))
     {
         // Fall back to a default SDK resolver
         resolver = sdk_resolver{ allow_prerelease };
@@ -171,12 +235,14 @@ pal::string_t sdk_resolver::find_nearest_global_file(const pal::string_t& cwd)
 {
     if (!cwd.empty())
     {
-        for (pal::string_t parent_dir, cur_dir = cwd; true; cur_dir = parent_dir)
+        // The probed path reuses one buffer, so that the walk only allocates for the parent directories
+        pal::string_t file;
+        for (pal::string_t parent_dir, cur_dir = cwd; true; cur_dir.swap(parent_dir))
         {
-            auto file = cur_dir;
+            file.assign(cur_dir);
             append_path(&file, _X("global.json"));
 
-            trace::verbose(_X("Probing path [%s] for global.json"), file.c_str());
+            TRACE_VERBOSE(_X("Probing path [%s] for global.json"), file.c_str());
             if (pal::file_exists(file))
             {
                 trace::verbose(_X("Found global.json [%s]"), file.c_str());
@@ -413,8 +479,15 @@ bool sdk_resolver::is_policy_use_latest() const
            roll_forward == sdk_roll_forward_policy::latest_major;
 }
 
-bool sdk_resolver::resolve_sdk_path_and_version(const pal::string_t& dir, pal::string_t& sdk_path, fx_ver_t& resolved_version) const
+bool sdk_resolver::resolve_sdk_path_and_version(
+    const pal::string_t& dotnet_dir,
+    install_index_cache_t& install_indexes,
+    pal::string_t& sdk_path,
+    fx_ver_t& resolved_version) const
 {
+    pal::string_t dir = dotnet_dir;
+    append_path(&dir, _X("sdk"));
+
     trace::verbose(_X("Searching for SDK versions in [%s]"), dir.c_str());
 
     // If an exact match is preferred, check for the existence of the version
@@ -441,10 +514,24 @@ bool sdk_resolver::resolve_sdk_path_and_version(const pal::string_t& dir, pal::s
     }
 
     vector<pal::string_t> versions;
-    pal::readdir_onlydirectories(dir, &versions);
+    const install_index_t* index = install_indexes.get(dotnet_dir);
+    if (index != nullptr)
+    {
+        const vector<fx_ver_t>* indexed = index->get_sdk_versions();
+        for (size_t i = 0; indexed != nullptr && i < indexed->size(); ++i)
+        {
+            versions.push_back((*indexed)[i].as_str());
+        }
+    }
+    else
+    {
+        pal::readdir_onlydirectories(dir, &versions);
+    }
 
-    bool changed = false;
-    pal::string_t resolved_version_str = resolved_version.is_empty() ? pal::string_t{} : resolved_version.as_str();
+    // Sort the versions, keeping equal versions in their listing order, so that the versions matching the
+    // policy form one range and the best match is found at one of its ends.
+    vector<sdk_dir_t> sdk_dirs;
+    sdk_dirs.reserve(versions.size());
     for (auto&& version : versions)
     {
         fx_ver_t ver;
@@ -454,37 +541,70 @@ bool sdk_resolver::resolve_sdk_path_and_version(const pal::string_t& dir, pal::s
             continue;
         }
 
-        if (!matches_policy(ver))
+        sdk_dirs.push_back(sdk_dir_t{ move(ver), move(version) });
+    }
+
+    stable_sort(sdk_dirs.begin(), sdk_dirs.end(), [](const sdk_dir_t& a, const sdk_dir_t& b) { return a.version < b.version; });
+
+    auto first = sdk_dirs.cbegin();
+    auto last = sdk_dirs.cend();
+    if (!version.is_empty())
+    {
+        // Matching versions are at least the requested version and share the numbers with it
+        // which the policy doesn't allow to roll forward over
+        int parts = get_fixed_parts(roll_forward);
+        first = lower_bound(first, last, version, [](const sdk_dir_t& a, const fx_ver_t& b) { return a.version < b; });
+        last = upper_bound(first, last, version, [parts](const fx_ver_t& a, const sdk_dir_t& b) { return is_lower_in_parts(a, b.version, parts); });
+    }
+
+    auto matches = [this](const sdk_dir_t& sdk_dir) { return matches_policy(sdk_dir.version); };
+    auto match = last;
+    if (version.is_empty() || is_policy_use_latest())
+    {
+        // The latest version wins
+        match = find_last(first, last, matches);
+    }
+    else
+    {
+        // The nearest feature band wins, and the latest patch within it
+        auto nearest = find_if(first, last, matches);
+        if (nearest != last)
         {
-            trace::verbose(_X("Ignoring version [%s] because it does not match the roll-forward policy"), version.c_str());
-            continue;
+            auto band_last = upper_bound(nearest, last, nearest->version, [](const fx_ver_t& a, const sdk_dir_t& b) { return is_lower_in_parts(a, b.version, 3); });
+            match = find_last(nearest, band_last, matches);
         }
+    }
 
-        if (!is_better_match(ver, resolved_version))
+    if (match == last)
+    {
+        trace::verbose(_X("No version matches the roll-forward policy"));
+    }
+    else
+    {
+        // Of equal versions the first one listed wins
+        match = lower_bound(first, match, match->version, [](const sdk_dir_t& a, const fx_ver_t& b) { return a.version < b; });
+
+        pal::string_t resolved_version_str = resolved_version.is_empty() ? pal::string_t{} : resolved_version.as_str();
+        if (!is_better_match(match->version, resolved_version))
         {
             trace::verbose(
                 _X("Ignoring version [%s] because it is not a better match than [%s]"),
-                version.c_str(),
+                match->name.c_str(),
                 resolved_version_str.empty() ? _X("none") : resolved_version_str.c_str()
             );
-            continue;
         }
+        else
+        {
+            trace::verbose(
+                _X("Version [%s] is a better match than [%s]"),
+                match->name.c_str(),
+                resolved_version_str.empty() ? _X("none") : resolved_version_str.c_str()
+            );
 
-        trace::verbose(
-            _X("Version [%s] is a better match than [%s]"),
-            version.c_str(),
-            resolved_version_str.empty() ? _X("none") : resolved_version_str.c_str()
-        );
-
-        changed = true;
-        resolved_version = ver;
-        resolved_version_str = move(version);
-    }
-
-    if (changed)
-    {
-        sdk_path = dir;
-        append_path(&sdk_path, resolved_version_str.c_str());
+            resolved_version = match->version;
+            sdk_path = dir;
+            append_path(&sdk_path, match->name.c_str());
+        }
     }
 
     // Not yet fully resolved
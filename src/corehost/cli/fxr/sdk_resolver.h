@@ -7,6 +7,8 @@
 #include "pal.h"
 #include "fx_ver.h"
 
+class install_index_cache_t;
+
 // Note: this must be kept in-sync with `RollForwardPolicyNames`.
 enum class sdk_roll_forward_policy
 {
@@ -40,7 +42,7 @@ public:
 
     pal::string_t const& global_file_path() const;
 
-    pal::string_t resolve(const pal::string_t& dotnet_root) const;
+    pal::string_t resolve(const pal::string_t& dotnet_root, install_index_cache_t& install_indexes) const;
 
     static sdk_resolver from_nearest_global_file(bool allow_prerelease = true);
 
@@ -48,16 +50,26 @@ public:
         const pal::string_t& cwd,
         bool allow_prerelease = true);
 
+    // global_file_path is the result of find_nearest_global_file, empty if there is no global.json
+    static sdk_resolver from_global_file(
+        const pal::string_t& global_file_path,
+        bool allow_prerelease = true);
+
+    static pal::string_t find_nearest_global_file(const pal::string_t& cwd);
+
 private:
     static sdk_roll_forward_policy to_policy(const pal::string_t& name);
     static const pal::char_t* to_policy_name(sdk_roll_forward_policy policy);
-    static pal::string_t find_nearest_global_file(const pal::string_t& cwd);
     bool parse_global_file(pal::string_t global_file_path);
     bool matches_policy(const fx_ver_t& current) const;
     bool is_better_match(const fx_ver_t& current, const fx_ver_t& previous) const;
     bool exact_match_preferred() const;
     bool is_policy_use_latest() const;
-    bool resolve_sdk_path_and_version(const pal::string_t& dir, pal::string_t& sdk_path, fx_ver_t& resolved_version) const;
+    bool resolve_sdk_path_and_version(
+        const pal::string_t& dotnet_dir,
+        install_index_cache_t& install_indexes,
+        pal::string_t& sdk_path,
+        fx_ver_t& resolved_version) const;
 
     pal::string_t global_file;
     fx_ver_t version;
@@ -14,22 +14,17 @@ namespace
     {
         trace::info(_X("Reading fx resolver directory=[%s]"), fxr_root.c_str());
 
-        std::vector<pal::string_t> list;
-        pal::readdir_onlydirectories(fxr_root, &list);
-
         fx_ver_t max_ver;
-        for (const auto& dir : list)
+        pal::enumerate_dir(fxr_root, _X("*"), true, [&max_ver](const pal::char_t* dir)
         {
-            trace::info(_X("Considering fxr version=[%s]..."), dir.c_str());
-
-            pal::string_t ver = get_filename(dir);
+            trace::info(_X("Considering fxr version=[%s]..."), dir);
 
             fx_ver_t fx_ver;
-            if (fx_ver_t::parse(ver, &fx_ver, /* parse_only_production */ false))
+            if (fx_ver_t::parse(dir, &fx_ver, /* parse_only_production */ false))
             {
                 max_ver = std::max(max_ver, fx_ver);
             }
-        }
+        });
 
         if (max_ver == fx_ver_t())
         {
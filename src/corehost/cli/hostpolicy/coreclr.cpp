@@ -94,27 +94,16 @@ pal::hresult_t coreclr_t::create(
     host_handle_t host_handle;
     domain_id_t domain_id;
 
-    int propertyCount = properties.count();
-    std::vector<std::vector<char>> keys_strs(propertyCount);
-    std::vector<const char*> keys(propertyCount);
-    std::vector<std::vector<char>> values_strs(propertyCount);
-    std::vector<const char*> values(propertyCount);
-    int index = 0;
-    std::function<void (const pal::string_t &,const pal::string_t &)> callback = [&] (const pal::string_t& key, const pal::string_t& value)
-    {
-        pal::pal_clrstring(key, &keys_strs[index]);
-        keys[index] = keys_strs[index].data();
-        pal::pal_clrstring(value, &values_strs[index]);
-        values[index] = values_strs[index].data();
-        ++index;
-    };
-    properties.enumerate(callback);
+    std::vector<const char*> keys;
+    std::vector<const char*> values;
+    std::vector<std::vector<char>> clr_strings;
+    properties.get_clr_properties(&keys, &values, &clr_strings);
 
     pal::hresult_t hr;
     hr = coreclr_initialize(
         exe_path,
         app_domain_friendly_name,
-        propertyCount,
+        static_cast<int>(keys.size()),
         keys.data(),
         values.data(),
         &host_handle,
@@ -232,6 +221,27 @@ bool coreclr_property_bag_t::add(common_property key, const pal::char_t *value)
     return add(PropertyNameMapping[idx], value);
 }
 
+bool coreclr_property_bag_t::add(common_property key, pal::string_t &&value)
+{
+    int idx = static_cast<int>(key);
+    assert(0 <= idx && idx < static_cast<int>(common_property::Last));
+
+    // The value is moved in, so that the search paths which are large aren't copied
+    const pal::char_t *name = PropertyNameMapping[idx];
+    auto iter = _properties.find(name);
+    if (iter == _properties.cend())
+    {
+        _properties.emplace(name, std::move(value));
+        return true;
+    }
+    else
+    {
+        trace::verbose(_X("Overwriting property %s. New value: '%s'. Old value: '%s'."), name, value.c_str(), (*iter).second.c_str());
+        (*iter).second = std::move(value);
+        return false;
+    }
+}
+
 bool coreclr_property_bag_t::add(const pal::char_t *key, const pal::char_t *value)
 {
     if (key == nullptr || value == nullptr)
@@ -299,3 +309,29 @@ void coreclr_property_bag_t::enumerate(std::function<void(const pal::string_t&,
     for (auto &kv : _properties)
         callback(kv.first, kv.second);
 }
+
+void coreclr_property_bag_t::get_clr_properties(std::vector<const char*> *keys, std::vector<const char*> *values, std::vector<std::vector<char>> *clr_strings) const
+{
+    keys->reserve(_properties.size());
+    values->reserve(_properties.size());
+
+#if defined(_WIN32)
+    // The strings are converted up front, so that the pointers to them don't move
+    clr_strings->resize(2 * _properties.size());
+    size_t index = 0;
+    for (auto &kv : _properties)
+    {
+        pal::pal_clrstring(kv.first, &(*clr_strings)[index]);
+        keys->push_back((*clr_strings)[index++].data());
+        pal::pal_clrstring(kv.second, &(*clr_strings)[index]);
+        values->push_back((*clr_strings)[index++].data());
+    }
+#else
+    // pal_clrstring is an identity conversion here, so the strings are passed without copying them
+    for (auto &kv : _properties)
+    {
+        keys->push_back(kv.first.c_str());
+        values->push_back(kv.second.c_str());
+    }
+#endif
+}
@@ -83,6 +83,7 @@ public:
     // Add a property to the property bag. If the property already exists, it is overwritten.
     // Returns true if the property was newly added, false if it already existed or could not be added.
     bool add(common_property key, const pal::char_t *value);
+    bool add(common_property key, pal::string_t &&value);
     bool add(const pal::char_t *key, const pal::char_t *value);
 
     bool try_get(common_property key, const pal::char_t **value) const;
@@ -96,6 +97,11 @@ public:
 
     void enumerate(std::function<void(const pal::string_t&, const pal::string_t&)> &callback) const;
 
+    // Gets the keys and values the way coreclr_initialize takes them. Where pal::char_t is char they are
+    // the strings of the bag itself, so they are only valid while the bag is not changed. Otherwise they
+    // are converted into clr_strings.
+    void get_clr_properties(std::vector<const char*> *keys, std::vector<const char*> *values, std::vector<std::vector<char>> *clr_strings) const;
+
 private:
     std::unordered_map<pal::string_t, pal::string_t> _properties;
 };
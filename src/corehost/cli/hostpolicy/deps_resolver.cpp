@@ -2,11 +2,16 @@
 // The .NET Foundation licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 
+#include <algorithm>
+#include <atomic>
 #include <set>
 #include <functional>
 #include <cassert>
+#include <exception>
+#include <thread>
 
 #include <trace.h>
+#include <env_snapshot.h>
 #include <deps_entry.h>
 #include <deps_format.h>
 #include "deps_resolver.h"
@@ -46,14 +51,14 @@ void add_unique_path(
 {
     // Resolve sym links.
     pal::string_t real = path;
-    pal::realpath(&real);
+    pal::realpath_cached(&real);
 
     if (existing->count(real))
     {
         return;
     }
 
-    trace::verbose(_X("Adding to %s path: %s"), deps_entry_t::s_known_asset_types[asset_type], real.c_str());
+    TRACE_VERBOSE(_X("Adding to %s path: %s"), deps_entry_t::s_known_asset_types[asset_type], real.c_str());
 
     if (starts_with(real, svc_dir, false))
     {
@@ -99,7 +104,7 @@ void deps_resolver_t::add_tpa_asset(
     name_to_resolved_asset_map_t::iterator existing = items->find(resolved_asset.asset.name);
     if (existing == items->end())
     {
-        trace::verbose(_X("Adding tpa entry: %s, AssemblyVersion: %s, FileVersion: %s"),
+        TRACE_VERBOSE(_X("Adding tpa entry: %s, AssemblyVersion: %s, FileVersion: %s"),
             resolved_asset.resolved_path.c_str(),
             resolved_asset.asset.assembly_version.as_str().c_str(),
             resolved_asset.asset.file_version.as_str().c_str());
@@ -121,37 +126,56 @@ void deps_resolver_t::get_dir_assemblies(
     trace::verbose(_X("Adding files from %s dir %s"), dir_name.c_str(), dir.c_str());
 
     // Managed extensions in priority order, pick DLL over EXE and NI over IL.
-    const pal::string_t managed_ext[] = { _X(".ni.dll"), _X(".dll"), _X(".ni.exe"), _X(".exe") };
+    const pal::char_t* managed_ext[] = { _X(".ni.dll"), _X(".dll"), _X(".ni.exe"), _X(".exe") };
+    const size_t managed_ext_length[] = { 7, 4, 7, 4 };
+    const size_t managed_ext_count = sizeof(managed_ext) / sizeof(managed_ext[0]);
 
-    // List of files in the dir
-    std::vector<pal::string_t> files;
-    pal::readdir(dir, &files);
+    // The directory is read once and each file is classified by the extensions it has. A file can have
+    // two of them (.ni.dll is also .dll), in which case it is a candidate for two names.
+    struct candidate_t
+    {
+        size_t file_index;
+        size_t name_length;
+    };
 
-    for (const auto& ext : managed_ext)
+    std::vector<pal::string_t> files;
+    std::vector<candidate_t> candidates[managed_ext_count];
+    pal::enumerate_dir(dir, _X("*"), false, [&](const pal::char_t* file)
     {
-        for (const auto& file : files)
+        size_t length = pal::strlen(file);
+        bool is_candidate = false;
+        for (size_t i = 0; i < managed_ext_count; ++i)
         {
-            // Nothing to do if file length is smaller than expected ext.
-            if (file.length() <= ext.length())
+            // The name in front of the extension can't be empty.
+            if (length > managed_ext_length[i] && pal::strcasecmp(file + length - managed_ext_length[i], managed_ext[i]) == 0)
             {
-                continue;
+                candidates[i].push_back(candidate_t{ files.size(), length - managed_ext_length[i] });
+                is_candidate = true;
             }
+        }
 
-            auto file_name = file.substr(0, file.length() - ext.length());
-            auto file_ext = file.substr(file_name.length());
+        if (is_candidate)
+        {
+            files.emplace_back(file);
+        }
+    });
 
-            // Ext did not match expected ext, skip this file.
-            if (pal::strcasecmp(file_ext.c_str(), ext.c_str()))
-            {
-                continue;
-            }
+    // Add the candidates by priority of their extensions, and in directory order for each extension, so the
+    // first candidate for each name wins.
+    for (const auto& ext_candidates : candidates)
+    {
+        for (const auto& candidate : ext_candidates)
+        {
+            const pal::string_t& file = files[candidate.file_index];
+            pal::string_t file_name = file.substr(0, candidate.name_length);
 
             // Already added entry for this asset, by priority order skip this ext
-            if (items->count(file_name))
+            auto existing = items->find(file_name);
+            if (existing != items->end())
             {
-                trace::verbose(_X("Skipping %s because the %s already exists in %s assemblies"),
+                TRACE_VERBOSE(_X("Skipping %s because the %s already exists in %s assemblies"),
                     file.c_str(),
-                    items->find(file_name)->second.asset.relative_path.c_str(),
+                    existing->second.asset.relative_path.c_str(),
                     dir_name.c_str());
 
                 continue;
@@ -165,14 +189,20 @@ void deps_resolver_t::get_dir_assemblies(
             }
             file_path.append(file);
 
-            trace::verbose(_X("Adding %s to %s assembly set from %s"),
+            TRACE_VERBOSE(_X("Adding %s to %s assembly set from %s"),
                 file_name.c_str(),
                 dir_name.c_str(),
                 file_path.c_str());
 
-            deps_asset_t asset(file_name, file, empty, empty);
-            deps_resolved_asset_t resolved_asset(asset, file_path);
-            add_tpa_asset(resolved_asset, items);
+            // Same as add_tpa_asset, but the entry is known not to exist yet and the strings can be moved into it
+            TRACE_VERBOSE(_X("Adding tpa entry: %s, AssemblyVersion: %s, FileVersion: %s"),
+                file_path.c_str(),
+                empty.as_str().c_str(),
+                empty.as_str().c_str());
+
+            deps_resolved_asset_t resolved_asset(deps_asset_t(file_name, file, empty, empty), pal::string_t());
+            resolved_asset.resolved_path.swap(file_path);
+            items->emplace(std::move(file_name), std::move(resolved_asset));
         }
     }
 }
@@ -288,17 +318,17 @@ bool deps_resolver_t::probe_deps_entry(const deps_entry_t& entry, const pal::str
 
     for (const auto& config : m_probes)
     {
-        trace::verbose(_X("  Considering entry [%s/%s/%s], probe dir [%s], probe fx level:%d, entry fx level:%d"),
+        TRACE_VERBOSE(_X("  Considering entry [%s/%s/%s], probe dir [%s], probe fx level:%d, entry fx level:%d"),
             entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str(), config.probe_dir.c_str(), config.fx_level, fx_level);
 
         if (config.only_serviceable_assets && !entry.is_serviceable)
         {
-            trace::verbose(_X("    Skipping... not serviceable asset"));
+            TRACE_VERBOSE(_X("    Skipping... not serviceable asset"));
             continue;
         }
         if (config.only_runtime_assets && entry.asset_type != deps_entry_t::asset_types::runtime)
         {
-            trace::verbose(_X("    Skipping... not runtime asset"));
+            TRACE_VERBOSE(_X("    Skipping... not runtime asset"));
             continue;
         }
         pal::string_t probe_dir = config.probe_dir;
@@ -316,14 +346,14 @@ bool deps_resolver_t::probe_deps_entry(const deps_entry_t& entry, const pal::str
                 // If the deps json has the package name and version, then someone has already done rid selection and
                 // put the right asset in the dir. So checking just package name and version would suffice.
                 // No need to check further for the exact asset relative sub path.
-                if (config.probe_deps_json->has_package(entry.library_name, entry.library_version) && entry.to_dir_path(probe_dir, candidate))
+                if (config.probe_deps_json->has_package(entry.get_package_key()) && entry.to_dir_path(probe_dir, candidate, &m_dir_cache))
                 {
-                    trace::verbose(_X("    Probed deps json and matched '%s'"), candidate->c_str());
+                    TRACE_VERBOSE(_X("    Probed deps json and matched '%s'"), candidate->c_str());
                     return true;
                 }
             }
 
-            trace::verbose(_X("    Skipping... not found in deps json."));
+            TRACE_VERBOSE(_X("    Skipping... not found in deps json."));
         }
         else if (config.is_app())
         {
@@ -334,32 +364,32 @@ bool deps_resolver_t::probe_deps_entry(const deps_entry_t& entry, const pal::str
             {
                 if (entry.is_rid_specific)
                 {
-                    if (entry.to_rel_path(deps_dir, candidate))
+                    if (entry.to_rel_path(deps_dir, candidate, &m_dir_cache))
                     {
-                        trace::verbose(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
+                        TRACE_VERBOSE(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
                         return true;
                     }
                 }
                 else
                 {
                     // Non-rid assets, lookup in the published dir.
-                    if (entry.to_dir_path(deps_dir, candidate))
+                    if (entry.to_dir_path(deps_dir, candidate, &m_dir_cache))
                     {
-                        trace::verbose(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
+                        TRACE_VERBOSE(_X("    Probed deps dir and matched '%s'"), candidate->c_str());
                         return true;
                     }
                 }
             }
 
-            trace::verbose(_X("    Skipping... not found in deps dir '%s'"), deps_dir.c_str());
+            TRACE_VERBOSE(_X("    Skipping... not found in deps dir '%s'"), deps_dir.c_str());
         }
-        else if (entry.to_full_path(probe_dir, candidate))
+        else if (entry.to_full_path(probe_dir, candidate, &m_dir_cache))
         {
-            trace::verbose(_X("    Probed package dir and matched '%s'"), candidate->c_str());
+            TRACE_VERBOSE(_X("    Probed package dir and matched '%s'"), candidate->c_str());
             return true;
         }
 
-        trace::verbose(_X("    Skipping... not found in probe dir '%s'"), probe_dir.c_str());
+        TRACE_VERBOSE(_X("    Skipping... not found in probe dir '%s'"), probe_dir.c_str());
         // continue to try next probe config
     }
     return false;
@@ -431,7 +461,7 @@ bool deps_resolver_t::resolve_tpa_list(
             return true;
         }
 
-        trace::info(_X("Processing TPA for deps entry [%s, %s, %s]"), entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
+        TRACE_INFO(_X("Processing TPA for deps entry [%s, %s, %s]"), entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
 
         pal::string_t resolved_path;
 
@@ -474,7 +504,7 @@ bool deps_resolver_t::resolve_tpa_list(
                     // If the path is the same, then no need to replace
                     if (resolved_path != existing_entry->resolved_path)
                     {
-                        trace::verbose(_X("Replacing deps entry [%s, AssemblyVersion:%s, FileVersion:%s] with [%s, AssemblyVersion:%s, FileVersion:%s]"),
+                        TRACE_VERBOSE(_X("Replacing deps entry [%s, AssemblyVersion:%s, FileVersion:%s] with [%s, AssemblyVersion:%s, FileVersion:%s]"),
                             existing_entry->resolved_path.c_str(), existing_entry->asset.assembly_version.as_str().c_str(), existing_entry->asset.file_version.as_str().c_str(),
                             resolved_path.c_str(), entry.asset.assembly_version.as_str().c_str(), entry.asset.file_version.as_str().c_str());
 
@@ -561,12 +591,22 @@ bool deps_resolver_t::resolve_tpa_list(
         }
     }
 
-    // Convert the paths into a string and return it 
+    // Convert the paths into a string and return it. The string is reserved up front, with room for
+    // CoreLib which is appended to it by hostpolicy_context_t, so that it isn't reallocated as it grows.
+    size_t tpa_length = output->length() + PATH_MAX;
+    for (const auto& item : items)
+    {
+        tpa_length += item.second.resolved_path.length() + 1;
+    }
+
+    output->reserve(tpa_length);
+
+    pal::string_t real_asset_path;
     for (const auto& item : items)
     {
         // Workaround for CoreFX not being able to resolve sym links.
-        pal::string_t real_asset_path = item.second.resolved_path;
-        pal::realpath(&real_asset_path);
+        real_asset_path.assign(item.second.resolved_path);
+        pal::realpath_cached(&real_asset_path);
         output->append(real_asset_path);
         output->push_back(PATH_SEPARATOR);
     }
@@ -598,7 +638,10 @@ void deps_resolver_t::init_known_entry_path(const deps_entry_t& entry, const pal
     }
 }
 
-void deps_resolver_t::resolve_additional_deps(const arguments_t& args, const deps_json_t::rid_fallback_graph_t& rid_fallback_graph)
+void deps_resolver_t::resolve_additional_deps(
+    const arguments_t& args,
+    const deps_json_t::rid_fallback_graph_t& rid_fallback_graph,
+    std::vector<std::function<void()>>* deferred_parses)
 {
     if (!m_is_framework_dependent
         || m_host_mode == host_mode_t::libhost)
@@ -706,8 +749,113 @@ void deps_resolver_t::resolve_additional_deps(const arguments_t& args, const dep
 
     for (pal::string_t json_file : m_additional_deps_files)
     {
-        m_additional_deps.push_back(std::unique_ptr<deps_json_t>(
-            new deps_json_t(true, json_file, rid_fallback_graph)));
+        if (deferred_parses != nullptr)
+        {
+            deps_json_t* deps = new deps_json_t();
+            m_additional_deps.push_back(std::unique_ptr<deps_json_t>(deps));
+            const deps_json_t::rid_fallback_graph_t* graph = &rid_fallback_graph;
+            deferred_parses->push_back([deps, json_file, graph]() { deps->parse(true, json_file, *graph); });
+        }
+        else
+        {
+            m_additional_deps.push_back(std::unique_ptr<deps_json_t>(
+                new deps_json_t(true, json_file, rid_fallback_graph)));
+        }
+    }
+}
+
+bool deps_resolver_t::is_parallel_deps_parsing_enabled()
+{
+    return env_snapshot::is_enabled(env_key_t::DOTNET_DEPS_PARALLEL_PARSING);
+}
+
+void deps_resolver_t::run_parallel(const std::vector<std::function<void()>>& parses)
+{
+    // Parsing is mostly bound by memory allocation and file access, so a few threads are enough.
+    const size_t max_thread_count = 4;
+    size_t thread_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), max_thread_count);
+    thread_count = std::min(thread_count, parses.size());
+
+    trace::verbose(_X("Parsing %d deps files using %d threads"), static_cast<int>(parses.size()), static_cast<int>(thread_count));
+
+    // Each parse traces into its own buffer, so that the output is the same regardless of the scheduling.
+    // An exception escaping a thread would terminate the process, so they are caught and rethrown on
+    // the calling thread once all the threads are done.
+    std::vector<trace::buffer_t> trace_buffers(parses.size());
+    std::vector<std::exception_ptr> exceptions(parses.size());
+    std::atomic<size_t> next_parse(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next_parse++; i < parses.size(); i = next_parse++)
+        {
+            trace::buffer_t* previous_buffer = trace::set_buffer(&trace_buffers[i]);
+            try
+            {
+                parses[i]();
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+
+            trace::set_buffer(previous_buffer);
+        }
+    };
+
+    // Joins the started threads on every path out of here, as a thread which is still joinable when it is
+    // destroyed terminates the process.
+    struct thread_joiner_t
+    {
+        std::vector<std::thread> threads;
+
+        ~thread_joiner_t()
+        {
+            join();
+        }
+
+        void join()
+        {
+            for (std::thread& thread : threads)
+            {
+                if (thread.joinable())
+                {
+                    thread.join();
+                }
+            }
+        }
+    } joiner;
+
+    // Threads might not be available (e.g. due to a limit on the number of processes), in which case the
+    // threads which did start and the current thread, which does its share of the work as well, parse
+    // the rest. The space is reserved up front, so that adding a started thread can't fail.
+    try
+    {
+        joiner.threads.reserve(thread_count - 1);
+        for (size_t i = 1; i < thread_count; ++i)
+        {
+            joiner.threads.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+        trace::verbose(_X("Could only start %d of %d threads for parsing deps files"),
+            static_cast<int>(joiner.threads.size() + 1), static_cast<int>(thread_count));
+    }
+
+    worker();
+    joiner.join();
+
+    for (const trace::buffer_t& trace_buffer : trace_buffers)
+    {
+        trace::write_buffer(trace_buffer);
+    }
+
+    for (const std::exception_ptr& exception : exceptions)
+    {
+        if (exception != nullptr)
+        {
+            std::rethrow_exception(exception);
+        }
     }
 }
 
@@ -758,7 +906,7 @@ bool deps_resolver_t::resolve_probe_dirs(
     std::unordered_set<pal::string_t> items;
 
     pal::string_t core_servicing = m_core_servicing;
-    pal::realpath(&core_servicing, true);
+    pal::realpath_cached(&core_servicing, true);
 
     // Filter out non-serviced assets so the paths can be added after servicing paths.
     pal::string_t non_serviced;
@@ -786,7 +934,7 @@ bool deps_resolver_t::resolve_probe_dirs(
             return true;
         }
 
-        trace::verbose(_X("Processing native/culture for deps entry [%s, %s, %s]"), 
+        TRACE_VERBOSE(_X("Processing native/culture for deps entry [%s, %s, %s]"), 
             entry.library_name.c_str(), entry.library_version.c_str(), entry.asset.relative_path.c_str());
 
         if (probe_deps_entry(entry, deps_dir, fx_level, &candidate))
@@ -890,6 +1038,8 @@ bool deps_resolver_t::resolve_probe_paths(probe_paths_t* probe_paths, std::unord
         return false;
     }
 
+    m_dir_cache.trace_summary();
+
     // If we found coreclr and the jit during native path probe, set the paths now.
     probe_paths->coreclr = m_coreclr_path;
     probe_paths->clrjit = m_clrjit_path;
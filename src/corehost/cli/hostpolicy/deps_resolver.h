@@ -5,6 +5,7 @@
 #ifndef DEPS_RESOLVER_H
 #define DEPS_RESOLVER_H
 
+#include <functional>
 #include <vector>
 
 #include "pal.h"
@@ -13,6 +14,7 @@
 #include "fx_definition.h"
 #include "deps_format.h"
 #include "deps_entry.h"
+#include "dir_listing_cache.h"
 #include "runtime_config.h"
 
 // Probe paths to be resolved for ordering
@@ -62,6 +64,11 @@ public:
             root_framework_rid_fallback_graph = &m_fx_definitions[root_framework]->get_deps().get_rid_fallback_graph();
         }
 
+        // When enabled, all the deps files except for the root framework's (which provides the RID graph)
+        // are parsed at the same time once they are all known.
+        std::vector<std::function<void()>> deferred_parses;
+        bool parse_in_parallel = is_parallel_deps_parsing_enabled();
+
         for (int i = lowest_framework; i >= 0; --i)
         {
             if (i == 0)
@@ -80,6 +87,11 @@ public:
             {
                 m_fx_definitions[i]->parse_deps();
             }
+            else if (parse_in_parallel)
+            {
+                fx_definition_t* fx = m_fx_definitions[i].get();
+                deferred_parses.push_back([fx, root_framework_rid_fallback_graph]() { fx->parse_deps(*root_framework_rid_fallback_graph); });
+            }
             else
             {
                 // The rid graph is obtained from the root framework
@@ -87,7 +99,12 @@ public:
             }
         }
 
-        resolve_additional_deps(args, *root_framework_rid_fallback_graph);
+        resolve_additional_deps(args, *root_framework_rid_fallback_graph, parse_in_parallel ? &deferred_parses : nullptr);
+
+        if (!deferred_parses.empty())
+        {
+            run_parallel(deferred_parses);
+        }
 
         setup_additional_probes(args.probe_paths);
         setup_probe_config(args);
@@ -147,9 +164,11 @@ public:
         const deps_entry_t& entry,
         const pal::string_t& path);
 
+    // If deferred_parses is specified, the additional deps files are added to it instead of being parsed.
     void resolve_additional_deps(
         const arguments_t& args,
-        const deps_json_t::rid_fallback_graph_t& rid_fallback_graph);
+        const deps_json_t::rid_fallback_graph_t& rid_fallback_graph,
+        std::vector<std::function<void()>>* deferred_parses);
 
     const deps_json_t& get_deps() const
     {
@@ -178,6 +197,24 @@ public:
         return m_is_framework_dependent;
     }
 
+    const dir_listing_cache_t& get_dir_cache() const
+    {
+        return m_dir_cache;
+    }
+
+    dir_listing_cache_t& get_dir_cache()
+    {
+        return m_dir_cache;
+    }
+
+    static pal::string_t get_fx_deps(const pal::string_t& fx_dir, const pal::string_t& fx_name)
+    {
+        pal::string_t fx_deps = fx_dir;
+        pal::string_t fx_deps_name = fx_name + _X(".deps.json");
+        append_path(&fx_deps, fx_deps_name.c_str());
+        return fx_deps;
+    }
+
     const pal::string_t &get_app_dir() const
     {
         if (m_host_mode == host_mode_t::libhost)
@@ -189,15 +226,18 @@ public:
         return m_app_dir;
     }
 
+    // Populate assemblies from the directory.
+    static void get_dir_assemblies(
+        const pal::string_t& dir,
+        const pal::string_t& dir_name,
+        name_to_resolved_asset_map_t* items);
+
 private:
 
-    static pal::string_t get_fx_deps(const pal::string_t& fx_dir, const pal::string_t& fx_name)
-    {
-        pal::string_t fx_deps = fx_dir;
-        pal::string_t fx_deps_name = fx_name + _X(".deps.json");
-        append_path(&fx_deps, fx_deps_name.c_str());
-        return fx_deps;
-    }
+    static bool is_parallel_deps_parsing_enabled();
+
+    // Runs the parses on a small number of threads and writes out their trace output in order.
+    static void run_parallel(const std::vector<std::function<void()>>& parses);
 
     // Resolve order for TPA lookup.
     bool resolve_tpa_list(
@@ -211,12 +251,6 @@ private:
         pal::string_t* output,
         std::unordered_set<pal::string_t>* breadcrumb);
 
-    // Populate assemblies from the directory.
-    void get_dir_assemblies(
-        const pal::string_t& dir,
-        const pal::string_t& dir_name,
-        name_to_resolved_asset_map_t* items);
-
     // Probe entry in probe configurations and deps dir.
     bool probe_deps_entry(
         const deps_entry_t& entry,
@@ -228,7 +262,7 @@ private:
 
     pal::string_t m_app_dir;
 
-    void add_tpa_asset(
+    static void add_tpa_asset(
         const deps_resolved_asset_t& asset,
         name_to_resolved_asset_map_t* items);
 
@@ -264,6 +298,9 @@ private:
 
     // Is the deps file for an app using shared frameworks?
     bool m_is_framework_dependent;
+
+    // Listings of the directories looked at while probing
+    dir_listing_cache_t m_dir_cache;
 };
 
 #endif // DEPS_RESOLVER_H
@@ -13,6 +13,7 @@
 #include <utils.h>
 #include "coreclr.h"
 #include <error_codes.h>
+#include <env_snapshot.h>
 #include "breadcrumbs.h"
 #include <host_startup_info.h>
 #include <corehost_context_contract.h>
@@ -297,11 +298,16 @@ SHARED_API int HOSTPOLICY_CALLTYPE corehost_load(host_interface_t* init)
     assert(init != nullptr);
     std::lock_guard<std::mutex> lock{ g_init_lock };
 
+    // Symlinks might have changed since the last load
+    pal::clear_realpath_cache();
+
     if (g_init_done)
     {
         // Since the host command is set during load _and_
         // load is considered re-entrant due to how testing is
         // done, permit the re-initialization of the host command.
+        // The environment might have changed since the last load as well.
+        env_snapshot::capture();
         hostpolicy_init_t::init_host_command(init, &g_init);
         return StatusCode::Success;
     }
@@ -849,6 +855,18 @@ SHARED_API int HOSTPOLICY_CALLTYPE corehost_resolve_component_dependencies(
 
     // The RID graph still has to come from the actuall root framework, so take that from the g_init.fx_definitions
     // which are the frameworks for the app.
+    // When the app was started from the startup cache its deps files were never loaded, so load the root one now,
+    // with the full graph. Otherwise the app loaded the entries for the host RID, which are the ones the resolver uses.
+    static std::once_flag root_deps_loaded;
+    std::call_once(root_deps_loaded, []()
+    {
+        fx_definition_t& root_framework = *g_init.fx_definitions.back();
+        if (root_framework.get_deps().get_deps_file().empty())
+        {
+            root_framework.parse_deps(deps_json_t::rid_fallback_graph_mode_t::full);
+        }
+    });
+
     deps_resolver_t resolver(
         args,
         component_fx_definitions,
@@ -5,6 +5,8 @@
 #include "hostpolicy_context.h"
 
 #include "deps_resolver.h"
+#include "startup_cache.h"
+#include <env_snapshot.h>
 #include <error_codes.h>
 #include <trace.h>
 
@@ -15,6 +17,84 @@ namespace
         trace::error(_X("Duplicate runtime property found: %s"), property_key);
         trace::error(_X("It is invalid to specify values for properties populated by the hosting layer in the the application's .runtimeconfig.json"));
     }
+
+    // Resolves the dependencies of the app, and saves the result to the startup cache if one is specified.
+    int resolve_dependencies(
+        hostpolicy_init_t &hostpolicy_init,
+        const arguments_t &args,
+        std::unordered_set<pal::string_t> *breadcrumbs,
+        const startup_cache_t *startup_cache,
+        startup_resolution_t *resolution)
+    {
+        deps_resolver_t resolver
+            {
+                args,
+                hostpolicy_init.fx_definitions,
+                /* root_framework_rid_fallback_graph */ nullptr, // This means that the fx_definitions contains the root framework
+                hostpolicy_init.is_framework_dependent
+            };
+
+        pal::string_t resolver_errors;
+        if (!resolver.valid(&resolver_errors))
+        {
+            trace::error(_X("Error initializing the dependency resolver: %s"), resolver_errors.c_str());
+            return StatusCode::ResolverInitFailure;
+        }
+
+        // The startup cache is only valid as long as none of the probed directories change.
+        if (startup_cache != nullptr)
+        {
+            resolver.get_dir_cache().record_dir_stamps();
+        }
+
+        if (!resolver.resolve_probe_paths(&resolution->probe_paths, breadcrumbs))
+        {
+            return StatusCode::ResolverResolveFailure;
+        }
+
+        const fx_definition_vector_t &fx_definitions = resolver.get_fx_definitions();
+
+        if (resolver.is_framework_dependent())
+        {
+            // Use the root fx to define FX_DEPS_FILE
+            resolution->fx_deps = get_root_framework(fx_definitions).get_deps_file();
+        }
+
+        fx_definition_vector_t::iterator fx_begin;
+        fx_definition_vector_t::iterator fx_end;
+        resolver.get_app_fx_definition_range(&fx_begin, &fx_end);
+
+        pal::string_t &app_context_deps_str = resolution->app_context_deps;
+        fx_definition_vector_t::iterator fx_curr = fx_begin;
+        while (fx_curr != fx_end)
+        {
+            if (fx_curr != fx_begin)
+                app_context_deps_str += _X(';');
+
+            app_context_deps_str += (*fx_curr)->get_deps_file();
+            ++fx_curr;
+        }
+
+        if (resolver.is_framework_dependent())
+        {
+            resolution->clr_library_version = get_root_framework(fx_definitions).get_found_version();
+        }
+        else
+        {
+            resolution->clr_library_version = resolver.get_coreclr_library_version();
+        }
+
+        resolution->app_base = resolver.get_app_dir();
+        resolution->probing_directories = resolver.get_lookup_probe_directories();
+
+        if (startup_cache != nullptr)
+        {
+            static const std::unordered_set<pal::string_t> no_breadcrumbs;
+            startup_cache->save(*resolution, breadcrumbs != nullptr ? *breadcrumbs : no_breadcrumbs, resolver.get_dir_cache());
+        }
+
+        return StatusCode::Success;
+    }
 }
 
 int hostpolicy_context_t::initialize(hostpolicy_init_t &hostpolicy_init, const arguments_t &args, bool enable_breadcrumbs)
@@ -24,23 +104,6 @@ int hostpolicy_context_t::initialize(hostpolicy_init_t &hostpolicy_init, const a
     host_path = args.host_path;
     breadcrumbs_enabled = enable_breadcrumbs;
 
-    deps_resolver_t resolver
-        {
-            args,
-            hostpolicy_init.fx_definitions,
-            /* root_framework_rid_fallback_graph */ nullptr, // This means that the fx_definitions contains the root framework
-            hostpolicy_init.is_framework_dependent
-        };
-
-    pal::string_t resolver_errors;
-    if (!resolver.valid(&resolver_errors))
-    {
-        trace::error(_X("Error initializing the dependency resolver: %s"), resolver_errors.c_str());
-        return StatusCode::ResolverInitFailure;
-    }
-
-    probe_paths_t probe_paths;
-
     // Setup breadcrumbs.
     if (breadcrumbs_enabled)
     {
@@ -50,22 +113,37 @@ int hostpolicy_context_t::initialize(hostpolicy_init_t &hostpolicy_init, const a
         // Always insert the hostpolicy that the code is running on.
         breadcrumbs.insert(policy_name);
         breadcrumbs.insert(policy_name + _X(",") + policy_version);
+    }
 
-        if (!resolver.resolve_probe_paths(&probe_paths, &breadcrumbs))
+    startup_resolution_t resolution;
+    startup_cache_t startup_cache;
+    bool use_startup_cache = startup_cache_t::is_enabled() && startup_cache.initialize(args, hostpolicy_init, breadcrumbs_enabled);
+    if (use_startup_cache && startup_cache.load(&resolution, &breadcrumbs))
+    {
+        // The deps files are not loaded, but where they are is still needed to load them on demand.
+        for (size_t i = 0; i < hostpolicy_init.fx_definitions.size(); ++i)
         {
-            return StatusCode::ResolverResolveFailure;
+            auto& fx = hostpolicy_init.fx_definitions[i];
+            fx->set_deps_file(i == 0 ? args.deps_path : deps_resolver_t::get_fx_deps(fx->get_dir(), fx->get_name()));
         }
     }
     else
     {
-        if (!resolver.resolve_probe_paths(&probe_paths, nullptr))
+        int rc = resolve_dependencies(
+            hostpolicy_init,
+            args,
+            breadcrumbs_enabled ? &breadcrumbs : nullptr,
+            use_startup_cache ? &startup_cache : nullptr,
+            &resolution);
+        if (rc != StatusCode::Success)
         {
-            return StatusCode::ResolverResolveFailure;
+            return rc;
         }
     }
 
+    probe_paths_t& probe_paths = resolution.probe_paths;
     clr_path = probe_paths.coreclr;
-    if (clr_path.empty() || !pal::realpath(&clr_path))
+    if (clr_path.empty() || !pal::realpath_cached(&clr_path))
     {
         trace::error(_X("Could not resolve CoreCLR path. For more details, enable tracing by setting COREHOST_TRACE environment variable to 1"));
         return StatusCode::CoreClrResolveFailure;
@@ -91,7 +169,7 @@ int hostpolicy_context_t::initialize(hostpolicy_init_t &hostpolicy_init, const a
     {
         trace::warning(_X("Could not resolve CLRJit path"));
     }
-    else if (pal::realpath(&clrjit_path))
+    else if (pal::realpath_cached(&clrjit_path))
     {
         trace::verbose(_X("The resolved JIT path is '%s'"), clrjit_path.c_str());
     }
@@ -101,50 +179,19 @@ int hostpolicy_context_t::initialize(hostpolicy_init_t &hostpolicy_init, const a
         trace::warning(_X("Could not resolve symlink to CLRJit path '%s'"), probe_paths.clrjit.c_str());
     }
 
-    const fx_definition_vector_t &fx_definitions = resolver.get_fx_definitions();
-
-    pal::string_t fx_deps_str;
-    if (resolver.is_framework_dependent())
-    {
-        // Use the root fx to define FX_DEPS_FILE
-        fx_deps_str = get_root_framework(fx_definitions).get_deps_file();
-    }
-
-    fx_definition_vector_t::iterator fx_begin;
-    fx_definition_vector_t::iterator fx_end;
-    resolver.get_app_fx_definition_range(&fx_begin, &fx_end);
-
-    pal::string_t app_context_deps_str;
-    fx_definition_vector_t::iterator fx_curr = fx_begin;
-    while (fx_curr != fx_end)
-    {
-        if (fx_curr != fx_begin)
-            app_context_deps_str += _X(';');
-
-        app_context_deps_str += (*fx_curr)->get_deps_file();
-        ++fx_curr;
-    }
-
-    pal::string_t clr_library_version;
-    if (resolver.is_framework_dependent())
-    {
-        clr_library_version = get_root_framework(fx_definitions).get_found_version();
-    }
-    else
-    {
-        clr_library_version = resolver.get_coreclr_library_version();
-    }
+    pal::trace_realpath_cache_stats();
 
     // Build properties for CoreCLR instantiation
-    pal::string_t app_base = resolver.get_app_dir();
-    coreclr_properties.add(common_property::TrustedPlatformAssemblies, probe_paths.tpa.c_str());
-    coreclr_properties.add(common_property::NativeDllSearchDirectories, probe_paths.native.c_str());
-    coreclr_properties.add(common_property::PlatformResourceRoots, probe_paths.resources.c_str());
+    const pal::string_t& app_base = resolution.app_base;
+    // The search paths are large and not used after this, so they are moved into the properties
+    coreclr_properties.add(common_property::TrustedPlatformAssemblies, std::move(probe_paths.tpa));
+    coreclr_properties.add(common_property::NativeDllSearchDirectories, std::move(probe_paths.native));
+    coreclr_properties.add(common_property::PlatformResourceRoots, std::move(probe_paths.resources));
     coreclr_properties.add(common_property::AppContextBaseDirectory, app_base.c_str());
-    coreclr_properties.add(common_property::AppContextDepsFiles, app_context_deps_str.c_str());
-    coreclr_properties.add(common_property::FxDepsFile, fx_deps_str.c_str());
-    coreclr_properties.add(common_property::ProbingDirectories, resolver.get_lookup_probe_directories().c_str());
-    coreclr_properties.add(common_property::FxProductVersion, clr_library_version.c_str());
+    coreclr_properties.add(common_property::AppContextDepsFiles, resolution.app_context_deps.c_str());
+    coreclr_properties.add(common_property::FxDepsFile, resolution.fx_deps.c_str());
+    coreclr_properties.add(common_property::ProbingDirectories, resolution.probing_directories.c_str());
+    coreclr_properties.add(common_property::FxProductVersion, resolution.clr_library_version.c_str());
 
     if (!clrjit_path.empty())
         coreclr_properties.add(common_property::JitPath, clrjit_path.c_str());
@@ -188,7 +235,7 @@ int hostpolicy_context_t::initialize(hostpolicy_init_t &hostpolicy_init, const a
 
     // Startup hooks
     pal::string_t startup_hooks;
-    if (pal::getenv(_X("DOTNET_STARTUP_HOOKS"), &startup_hooks))
+    if (env_snapshot::get(env_key_t::DOTNET_STARTUP_HOOKS, &startup_hooks))
     {
         if (!coreclr_properties.add(common_property::StartUpHooks, startup_hooks.c_str()))
         {
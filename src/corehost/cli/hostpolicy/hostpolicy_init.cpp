@@ -126,6 +126,25 @@ bool hostpolicy_init_t::init(host_interface_t* input, hostpolicy_init_t* init)
         // For the backwards compat case, this will be later initialized with argv[0]
     }
 
+    // hostfxr already loaded the root framework's deps file while resolving hostpolicy. Reuse it
+    // instead of parsing the file again, but only if hostfxr was built with the same deps_json_t
+    // layout. The instance belongs to hostfxr, so it is copied rather than referenced.
+    if (input->version_lo >= offsetof(host_interface_t, root_deps_layout) + sizeof(input->root_deps_layout)
+        && input->root_deps != nullptr
+        && !init->fx_definitions.empty())
+    {
+        if (pal::strcmp(input->root_deps_layout, deps_json_t::get_layout_id()) == 0)
+        {
+            const deps_json_t& root_deps = *static_cast<const deps_json_t*>(input->root_deps);
+            trace::verbose(_X("Using deps file [%s] loaded by the host"), root_deps.get_deps_file().c_str());
+            init->fx_definitions.back()->set_preloaded_deps(root_deps);
+        }
+        else
+        {
+            trace::verbose(_X("Ignoring deps loaded by the host with layout [%s]; expected layout [%s]"), input->root_deps_layout, deps_json_t::get_layout_id());
+        }
+    }
+
     return true;
 }
 
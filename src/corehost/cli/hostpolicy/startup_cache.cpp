@@ -0,0 +1,317 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "startup_cache.h"
+#include "cache_io.h"
+#include <algorithm>
+#include <env_snapshot.h>
+#include <trace.h>
+#include <utils.h>
+
+// Startup cache file layout
+//
+// The file starts with the key, which has to match exactly for the cache to be used. It is followed
+// by the stamps of the directories listed while probing, which have to match the current state of
+// those directories, and then by the results of the resolution.
+
+namespace
+{
+    const uint32_t cache_magic = 0x54525453; // "STRT"
+    const uint32_t cache_format_version = 1;
+
+    pal::string_t trim_trailing_separators(const pal::string_t& dir)
+    {
+        pal::string_t trimmed = dir;
+        while (trimmed.length() > 1 && (trimmed.back() == DIR_SEPARATOR || trimmed.back() == _X('/')))
+        {
+            trimmed.pop_back();
+        }
+
+        return trimmed;
+    }
+
+    void write_stamp(cache_writer_t& writer, const pal::string_t& path, std::vector<pal::file_stamp_t>* stamps)
+    {
+        pal::file_stamp_t stamp;
+        bool exists = pal::get_file_stamp(path, &stamp);
+
+        writer.write_string(path);
+        writer.write_value(static_cast<uint8_t>(exists));
+        if (exists)
+        {
+            writer.write_value(stamp.size);
+            writer.write_value(stamp.last_write_time);
+            stamps->push_back(stamp);
+        }
+    }
+
+    void write_strings(cache_writer_t& writer, const std::vector<pal::string_t>& strings)
+    {
+        writer.write_value(static_cast<uint32_t>(strings.size()));
+        for (const auto& str : strings)
+        {
+            writer.write_string(str);
+        }
+    }
+
+    bool read_dir_stamps_match(cache_reader_t& reader)
+    {
+        uint32_t count;
+        if (!reader.read_value(&count))
+        {
+            return false;
+        }
+
+        pal::string_t dir;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint8_t existed;
+            pal::file_stamp_t stamp;
+            if (!reader.read_string(&dir) || !reader.read_value(&existed))
+            {
+                return false;
+            }
+
+            if (existed && (!reader.read_value(&stamp.size) || !reader.read_value(&stamp.last_write_time)))
+            {
+                return false;
+            }
+
+            pal::file_stamp_t current;
+            bool exists = pal::get_file_stamp(dir, &current);
+            if (exists != (existed != 0) || (exists && current != stamp))
+            {
+                trace::verbose(_X("Directory [%s] changed since the startup cache was written"), dir.c_str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+bool startup_cache_t::is_enabled()
+{
+    return env_snapshot::is_enabled(env_key_t::DOTNET_STARTUP_CACHE);
+}
+
+bool startup_cache_t::is_app_dir(const pal::string_t& dir) const
+{
+    return trim_trailing_separators(dir) == m_app_dir;
+}
+
+bool startup_cache_t::initialize(const arguments_t& args, const hostpolicy_init_t& init, bool breadcrumbs_enabled)
+{
+    if (!args.additional_deps_serialized.empty())
+    {
+        // Additional deps are looked up in directories which are not tracked here
+        trace::verbose(_X("The startup cache is not used together with additional deps"));
+        return false;
+    }
+
+    if (args.managed_application.empty() || args.app_root.empty())
+    {
+        return false;
+    }
+
+    m_app_dir = trim_trailing_separators(args.app_root);
+    pal::string_t cache_name = get_filename_without_ext(args.managed_application) + _X(".startup.bin");
+    m_cache_path = args.app_root;
+    append_path(&m_cache_path, cache_name.c_str());
+
+    m_key.clear();
+    m_key_stamps.clear();
+    cache_writer_t writer(&m_key);
+    writer.write_value(static_cast<uint32_t>(sizeof(pal::char_t)));
+    writer.write_string(_STRINGIFY(HOST_POLICY_PKG_VER) _X("+") _STRINGIFY(REPO_COMMIT_HASH));
+    writer.write_string(get_current_runtime_id(false /*use_fallback*/));
+
+    writer.write_value(static_cast<int32_t>(args.host_mode));
+    writer.write_string(args.app_root);
+    writer.write_string(args.deps_path);
+    writer.write_string(args.managed_application);
+    writer.write_string(args.core_servicing);
+    writer.write_string(args.dotnet_shared_store);
+    write_strings(writer, args.probe_paths);
+    write_strings(writer, args.global_shared_stores);
+    write_strings(writer, args.env_shared_store);
+    writer.write_value(static_cast<uint8_t>(init.is_framework_dependent));
+    writer.write_value(static_cast<uint8_t>(breadcrumbs_enabled));
+
+    writer.write_value(static_cast<uint32_t>(init.fx_definitions.size()));
+    for (size_t i = 0; i < init.fx_definitions.size(); ++i)
+    {
+        const auto& fx = init.fx_definitions[i];
+        writer.write_string(fx->get_name());
+        writer.write_string(fx->get_found_version());
+        writer.write_string(fx->get_dir());
+        write_stamp(writer, i == 0 ? args.deps_path : deps_resolver_t::get_fx_deps(fx->get_dir(), fx->get_name()), &m_key_stamps);
+        if (i != 0)
+        {
+            write_stamp(writer, fx->get_dir(), &m_key_stamps);
+        }
+    }
+
+    // Directories whose existence decides which probe configurations are used
+    if (!args.core_servicing.empty())
+    {
+        pal::string_t ext_ni = args.core_servicing;
+        append_path(&ext_ni, get_arch());
+        write_stamp(writer, args.core_servicing, &m_key_stamps);
+        write_stamp(writer, ext_ni, &m_key_stamps);
+    }
+
+    for (const auto& dirs : { args.probe_paths, args.global_shared_stores, args.env_shared_store, std::vector<pal::string_t>{ args.dotnet_shared_store } })
+    {
+        for (const auto& dir : dirs)
+        {
+            if (!dir.empty() && !is_app_dir(dir))
+            {
+                write_stamp(writer, dir, &m_key_stamps);
+            }
+        }
+    }
+
+    // Names of the files in the app directory, except for the cache itself and its temporary files
+    std::vector<pal::string_t> names;
+    pal::readdir(args.app_root, &names);
+    names.erase(std::remove_if(names.begin(), names.end(), [&cache_name](const pal::string_t& name) { return starts_with(name, cache_name, true); }), names.end());
+    std::sort(names.begin(), names.end());
+
+    std::vector<char> names_buffer;
+    cache_writer_t names_writer(&names_buffer);
+    write_strings(names_writer, names);
+    writer.write_value(get_content_hash(names_buffer.data(), names_buffer.size()));
+
+    return true;
+}
+
+bool startup_cache_t::load(startup_resolution_t* resolution, std::unordered_set<pal::string_t>* breadcrumbs) const
+{
+    if (!pal::file_exists(m_cache_path))
+    {
+        trace::verbose(_X("Startup cache [%s] does not exist"), m_cache_path.c_str());
+        return false;
+    }
+
+    size_t length = 0;
+    void* data = pal::map_file_readonly(m_cache_path, length);
+    if (data == nullptr)
+    {
+        return false;
+    }
+
+    // Read into locals, so that a stale cache doesn't leave anything behind.
+    startup_resolution_t cached;
+    std::unordered_set<pal::string_t> cached_breadcrumbs;
+    cache_reader_t reader(static_cast<const char*>(data), length);
+    uint32_t magic, version, key_size, breadcrumb_count;
+    bool loaded = reader.read_value(&magic) && magic == cache_magic
+        && reader.read_value(&version) && version == cache_format_version
+        && reader.read_value(&key_size) && key_size == m_key.size() && reader.match_bytes(m_key)
+        && read_dir_stamps_match(reader)
+        && reader.read_string(&cached.probe_paths.tpa)
+        && reader.read_string(&cached.probe_paths.native)
+        && reader.read_string(&cached.probe_paths.resources)
+        && reader.read_string(&cached.probe_paths.coreclr)
+        && reader.read_string(&cached.probe_paths.clrjit)
+        && reader.read_string(&cached.app_base)
+        && reader.read_string(&cached.app_context_deps)
+        && reader.read_string(&cached.fx_deps)
+        && reader.read_string(&cached.probing_directories)
+        && reader.read_string(&cached.clr_library_version)
+        && reader.read_value(&breadcrumb_count);
+
+    for (uint32_t i = 0; loaded && i < breadcrumb_count; ++i)
+    {
+        pal::string_t breadcrumb;
+        loaded = reader.read_string(&breadcrumb);
+        cached_breadcrumbs.insert(std::move(breadcrumb));
+    }
+
+    loaded = loaded && reader.at_end();
+    pal::unmap_file(data, length);
+
+    if (!loaded)
+    {
+        trace::verbose(_X("Startup cache [%s] is stale or invalid"), m_cache_path.c_str());
+        return false;
+    }
+
+    *resolution = std::move(cached);
+    breadcrumbs->insert(cached_breadcrumbs.begin(), cached_breadcrumbs.end());
+    trace::verbose(_X("Using startup cache [%s]"), m_cache_path.c_str());
+    return true;
+}
+
+void startup_cache_t::save(const startup_resolution_t& resolution, const std::unordered_set<pal::string_t>& breadcrumbs, const dir_listing_cache_t& dir_cache) const
+{
+    std::vector<dir_listing_cache_t::dir_stamp_t> dir_stamps;
+    dir_cache.get_dir_stamps(&dir_stamps);
+
+    std::vector<char> buffer;
+    cache_writer_t writer(&buffer);
+    writer.write_value(cache_magic);
+    writer.write_value(cache_format_version);
+    writer.write_value(static_cast<uint32_t>(m_key.size()));
+    buffer.insert(buffer.end(), m_key.begin(), m_key.end());
+
+    std::vector<pal::file_stamp_t> stamps = m_key_stamps;
+    uint32_t dir_count = 0;
+    for (const auto& dir_stamp : dir_stamps)
+    {
+        dir_count += is_app_dir(dir_stamp.dir) ? 0 : 1;
+    }
+
+    writer.write_value(dir_count);
+    for (const auto& dir_stamp : dir_stamps)
+    {
+        if (is_app_dir(dir_stamp.dir))
+        {
+            continue;
+        }
+
+        writer.write_string(dir_stamp.dir);
+        writer.write_value(static_cast<uint8_t>(dir_stamp.exists));
+        if (dir_stamp.exists)
+        {
+            writer.write_value(dir_stamp.stamp.size);
+            writer.write_value(dir_stamp.stamp.last_write_time);
+            stamps.push_back(dir_stamp.stamp);
+        }
+    }
+
+    writer.write_string(resolution.probe_paths.tpa);
+    writer.write_string(resolution.probe_paths.native);
+    writer.write_string(resolution.probe_paths.resources);
+    writer.write_string(resolution.probe_paths.coreclr);
+    writer.write_string(resolution.probe_paths.clrjit);
+    writer.write_string(resolution.app_base);
+    writer.write_string(resolution.app_context_deps);
+    writer.write_string(resolution.fx_deps);
+    writer.write_string(resolution.probing_directories);
+    writer.write_string(resolution.clr_library_version);
+    writer.write_value(static_cast<uint32_t>(breadcrumbs.size()));
+    for (const auto& breadcrumb : breadcrumbs)
+    {
+        writer.write_string(breadcrumb);
+    }
+
+    switch (write_cache_file(m_cache_path, buffer, stamps))
+    {
+    case cache_write_status::create_failed:
+        trace::verbose(_X("Could not create startup cache [%s]"), m_cache_path.c_str());
+        return;
+    case cache_write_status::write_failed:
+        trace::verbose(_X("Could not write startup cache [%s]"), m_cache_path.c_str());
+        return;
+    case cache_write_status::inputs_too_recent:
+        trace::verbose(_X("Not writing startup cache [%s], its inputs changed too recently"), m_cache_path.c_str());
+        return;
+    case cache_write_status::written:
+        break;
+    }
+
+    trace::verbose(_X("Wrote startup cache [%s]"), m_cache_path.c_str());
+}
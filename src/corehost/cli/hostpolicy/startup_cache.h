@@ -0,0 +1,61 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __STARTUP_CACHE_H__
+#define __STARTUP_CACHE_H__
+
+#include <pal.h>
+
+#include "args.h"
+#include "deps_resolver.h"
+#include "dir_listing_cache.h"
+#include "hostpolicy_init.h"
+
+// Everything hostpolicy_context_t uses from the dependency resolution.
+struct startup_resolution_t
+{
+    probe_paths_t probe_paths;
+    pal::string_t app_base;
+    pal::string_t app_context_deps;
+    pal::string_t fx_deps;
+    pal::string_t probing_directories;
+    pal::string_t clr_library_version;
+};
+
+// Persists the result of the dependency resolution for an app, so that subsequent starts of the
+// app can skip constructing the deps_resolver_t and probing for all of its assets.
+//
+// The resolution only depends on the host arguments, the resolved frameworks, the deps files and
+// which files exist in the probed directories. The cache key is made of all of those, using the
+// size and last write time of the deps files and the directories rather than their content, so
+// that checking the key is cheap. Adding, removing or renaming a file changes the last write time
+// of its directory. The exception is the app directory, which also contains the cache file, so
+// the key covers the names of the files in it instead.
+class startup_cache_t
+{
+public:
+    // Enabled via DOTNET_STARTUP_CACHE=1
+    static bool is_enabled();
+
+    // Computes the key of the cache from the inputs of the resolution.
+    // Returns false if the resolution can't be cached for these inputs.
+    bool initialize(const arguments_t& args, const hostpolicy_init_t& init, bool breadcrumbs_enabled);
+
+    bool load(startup_resolution_t* resolution, std::unordered_set<pal::string_t>* breadcrumbs) const;
+
+    // The directories listed during the resolution are validated by their stamps on load.
+    void save(const startup_resolution_t& resolution, const std::unordered_set<pal::string_t>& breadcrumbs, const dir_listing_cache_t& dir_cache) const;
+
+private:
+    bool is_app_dir(const pal::string_t& dir) const;
+
+    pal::string_t m_cache_path;
+    pal::string_t m_app_dir;
+    std::vector<char> m_key;
+
+    // Stamps in the key, to check that none of them changed too recently to be trusted when saving.
+    std::vector<pal::file_stamp_t> m_key_stamps;
+};
+
+#endif // __STARTUP_CACHE_H__
@@ -12,6 +12,9 @@
 
 #include "json_parser.h"
 #include "rapidjson/error/en.h"
+#include "rapidjson/encodedstream.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
 #include "utils.h"
 #include <cassert>
 #include <cstdint>
@@ -42,9 +45,9 @@ std::streampos get_utf8_bom_length(pal::istream_t& stream)
     return 3;
 }
 
-void get_line_column_from_offset(const std::vector<char>& json, size_t offset, int *line, int *column)
+void get_line_column_from_offset(const char* data, size_t size, size_t offset, int *line, int *column)
 {
-    assert(offset < json.size());
+    assert(offset <= size);
 
     *line = *column = 1;
 
@@ -52,12 +55,12 @@ void get_line_column_from_offset(const std::vector<char>& json, size_t offset, i
     {
         (*column)++;
 
-        if (json[i] == '\n')
+        if (data[i] == '\n')
         {
             (*line)++;
             *column = 1;
         }
-        else if (json[i] == '\r' && json[i + 1] == '\n')
+        else if (data[i] == '\r' && (i + 1) < size && data[i + 1] == '\n')
         {
             (*line)++;
             *column = 1;
@@ -67,38 +70,113 @@ void get_line_column_from_offset(const std::vector<char>& json, size_t offset, i
     }
 }
 
+void report_parse_error(const char* data, size_t size, size_t offset, rapidjson::ParseErrorCode code, const pal::string_t& context)
+{
+    int line, column;
+    get_line_column_from_offset(data, size, offset, &line, &column);
+
+    trace::error(_X("A JSON parsing exception occurred in [%s], offset %zu (line %d, column %d): %s"),
+                 context.c_str(), offset, line, column,
+                 rapidjson::GetParseError_En(code));
+}
+
+// Forwards reader events to a json_parser_t::handler_t. The typed number
+// callbacks are never called since numbers are parsed as strings.
+class handler_adapter_t
+{
+public:
+    typedef pal::char_t Ch;
+
+    handler_adapter_t(json_parser_t::handler_t& handler)
+        : m_handler(handler) { }
+
+    bool Null() { return m_handler.Null(); }
+    bool Bool(bool b) { return m_handler.Bool(b); }
+    bool Int(int) { assert(false); return false; }
+    bool Uint(unsigned) { assert(false); return false; }
+    bool Int64(int64_t) { assert(false); return false; }
+    bool Uint64(uint64_t) { assert(false); return false; }
+    bool Double(double) { assert(false); return false; }
+    bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return m_handler.RawNumber(str, length, copy); }
+    bool String(const Ch* str, rapidjson::SizeType length, bool copy) { return m_handler.String(str, length, copy); }
+    bool StartObject() { return m_handler.StartObject(); }
+    bool Key(const Ch* str, rapidjson::SizeType length, bool copy) { return m_handler.Key(str, length, copy); }
+    bool EndObject(rapidjson::SizeType member_count) { return m_handler.EndObject(member_count); }
+    bool StartArray() { return m_handler.StartArray(); }
+    bool EndArray(rapidjson::SizeType element_count) { return m_handler.EndArray(element_count); }
+
+private:
+    json_parser_t::handler_t& m_handler;
+};
+
+#ifndef _WIN32
+// In-situ stream over a buffer of known length. Unlike rapidjson's
+// InsituStringStream it does not require the data to be null terminated,
+// so it can be used directly over a mapped file: reading past the end
+// yields '\0', which rapidjson treats as the end of the input.
+class bounded_insitu_stream_t
+{
+public:
+    typedef char Ch;
+
+    bounded_insitu_stream_t(Ch* src, size_t size)
+        : src_(src), dst_(nullptr), head_(src), end_(src + size) { }
+
+    // Read
+    Ch Peek() const { return src_ < end_ ? *src_ : '\0'; }
+    Ch Take() { return src_ < end_ ? *src_++ : '\0'; }
+    size_t Tell() const { return static_cast<size_t>(src_ - head_); }
+
+    // Write
+    void Put(Ch c) { assert(dst_ != nullptr && dst_ < end_); *dst_++ = c; }
+
+    Ch* PutBegin() { return dst_ = src_; }
+    size_t PutEnd(Ch* begin) { return static_cast<size_t>(dst_ - begin); }
+    void Flush() { }
+
+    Ch* Push(size_t count) { Ch* begin = dst_; dst_ += count; return begin; }
+    void Pop(size_t count) { dst_ -= count; }
+
+private:
+    Ch* src_;
+    Ch* dst_;
+    Ch* head_;
+    Ch* end_;
+};
+#endif
+
 } // empty namespace
 
+json_parser_t::~json_parser_t()
+{
+    if (m_mapped_data != nullptr)
+    {
+        pal::unmap_file(m_mapped_data, m_mapped_size);
+    }
+}
+
 void json_parser_t::realloc_buffer(size_t size)
 {
     m_json.resize(size + 1);
     m_json[size] = '\0';
 }
 
-bool json_parser_t::parse_json(const pal::string_t& context)
+bool json_parser_t::parse_json(char* data, size_t size, const pal::string_t& context)
 {
-    assert(!m_json.empty());
-
 #ifdef _WIN32
     // Can't use in-situ parsing on Windows, as JSON data is encoded in
     // UTF-8 and the host expects wide strings.  m_document will store
     // data in UTF-16 (with pal::char_t as the character type), but it
     // has to know that data is encoded in UTF-8 to convert during parsing.
-    m_document.Parse<rapidjson::ParseFlag::kParseStopWhenDoneFlag, rapidjson::UTF8<>>(m_json.data());
+    m_document.Parse<rapidjson::ParseFlag::kParseStopWhenDoneFlag, rapidjson::UTF8<>>(data, size);
 #else
-    m_document.ParseInsitu(m_json.data());
+    bounded_insitu_stream_t stream(data, size);
+    m_document.ParseStream<rapidjson::ParseFlag::kParseInsituFlag>(stream);
 #endif
 
     if (m_document.HasParseError())
     {
-        int line, column;
-        size_t offset = m_document.GetErrorOffset();
-
-        get_line_column_from_offset(m_json, offset, &line, &column);
-
-        trace::error(_X("A JSON parsing exception occurred in [%s], offset %zu (line %d, column %d): %s"),
-                     context.c_str(), offset, line, column,
-                     rapidjson::GetParseError_En(m_document.GetParseError()));
+        report_parse_error(data, size, m_document.GetErrorOffset(), m_document.GetParseError(), context);
         return false;
     }
 
@@ -113,6 +191,18 @@ bool json_parser_t::parse_json(const pal::string_t& context)
 
 bool json_parser_t::parse_stream(pal::istream_t& stream,
                                  const pal::string_t& context)
+{
+    char* data;
+    size_t size;
+    if (!read_stream(stream, context, &data, &size))
+    {
+        return false;
+    }
+
+    return parse_json(data, size, context);
+}
+
+bool json_parser_t::read_stream(pal::istream_t& stream, const pal::string_t& context, char** data, size_t* size)
 {
     if (!stream.good())
     {
@@ -125,8 +215,97 @@ bool json_parser_t::parse_stream(pal::istream_t& stream,
     auto stream_size = stream.tellg();
     stream.seekg(current_pos, stream.beg);
 
-    realloc_buffer(stream_size - current_pos);
-    stream.read(m_json.data(), stream_size - current_pos);
+    *size = static_cast<size_t>(stream_size - current_pos);
+    realloc_buffer(*size);
+    stream.read(m_json.data(), *size);
+
+    *data = m_json.data();
+    return true;
+}
+
+bool json_parser_t::read_file(const pal::string_t& path, char** data, size_t* size)
+{
+    assert(m_mapped_data == nullptr);
 
-    return parse_json(context);
+    // Parse straight out of a private copy-on-write view of the file. This avoids
+    // reading the file through a stream and copying it into a heap buffer.
+    // Missing and empty files can't be mapped; they (and any other mapping failure)
+    // go through the stream based path which reports the appropriate errors. They are
+    // checked for up front so that mapping them doesn't trace spurious warnings.
+    pal::file_stamp_t stamp;
+    char* mapped = nullptr;
+    if (pal::get_file_stamp(path, &stamp) && stamp.size > 0)
+    {
+        mapped = static_cast<char*>(pal::mmap_copy_on_write(path, size));
+    }
+
+    if (mapped == nullptr)
+    {
+        pal::ifstream_t file{path};
+        return read_stream(file, path, data, size);
+    }
+
+    m_mapped_data = mapped;
+    m_mapped_size = *size;
+
+    // Skip over UTF-8 BOM, if present
+    if (*size >= 3
+        && static_cast<unsigned char>(mapped[0]) == 0xEF
+        && static_cast<unsigned char>(mapped[1]) == 0xBB
+        && static_cast<unsigned char>(mapped[2]) == 0xBF)
+    {
+        mapped += 3;
+        *size -= 3;
+    }
+
+    *data = mapped;
+    return true;
+}
+
+bool json_parser_t::parse_file(const pal::string_t& path)
+{
+    char* data;
+    size_t size;
+    if (!read_file(path, &data, &size))
+    {
+        return false;
+    }
+
+    return parse_json(data, size, path);
+}
+
+bool json_parser_t::parse_file(const pal::string_t& path, handler_t& handler)
+{
+    char* data;
+    size_t size;
+    if (!read_file(path, &data, &size))
+    {
+        return false;
+    }
+
+    // Numbers are reported as strings, so the handler doesn't need the typed callbacks.
+    handler_adapter_t adapter(handler);
+    rapidjson::GenericReader<rapidjson::UTF8<>, internal_encoding_type_t> reader;
+#ifdef _WIN32
+    rapidjson::MemoryStream memory_stream(data, size);
+    rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> stream(memory_stream);
+    rapidjson::ParseResult result = reader.Parse<
+        rapidjson::ParseFlag::kParseStopWhenDoneFlag | rapidjson::ParseFlag::kParseNumbersAsStringsFlag>(stream, adapter);
+#else
+    bounded_insitu_stream_t stream(data, size);
+    rapidjson::ParseResult result = reader.Parse<
+        rapidjson::ParseFlag::kParseInsituFlag | rapidjson::ParseFlag::kParseNumbersAsStringsFlag>(stream, adapter);
+#endif
+
+    if (result.IsError())
+    {
+        if (result.Code() != rapidjson::kParseErrorTermination)
+        {
+            report_parse_error(data, size, result.Offset(), result.Code(), path);
+        }
+
+        return false;
+    }
+
+    return true;
 }
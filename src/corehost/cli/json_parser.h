@@ -20,13 +20,45 @@ class json_parser_t {
         using value_t = rapidjson::GenericValue<internal_encoding_type_t>;
         using document_t = rapidjson::GenericDocument<internal_encoding_type_t>;
 
+        // Receives the events of a streaming parse, see parse_file(path, handler).
+        // Strings are null terminated and only valid for the duration of the call.
+        // Returning false from any of the callbacks stops the parse.
+        class handler_t
+        {
+        public:
+            typedef pal::char_t Ch;
+
+            virtual ~handler_t() { }
+
+            virtual bool Null() = 0;
+            virtual bool Bool(bool b) = 0;
+            virtual bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) = 0;
+            virtual bool String(const Ch* str, rapidjson::SizeType length, bool copy) = 0;
+            virtual bool StartObject() = 0;
+            virtual bool Key(const Ch* str, rapidjson::SizeType length, bool copy) = 0;
+            virtual bool EndObject(rapidjson::SizeType member_count) = 0;
+            virtual bool StartArray() = 0;
+            virtual bool EndArray(rapidjson::SizeType element_count) = 0;
+        };
+
+        json_parser_t()
+            : m_mapped_data(nullptr)
+            , m_mapped_size(0)
+        { }
+
+        // The parser owns the mapping of the file it parsed, so it can't be copied.
+        json_parser_t(const json_parser_t&) = delete;
+        json_parser_t& operator=(const json_parser_t&) = delete;
+
+        ~json_parser_t();
+
         const document_t& document() const { return m_document; }
         bool parse_stream(pal::istream_t& stream, const pal::string_t& context);
-        bool parse_file(const pal::string_t& path)
-        {
-            pal::ifstream_t file{path};
-            return parse_stream(file, path);
-        }
+        bool parse_file(const pal::string_t& path);
+
+        // Parses the file without building a document, reporting its contents to the handler.
+        // If the handler stops the parse, false is returned without reporting an error.
+        bool parse_file(const pal::string_t& path, handler_t& handler);
 
     private:
         // This is a vector of char and not pal::char_t because JSON data
@@ -36,8 +68,16 @@ class json_parser_t {
         std::vector<char> m_json;
         document_t m_document;
 
+        // Private copy-on-write view of the file used by parse_file. On non-Windows
+        // platforms the document is parsed in-situ, so its strings point into this
+        // view and it has to stay mapped for the lifetime of the parser.
+        char* m_mapped_data;
+        size_t m_mapped_size;
+
         void realloc_buffer(size_t size);
-        bool parse_json(const pal::string_t& context);
+        bool read_stream(pal::istream_t& stream, const pal::string_t& context, char** data, size_t* size);
+        bool read_file(const pal::string_t& path, char** data, size_t* size);
+        bool parse_json(char* data, size_t size, const pal::string_t& context);
 };
 
 #endif // __JSON_PARSER_H__
@@ -2,6 +2,7 @@
 // The .NET Foundation licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 
+#include "env_snapshot.h"
 #include "json_parser.h"
 #include "pal.h"
 #include "rapidjson/writer.h"
@@ -29,7 +30,7 @@ runtime_config_t::runtime_config_t()
     , m_roll_forward_to_prerelease(false)
 {
     pal::string_t roll_forward_to_prerelease_env;
-    if (pal::getenv(_X("DOTNET_ROLL_FORWARD_TO_PRERELEASE"), &roll_forward_to_prerelease_env))
+    if (env_snapshot::get(env_key_t::DOTNET_ROLL_FORWARD_TO_PRERELEASE, &roll_forward_to_prerelease_env))
     {
         auto roll_forward_to_prerelease_val = pal::xtoi(roll_forward_to_prerelease_env.c_str());
         m_roll_forward_to_prerelease = (roll_forward_to_prerelease_val == 1);
@@ -56,7 +57,7 @@ void runtime_config_t::parse(const pal::string_t& path, const pal::string_t& dev
 
     // Step #1: set the defaults from the environment DOTNET_ROLL_FORWARD_ON_NO_CANDIDATE_FX (apply patches has no env. variable)
     pal::string_t env_roll_forward_on_no_candidate_fx;
-    if (pal::getenv(_X("DOTNET_ROLL_FORWARD_ON_NO_CANDIDATE_FX"), &env_roll_forward_on_no_candidate_fx))
+    if (env_snapshot::get(env_key_t::DOTNET_ROLL_FORWARD_ON_NO_CANDIDATE_FX, &env_roll_forward_on_no_candidate_fx))
     {
         auto val = static_cast<roll_fwd_on_no_candidate_fx_option>(pal::xtoi(env_roll_forward_on_no_candidate_fx.c_str()));
         roll_forward = roll_fwd_on_no_candidate_fx_to_roll_forward(val);
@@ -309,7 +310,7 @@ bool runtime_config_t::parse_framework(const json_parser_t::value_t& fx_obj, fx_
 
     // Step #4: apply environment for DOTNET_ROLL_FORWARD
     pal::string_t env_roll_forward;
-    if (pal::getenv(_X("DOTNET_ROLL_FORWARD"), &env_roll_forward))
+    if (env_snapshot::get(env_key_t::DOTNET_ROLL_FORWARD, &env_roll_forward))
     {
         auto val = roll_forward_option_from_string(env_roll_forward);
         if (val == roll_forward_option::__Last)
@@ -0,0 +1,193 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "deps_library_scanner.h"
+#include "json_parser.h"
+#include "pal.h"
+#include "trace.h"
+#include "utils.h"
+#include <chrono>
+
+#define TEST_ASSERT(a) \
+  if (!(a)) \
+  { \
+    fprintf(stderr, "TEST_ASSERT failed '%s' at %d\n", #a, __LINE__); \
+    exit(1); \
+  }
+
+namespace
+{
+    const pal::char_t* prefix = _X("Microsoft.NETCore.DotNetHostPolicy/");
+
+    struct TestCase
+    {
+        const char* json;
+        const pal::char_t* expected;
+    };
+
+    const TestCase cases[] =
+    {
+        // Typical layout, the keys under "targets" must not match
+        {
+            "{ \"runtimeTarget\": { \"name\": \".NETCoreApp,Version=v3.0\" },"
+            "  \"targets\": { \".NETCoreApp,Version=v3.0\": { \"Microsoft.NETCore.DotNetHostPolicy/9.9.9\": { \"native\": { \"libhostpolicy.so\": {} } } } },"
+            "  \"libraries\": { \"App/1.0.0\": { \"type\": \"project\", \"serviceable\": false, \"sha512\": \"\" },"
+            "                   \"Microsoft.NETCore.DotNetHostPolicy/3.0.0\": { \"type\": \"package\", \"serviceable\": true } } }",
+            _X("Microsoft.NETCore.DotNetHostPolicy/3.0.0")
+        },
+        // Libraries before targets
+        {
+            "{ \"libraries\": { \"Microsoft.NETCore.DotNetHostPolicy/2.1.0\": { \"type\": \"package\" } },"
+            "  \"targets\": { \"t\": { \"A/1.0.0\": {} } } }",
+            _X("Microsoft.NETCore.DotNetHostPolicy/2.1.0")
+        },
+        // The prefix is compared case-insensitively and the first match wins
+        {
+            "{ \"libraries\": { \"microsoft.netcore.dotnethostpolicy/1.0.0\": {}, \"Microsoft.NETCore.DotNetHostPolicy/2.0.0\": {} } }",
+            _X("microsoft.netcore.dotnethostpolicy/1.0.0")
+        },
+        // Values of every type are skipped
+        {
+            "{ \"a\": [ 1, -2.5e3, true, false, null, \"s\", [ [] ], { \"libraries\": { \"Microsoft.NETCore.DotNetHostPolicy/0.0.1\": {} } } ],"
+            "  \"libraries\": { \"X/1.0.0\": { \"n\": [ 1, { \"Microsoft.NETCore.DotNetHostPolicy/0.0.2\": null } ] },"
+            "                   \"Microsoft.NETCore.DotNetHostPolicy/4.0.0\": {} } }",
+            _X("Microsoft.NETCore.DotNetHostPolicy/4.0.0")
+        },
+        // Only the first "libraries" section is looked at
+        {
+            "{ \"libraries\": { \"A/1.0.0\": {} }, \"libraries\": { \"Microsoft.NETCore.DotNetHostPolicy/1.0.0\": {} } }",
+            nullptr
+        },
+        // No match
+        { "{ \"libraries\": { \"Microsoft.NETCore.DotNetHostPolicyX\": {}, \"A/1.0.0\": {} } }", nullptr },
+        { "{ \"libraries\": {} }", nullptr },
+        { "{ \"libraries\": [] }", nullptr },
+        { "{ \"libraries\": null }", nullptr },
+        { "{ \"nested\": { \"libraries\": { \"Microsoft.NETCore.DotNetHostPolicy/1.0.0\": {} } } }", nullptr },
+        { "{}", nullptr },
+        { "{ \"libraries\": { \"A/1.0.0\": { ", nullptr },
+    };
+
+    // The implementation the scanner replaced: load the whole document and look through the libraries.
+    bool find_library_dom(const pal::string_t& deps_path, pal::string_t* library_name)
+    {
+        json_parser_t json;
+        if (!json.parse_file(deps_path))
+        {
+            return false;
+        }
+
+        const auto& root = json.document();
+        if (!root.IsObject())
+        {
+            return false;
+        }
+
+        const auto libraries = root.FindMember(_X("libraries"));
+        if (libraries == root.MemberEnd() || !libraries->value.IsObject())
+        {
+            return false;
+        }
+
+        for (const auto& library : libraries->value.GetObject())
+        {
+            pal::string_t name{ library.name.GetString() };
+            if (starts_with(name, prefix, false))
+            {
+                library_name->assign(name);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    pal::string_t write_temp_file(const char* contents)
+    {
+        pal::string_t path;
+        TEST_ASSERT(pal::get_temp_directory(path));
+        append_path(&path, _X("test_deps_library_scanner.deps.json"));
+
+        FILE* file = pal::file_open(path, _X("wb"));
+        TEST_ASSERT(file != nullptr);
+        fputs(contents, file);
+        fclose(file);
+
+        return path;
+    }
+
+    void checkCases()
+    {
+        for (const TestCase& test_case : cases)
+        {
+            pal::string_t path = write_temp_file(test_case.json);
+
+            pal::string_t name;
+            bool found = deps_library_scanner::find_library(path, prefix, &name);
+            TEST_ASSERT(found == (test_case.expected != nullptr));
+            TEST_ASSERT(!found || name == test_case.expected);
+
+            // The DOM based lookup agrees on everything that is valid JSON
+            pal::string_t dom_name;
+            if (find_library_dom(path, &dom_name))
+            {
+                TEST_ASSERT(found && name == dom_name);
+            }
+
+            pal::remove(path.c_str());
+        }
+
+        pal::string_t name;
+        TEST_ASSERT(!deps_library_scanner::find_library(_X("does-not-exist.deps.json"), prefix, &name));
+    }
+
+    // Compares the scanner with the DOM based lookup on a real deps file, e.g. Microsoft.NETCore.App.deps.json.
+    int benchmark(const pal::string_t& deps_path, int iterations)
+    {
+        pal::string_t dom_name;
+        pal::string_t scan_name;
+        bool dom_found = find_library_dom(deps_path, &dom_name);
+        bool scan_found = deps_library_scanner::find_library(deps_path, prefix, &scan_name);
+        TEST_ASSERT(dom_found == scan_found && dom_name == scan_name);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            find_library_dom(deps_path, &dom_name);
+        }
+
+        auto dom_time = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            deps_library_scanner::find_library(deps_path, prefix, &scan_name);
+        }
+
+        auto scan_time = std::chrono::steady_clock::now() - start;
+
+        long long dom_us = std::chrono::duration_cast<std::chrono::microseconds>(dom_time).count() / iterations;
+        long long scan_us = std::chrono::duration_cast<std::chrono::microseconds>(scan_time).count() / iterations;
+        trace::println(_X("Found: %s"), scan_found ? scan_name.c_str() : _X("<none>"));
+        trace::println(_X("DOM lookup: %lld us per iteration"), dom_us);
+        trace::println(_X("Scanner:    %lld us per iteration"), scan_us);
+
+        return 0;
+    }
+}
+
+#if defined(_WIN32)
+int __cdecl wmain(const int argc, const pal::char_t* argv[])
+#else
+int main(const int argc, const pal::char_t* argv[])
+#endif
+{
+    if (argc > 1)
+    {
+        int iterations = argc > 2 ? pal::xtoi(argv[2]) : 1000;
+        return benchmark(argv[1], iterations > 0 ? iterations : 1);
+    }
+
+    checkCases();
+}
@@ -0,0 +1,695 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "pal.h"
+#include "coreclr.h"
+#include "deps_resolver.h"
+#include "test_utils.h"
+#include "trace.h"
+#include "utils.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace test_utils;
+
+namespace
+{
+    // Counters of the allocations made while counting is on, see allocation_counter_t
+    std::atomic<bool> g_counting_allocations(false);
+    std::atomic<size_t> g_allocations(0);
+    std::atomic<size_t> g_allocated_bytes(0);
+    std::atomic<size_t> g_large_allocations(0);
+    size_t g_large_allocation_size = 0;
+}
+
+// The allocation functions are replaced for the whole test, so that the allocations of the code under test are counted
+void* operator new(size_t size)
+{
+    if (g_counting_allocations)
+    {
+        g_allocations++;
+        g_allocated_bytes += size;
+        if (size >= g_large_allocation_size)
+        {
+            g_large_allocations++;
+        }
+    }
+
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+namespace
+{
+    // Counts the allocations made from its creation until stop() is called, and separately the ones of
+    // at least large_size bytes, which are the ones of buffers as big as the search paths.
+    struct allocation_counter_t
+    {
+        size_t allocations;
+        size_t bytes;
+        size_t large_allocations;
+
+        allocation_counter_t(size_t large_size)
+            : allocations(0)
+            , bytes(0)
+            , large_allocations(0)
+        {
+            g_large_allocation_size = large_size;
+            g_allocations = 0;
+            g_allocated_bytes = 0;
+            g_large_allocations = 0;
+            g_counting_allocations = true;
+        }
+
+        void stop()
+        {
+            g_counting_allocations = false;
+            allocations = g_allocations;
+            bytes = g_allocated_bytes;
+            large_allocations = g_large_allocations;
+        }
+    };
+
+    const pal::char_t* tfm = _X(".NETCoreApp,Version=v3.0");
+    const pal::char_t* fx_version = _X("9.9.9");
+
+    // From the root framework to the highest level one, the app references the last one
+    const pal::char_t* fx_names[] = { _X("Microsoft.NETCore.App"), _X("Microsoft.AspNetCore.App"), _X("Microsoft.WindowsDesktop.App") };
+    const int fx_count = sizeof(fx_names) / sizeof(fx_names[0]);
+
+    struct package_t
+    {
+        pal::string_t name;
+        pal::string_t version;
+        pal::string_t assembly;
+        pal::string_t assembly_version;
+        bool is_local; // Whether the assembly is next to the deps file
+    };
+
+    void write_deps(const pal::string_t& dir, const pal::string_t& deps_name, const std::vector<package_t>& packages, bool with_rid_fallback_graph)
+    {
+        pal::string_t targets;
+        pal::string_t libraries;
+        for (const auto& package : packages)
+        {
+            if (package.is_local)
+            {
+                write_file(combine(dir, package.assembly.c_str()), pal::string_t());
+            }
+
+            const pal::string_t library = _X("\"") + package.name + _X("/") + package.version + _X("\"");
+            targets.append(targets.empty() ? _X("") : _X(",\n"));
+            targets.append(library + _X(": { \"runtime\": { \"lib/netcoreapp3.0/") + package.assembly
+                + _X("\": { \"assemblyVersion\": \"") + package.assembly_version + _X("\", \"fileVersion\": \"1.0.0.0\" } } }"));
+            libraries.append(libraries.empty() ? _X("") : _X(",\n"));
+            libraries.append(library + _X(": { \"type\": \"package\", \"serviceable\": false, \"sha512\": \"\" }"));
+        }
+
+        pal::string_t content = _X("{ \"runtimeTarget\": { \"name\": \"");
+        content.append(tfm);
+        content.append(_X("\" },\n\"targets\": { \""));
+        content.append(tfm);
+        content.append(_X("\": {\n") + targets + _X("\n} },\n\"libraries\": {\n") + libraries + _X("\n}"));
+        if (with_rid_fallback_graph)
+        {
+            content.append(_X(",\n\"runtimes\": { \"linux-x64\": [ \"linux\", \"unix-x64\", \"unix\", \"any\", \"base\" ], \"osx-x64\": [ \"osx\", \"unix-x64\", \"unix\", \"any\", \"base\" ], \"win-x64\": [ \"win\", \"any\", \"base\" ] }"));
+        }
+
+        content.append(_X("\n}"));
+        write_file(combine(dir, deps_name.c_str()), content);
+    }
+
+    // An app on three frameworks, each of which has many packages. The app references some of the packages
+    // of the frameworks with the same version, which resolve to the frameworks, and has a newer version of
+    // one package of each framework as well as packages of its own, which resolve to the app.
+    struct test_layout_t
+    {
+        test_dir_t root_dir;
+        const pal::string_t& root;
+        pal::string_t app_dir;
+        pal::string_t fx_dirs[fx_count];
+        int packages_per_fx;
+
+        test_layout_t(int packages_per_fx)
+            : root_dir(_X("test_deps_resolution"))
+            , root(root_dir.dir)
+            , packages_per_fx(packages_per_fx)
+        {
+            pal::string_t shared_dir = combine(root, _X("shared"));
+            create_dir(shared_dir);
+            for (int fx = 0; fx < fx_count; ++fx)
+            {
+                fx_dirs[fx] = combine(shared_dir, fx_names[fx]);
+                create_dir(fx_dirs[fx]);
+                fx_dirs[fx] = combine(fx_dirs[fx], fx_version);
+                create_dir(fx_dirs[fx]);
+
+                std::vector<package_t> packages;
+                for (int i = 0; i < packages_per_fx; ++i)
+                {
+                    packages.push_back(package_t{ get_fx_package_name(fx, i), fx_version, get_fx_assembly(fx, i), _X("1.0.0.0"), true });
+                }
+
+                write_deps(fx_dirs[fx], pal::string_t(fx_names[fx]) + _X(".deps.json"), packages, fx == 0);
+            }
+
+            app_dir = combine(root, _X("app"));
+            create_dir(app_dir);
+
+            std::vector<package_t> packages;
+            packages.push_back(package_t{ _X("app"), _X("1.0.0"), _X("app.dll"), _X("1.0.0.0"), true });
+            for (int fx = 0; fx < fx_count; ++fx)
+            {
+                for (int i = 0; i < packages_per_fx; i += 4)
+                {
+                    packages.push_back(package_t{ get_fx_package_name(fx, i), fx_version, get_fx_assembly(fx, i), _X("1.0.0.0"), false });
+                }
+
+                packages.push_back(package_t{ get_fx_package_name(fx, 1), _X("10.0.0"), get_fx_assembly(fx, 1), _X("10.0.0.0"), true });
+            }
+
+            for (int i = 0; i < packages_per_fx; ++i)
+            {
+                packages.push_back(package_t{ _X("App.Lib") + pal::to_string(i), _X("1.0.0"), get_app_assembly(i), _X("1.0.0.0"), true });
+            }
+
+            write_deps(app_dir, _X("app.deps.json"), packages, false);
+        }
+
+        static pal::string_t get_fx_package_name(int fx, int i)
+        {
+            return pal::string_t(fx_names[fx]) + _X(".Package") + pal::to_string(i);
+        }
+
+        static pal::string_t get_fx_assembly(int fx, int i)
+        {
+            return get_fx_package_name(fx, i) + _X(".dll");
+        }
+
+        static pal::string_t get_app_assembly(int i)
+        {
+            return _X("App.Lib") + pal::to_string(i) + _X(".dll");
+        }
+
+        pal::string_t get_fx_deps_path(int fx) const
+        {
+            return combine(fx_dirs[fx], (pal::string_t(fx_names[fx]) + _X(".deps.json")).c_str());
+        }
+
+        // The app followed by the frameworks from the highest level one to the root one
+        void get_fx_definitions(fx_definition_vector_t* fx_definitions) const
+        {
+            fx_definitions->push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t()));
+            for (int fx = fx_count - 1; fx >= 0; --fx)
+            {
+                fx_definitions->push_back(std::unique_ptr<fx_definition_t>(new fx_definition_t(fx_names[fx], fx_dirs[fx], fx_version, fx_version)));
+            }
+        }
+
+        void get_arguments(arguments_t* args) const
+        {
+            args->host_mode = host_mode_t::muxer;
+            args->app_root = app_dir;
+            args->deps_path = combine(app_dir, _X("app.deps.json"));
+            args->managed_application = combine(app_dir, _X("app.dll"));
+        }
+    };
+
+    std::vector<pal::string_t> split_paths(const pal::string_t& paths)
+    {
+        std::vector<pal::string_t> split;
+        size_t start = 0;
+        size_t end;
+        while ((end = paths.find(PATH_SEPARATOR, start)) != pal::string_t::npos)
+        {
+            split.push_back(paths.substr(start, end - start));
+            start = end + 1;
+        }
+
+        return split;
+    }
+
+    void checkPackageIndex()
+    {
+        const test_layout_t layout(8);
+
+        deps_json_t fx_deps(true, layout.get_fx_deps_path(1), deps_json_t::rid_fallback_graph_t());
+        TEST_ASSERT(fx_deps.is_valid());
+
+        // The keys which are looked up come from another deps file
+        string_pool_t strings;
+        pal::string_t name = test_layout_t::get_fx_package_name(1, 3);
+        TEST_ASSERT(fx_deps.has_package(package_key_t(strings.add(name), strings.add(fx_version))));
+        TEST_ASSERT(!fx_deps.has_package(package_key_t(strings.add(name), strings.add(_X("10.0.0")))));
+        TEST_ASSERT(!fx_deps.has_package(package_key_t(strings.add(test_layout_t::get_fx_package_name(0, 3)), strings.add(fx_version))));
+        TEST_ASSERT(!fx_deps.has_package(package_key_t()));
+
+        // A copy looks the packages up in its own copy of the strings
+        deps_json_t copy;
+        {
+            deps_json_t temp = fx_deps;
+            copy = temp;
+        }
+
+        TEST_ASSERT(copy.has_package(package_key_t(strings.add(name), strings.add(fx_version))));
+        TEST_ASSERT(!copy.has_package(package_key_t(strings.add(name), strings.add(_X("10.0.0")))));
+
+        // The keys of the entries are the same as the keys made from their library name and version
+        for (const auto& entry : fx_deps.get_entries(deps_entry_t::asset_types::runtime))
+        {
+            TEST_ASSERT(entry.get_package_key() == package_key_t(entry.library_name, entry.library_version));
+            TEST_ASSERT(fx_deps.has_package(entry.get_package_key()));
+        }
+    }
+
+    void checkResolution()
+    {
+        const int packages_per_fx = 40;
+        const test_layout_t layout(packages_per_fx);
+
+        fx_definition_vector_t fx_definitions;
+        layout.get_fx_definitions(&fx_definitions);
+        arguments_t args;
+        layout.get_arguments(&args);
+
+        deps_resolver_t resolver(args, fx_definitions, nullptr, true);
+        pal::string_t errors;
+        TEST_ASSERT(resolver.valid(&errors));
+
+        probe_paths_t probe_paths;
+        TEST_ASSERT(resolver.resolve_probe_paths(&probe_paths, nullptr));
+
+        std::vector<pal::string_t> tpa = split_paths(probe_paths.tpa);
+        std::unordered_set<pal::string_t> tpa_set(tpa.begin(), tpa.end());
+        TEST_ASSERT(tpa_set.size() == tpa.size());
+        TEST_ASSERT(tpa.size() == static_cast<size_t>(1 + fx_count * packages_per_fx + packages_per_fx));
+
+        TEST_ASSERT(tpa_set.count(combine(layout.app_dir, _X("app.dll"))));
+        for (int i = 0; i < packages_per_fx; ++i)
+        {
+            for (int fx = 0; fx < fx_count; ++fx)
+            {
+                // The app's newer version of the package wins
+                const pal::string_t& dir = i == 1 ? layout.app_dir : layout.fx_dirs[fx];
+                TEST_ASSERT(tpa_set.count(combine(dir, test_layout_t::get_fx_assembly(fx, i).c_str())));
+            }
+
+            TEST_ASSERT(tpa_set.count(combine(layout.app_dir, test_layout_t::get_app_assembly(i).c_str())));
+        }
+    }
+
+    // Hands the search paths over to coreclr the way hostpolicy_context_t and coreclr_t do: CoreLib is appended
+    // to the TPA, the search paths are moved into the properties, and the properties are passed to coreclr_initialize.
+    void hand_over_search_paths(
+        probe_paths_t* probe_paths,
+        const pal::string_t& corelib_path,
+        coreclr_property_bag_t* properties,
+        std::vector<const char*>* keys,
+        std::vector<const char*>* values,
+        std::vector<std::vector<char>>* clr_strings)
+    {
+        probe_paths->tpa.append(corelib_path);
+        properties->add(common_property::TrustedPlatformAssemblies, std::move(probe_paths->tpa));
+        properties->add(common_property::NativeDllSearchDirectories, std::move(probe_paths->native));
+        properties->add(common_property::PlatformResourceRoots, std::move(probe_paths->resources));
+        properties->get_clr_properties(keys, values, clr_strings);
+    }
+
+    void checkSearchPathAllocations()
+    {
+        const test_layout_t layout(200);
+
+        fx_definition_vector_t fx_definitions;
+        layout.get_fx_definitions(&fx_definitions);
+        arguments_t args;
+        layout.get_arguments(&args);
+
+        deps_resolver_t resolver(args, fx_definitions, nullptr, true);
+        pal::string_t errors;
+        TEST_ASSERT(resolver.valid(&errors));
+
+        // The first resolution fills the caches of the resolver and tells how long the TPA is
+        size_t tpa_length;
+        {
+            probe_paths_t first_probe_paths;
+            TEST_ASSERT(resolver.resolve_probe_paths(&first_probe_paths, nullptr));
+            tpa_length = first_probe_paths.tpa.length();
+            TEST_ASSERT(tpa_length > 0);
+        }
+
+        // The TPA is built in a single buffer
+        probe_paths_t probe_paths;
+        allocation_counter_t resolve_counter(tpa_length / 2);
+        TEST_ASSERT(resolver.resolve_probe_paths(&probe_paths, nullptr));
+        resolve_counter.stop();
+        TEST_ASSERT(probe_paths.tpa.length() == tpa_length);
+        TEST_ASSERT(resolve_counter.large_allocations == 1);
+
+        const pal::string_t corelib_path = combine(layout.fx_dirs[0], CORELIB_NAME);
+        coreclr_property_bag_t properties;
+        std::vector<const char*> keys;
+        std::vector<const char*> values;
+        std::vector<std::vector<char>> clr_strings;
+
+        allocation_counter_t hand_over_counter(tpa_length / 2);
+        hand_over_search_paths(&probe_paths, corelib_path, &properties, &keys, &values, &clr_strings);
+        hand_over_counter.stop();
+
+        const pal::char_t* tpa;
+        TEST_ASSERT(properties.try_get(common_property::TrustedPlatformAssemblies, &tpa));
+        TEST_ASSERT(pal::strlen(tpa) == tpa_length + corelib_path.length());
+        TEST_ASSERT(ends_with(tpa, corelib_path, true));
+        TEST_ASSERT(keys.size() == 3 && values.size() == 3);
+
+#if defined(_WIN32)
+        // The TPA is converted to UTF-8 once
+        TEST_ASSERT(hand_over_counter.large_allocations == 1);
+#else
+        // The TPA isn't copied at all, coreclr gets the string which was built by the resolver
+        TEST_ASSERT(hand_over_counter.large_allocations == 0);
+        TEST_ASSERT(std::find(values.begin(), values.end(), tpa) != values.end());
+#endif
+    }
+
+    // The implementation of get_dir_assemblies before it was made single pass, which the results
+    // have to match, including the order in which the assemblies are added.
+    void get_dir_assemblies_reference(
+        const pal::string_t& dir,
+        name_to_resolved_asset_map_t* items)
+    {
+        version_t empty;
+        const pal::string_t managed_ext[] = { _X(".ni.dll"), _X(".dll"), _X(".ni.exe"), _X(".exe") };
+
+        std::vector<pal::string_t> files;
+        pal::readdir(dir, &files);
+
+        for (const auto& ext : managed_ext)
+        {
+            for (const auto& file : files)
+            {
+                if (file.length() <= ext.length())
+                {
+                    continue;
+                }
+
+                auto file_name = file.substr(0, file.length() - ext.length());
+                auto file_ext = file.substr(file_name.length());
+                if (pal::strcasecmp(file_ext.c_str(), ext.c_str()))
+                {
+                    continue;
+                }
+
+                if (items->count(file_name))
+                {
+                    continue;
+                }
+
+                pal::string_t file_path = dir;
+                if (!file_path.empty() && file_path.back() != DIR_SEPARATOR)
+                {
+                    file_path.push_back(DIR_SEPARATOR);
+                }
+                file_path.append(file);
+
+                deps_asset_t asset(file_name, file, empty, empty);
+                items->emplace(file_name, deps_resolved_asset_t(asset, file_path));
+            }
+        }
+    }
+
+    std::vector<std::pair<pal::string_t, pal::string_t>> to_list(const name_to_resolved_asset_map_t& items)
+    {
+        std::vector<std::pair<pal::string_t, pal::string_t>> list;
+        for (const auto& item : items)
+        {
+            TEST_ASSERT(item.first == item.second.asset.name);
+            list.push_back(std::make_pair(item.first, item.second.resolved_path + _X("|") + item.second.asset.relative_path));
+        }
+
+        return list;
+    }
+
+    void check_same_as_reference(const pal::string_t& dir, const name_to_resolved_asset_map_t& existing = name_to_resolved_asset_map_t())
+    {
+        name_to_resolved_asset_map_t expected = existing;
+        get_dir_assemblies_reference(dir, &expected);
+
+        name_to_resolved_asset_map_t actual = existing;
+        deps_resolver_t::get_dir_assemblies(dir, _X("local"), &actual);
+
+        // Iterating in the same order means the assemblies were added in the same order
+        TEST_ASSERT(to_list(actual) == to_list(expected));
+    }
+
+    void checkExtensionPriority()
+    {
+        test_dir_t test_dir(_X("test_dir_assemblies"));
+
+        const pal::char_t* names[] =
+        {
+            _X("Both.dll"), _X("Both.exe"),
+            _X("Native.ni.dll"), _X("Native.dll"),
+            _X("NativeExe.ni.exe"), _X("NativeExe.exe"), _X("NativeExe.dll"),
+            _X("OnlyNative.ni.dll"),
+            _X("Upper.DLL"), _X("Mixed.Ni.Dll"), _X("Mixed.dll"),
+            _X(".dll"), _X(".ni.dll"), _X("x.ni.dll.exe"),
+            _X("NotManaged.pdb"), _X("NotManaged.dll.config"), _X("dll"),
+        };
+
+        for (const pal::char_t* name : names)
+        {
+            test_dir.add_file(name);
+        }
+
+        create_dir(combine(test_dir.dir, _X("Directory.dll")));
+
+        check_same_as_reference(test_dir.dir);
+        check_same_as_reference(test_dir.dir + DIR_SEPARATOR);
+
+        // Assemblies which were already added win over the ones in the directory
+        name_to_resolved_asset_map_t existing;
+        version_t empty;
+        existing.emplace(_X("Both"), deps_resolved_asset_t(deps_asset_t(_X("Both"), _X("Both.dll"), empty, empty), _X("/other/Both.dll")));
+        check_same_as_reference(test_dir.dir, existing);
+
+        name_to_resolved_asset_map_t items;
+        deps_resolver_t::get_dir_assemblies(test_dir.dir, _X("local"), &items);
+        TEST_ASSERT(items.at(_X("Both")).asset.relative_path == _X("Both.dll"));
+        TEST_ASSERT(items.at(_X("Native")).asset.relative_path == _X("Native.ni.dll"));
+        TEST_ASSERT(items.at(_X("Native.ni")).asset.relative_path == _X("Native.ni.dll"));
+        TEST_ASSERT(items.at(_X("NativeExe")).asset.relative_path == _X("NativeExe.dll"));
+        TEST_ASSERT(items.at(_X("Mixed")).asset.relative_path == _X("Mixed.Ni.Dll"));
+        TEST_ASSERT(items.at(_X("Upper")).asset.relative_path == _X("Upper.DLL"));
+        TEST_ASSERT(items.count(_X("NotManaged")) == 0);
+        TEST_ASSERT(items.count(_X("")) == 0);
+    }
+
+    // Plugin folders can have thousands of assemblies, with some native images and executables among them
+    void add_synthetic_files(test_dir_t& test_dir, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            pal::string_t name = _X("Plugin.Assembly") + pal::to_string(i);
+            switch (i % 10)
+            {
+            case 0:
+                test_dir.add_file(name + _X(".ni.dll"));
+                break;
+            case 1:
+                test_dir.add_file(name + _X(".exe"));
+                break;
+            case 2:
+                test_dir.add_file(name + _X(".pdb"));
+                break;
+            default:
+                test_dir.add_file(name + _X(".dll"));
+                break;
+            }
+        }
+    }
+
+    void checkManyFiles()
+    {
+        test_dir_t test_dir(_X("test_dir_assemblies"));
+        add_synthetic_files(test_dir, 1000);
+        check_same_as_reference(test_dir.dir);
+    }
+
+    // Measures resolve_tpa_list (through resolve_probe_paths) for an app on three frameworks, and compares
+    // the package lookups it does for every entry against every framework with looking up a concatenated
+    // "name/version" string, as has_package used to. Also counts the allocations of the search paths.
+    void benchmark_resolution(int iterations)
+    {
+        const int packages_per_fx = 200;
+        const test_layout_t layout(packages_per_fx);
+
+        fx_definition_vector_t fx_definitions;
+        layout.get_fx_definitions(&fx_definitions);
+        arguments_t args;
+        layout.get_arguments(&args);
+
+        deps_resolver_t resolver(args, fx_definitions, nullptr, true);
+        pal::string_t errors;
+        TEST_ASSERT(resolver.valid(&errors));
+
+        long long resolve_us = time_us(iterations, [&]()
+        {
+            probe_paths_t probe_paths;
+            resolver.resolve_probe_paths(&probe_paths, nullptr);
+        });
+
+        std::vector<const deps_entry_t*> entries;
+        std::vector<std::unordered_set<pal::string_t>> packages(fx_definitions.size() - 1);
+        for (size_t i = 0; i < fx_definitions.size(); ++i)
+        {
+            for (const auto& entry : fx_definitions[i]->get_deps().get_entries(deps_entry_t::asset_types::runtime))
+            {
+                entries.push_back(&entry);
+                if (i > 0)
+                {
+                    packages[i - 1].insert(entry.library_name + _X("/") + entry.library_version);
+                }
+            }
+        }
+
+        const std::unordered_set<pal::string_t> no_rid_packages;
+        size_t found_concatenated = 0;
+        long long concatenated_us = time_us(iterations, [&]()
+        {
+            found_concatenated = 0;
+            for (const deps_entry_t* entry : entries)
+            {
+                for (const auto& fx_packages : packages)
+                {
+                    pal::string_t pv = entry->library_name;
+                    pv.push_back(_X('/'));
+                    pv.append(entry->library_version);
+                    if (no_rid_packages.count(pv) || fx_packages.count(pv))
+                    {
+                        found_concatenated++;
+                    }
+                }
+            }
+        });
+
+        size_t found_indexed = 0;
+        long long indexed_us = time_us(iterations, [&]()
+        {
+            found_indexed = 0;
+            for (const deps_entry_t* entry : entries)
+            {
+                for (size_t i = 1; i < fx_definitions.size(); ++i)
+                {
+                    if (fx_definitions[i]->get_deps().has_package(entry->get_package_key()))
+                    {
+                        found_indexed++;
+                    }
+                }
+            }
+        });
+
+        TEST_ASSERT(found_concatenated == found_indexed);
+
+        // The allocations of building the search paths and handing them over to coreclr, compared with
+        // handing over copies of them, as the properties used to be added and passed to coreclr_initialize.
+        const pal::string_t corelib_path = combine(layout.fx_dirs[0], CORELIB_NAME);
+        allocation_counter_t resolve_counter(0);
+        probe_paths_t probe_paths;
+        resolver.resolve_probe_paths(&probe_paths, nullptr);
+        resolve_counter.stop();
+
+        probe_paths_t copied_probe_paths = probe_paths;
+        allocation_counter_t copy_counter(0);
+        {
+            copied_probe_paths.tpa.append(corelib_path);
+            coreclr_property_bag_t properties;
+            properties.add(common_property::TrustedPlatformAssemblies, copied_probe_paths.tpa.c_str());
+            properties.add(common_property::NativeDllSearchDirectories, copied_probe_paths.native.c_str());
+            properties.add(common_property::PlatformResourceRoots, copied_probe_paths.resources.c_str());
+
+            std::vector<std::vector<char>> clr_strings;
+            std::function<void(const pal::string_t&, const pal::string_t&)> callback = [&](const pal::string_t& key, const pal::string_t& value)
+            {
+                clr_strings.push_back(std::vector<char>());
+                pal::pal_clrstring(key, &clr_strings.back());
+                clr_strings.push_back(std::vector<char>());
+                pal::pal_clrstring(value, &clr_strings.back());
+            };
+            properties.enumerate(callback);
+        }
+        copy_counter.stop();
+
+        allocation_counter_t hand_over_counter(0);
+        {
+            coreclr_property_bag_t properties;
+            std::vector<const char*> keys;
+            std::vector<const char*> values;
+            std::vector<std::vector<char>> clr_strings;
+            hand_over_search_paths(&probe_paths, corelib_path, &properties, &keys, &values, &clr_strings);
+        }
+        hand_over_counter.stop();
+
+        trace::println(_X("Resolving the probe paths of an app on %d frameworks with %d entries: %lld us per iteration"), fx_count, static_cast<int>(entries.size()), resolve_us);
+        trace::println(_X("Looking up %d packages in each framework by concatenated name:      %lld us per iteration"), static_cast<int>(entries.size()), concatenated_us);
+        trace::println(_X("Looking up %d packages in each framework by pre-hashed key:         %lld us per iteration"), static_cast<int>(entries.size()), indexed_us);
+        trace::println(_X("Building the search paths:                         %d allocations, %d bytes"), static_cast<int>(resolve_counter.allocations), static_cast<int>(resolve_counter.bytes));
+        trace::println(_X("Handing copies of the search paths over to coreclr: %d allocations, %d bytes"), static_cast<int>(copy_counter.allocations), static_cast<int>(copy_counter.bytes));
+        trace::println(_X("Handing the search paths over to coreclr:          %d allocations, %d bytes"), static_cast<int>(hand_over_counter.allocations), static_cast<int>(hand_over_counter.bytes));
+    }
+
+    // Compares the single pass over a directory with 10k files with the pass per extension it replaced.
+    void benchmark_dir_assemblies(int iterations)
+    {
+        const int file_count = 10000;
+        test_dir_t test_dir(_X("test_dir_assemblies_benchmark"));
+        add_synthetic_files(test_dir, file_count);
+
+        long long reference_us = time_us(iterations, [&]()
+        {
+            name_to_resolved_asset_map_t items;
+            get_dir_assemblies_reference(test_dir.dir, &items);
+        });
+
+        long long single_pass_us = time_us(iterations, [&]()
+        {
+            name_to_resolved_asset_map_t items;
+            deps_resolver_t::get_dir_assemblies(test_dir.dir, _X("local"), &items);
+        });
+
+        trace::println(_X("Pass per extension over %d files: %lld us per iteration"), file_count, reference_us);
+        trace::println(_X("Single pass over %d files:        %lld us per iteration"), file_count, single_pass_us);
+    }
+}
+
+#if defined(_WIN32)
+int __cdecl wmain(const int argc, const pal::char_t* argv[])
+#else
+int main(const int argc, const pal::char_t* argv[])
+#endif
+{
+    int iterations;
+    if (get_benchmark_iterations(argc, argv, &iterations))
+    {
+        benchmark_resolution(iterations);
+        benchmark_dir_assemblies(iterations);
+        return 0;
+    }
+
+    checkPackageIndex();
+    checkResolution();
+    checkSearchPathAllocations();
+    checkExtensionPriority();
+    checkManyFiles();
+}
@@ -3,6 +3,9 @@
 
 #include "fx_ver.h"
 #include "pal.h"
+#include "trace.h"
+#include "utils.h"
+#include <chrono>
 
 #define TEST_ASSERT(a) \
   if (!(a)) \
@@ -190,13 +193,311 @@ void checkInvalidVersions()
     }
 }
 
+// The stringstream and substr based implementation which fx_ver_t had before its parsing, formatting
+// and comparison stopped allocating. Used to check that the results did not change and to measure the gain.
+namespace baseline
+{
+    struct ver_t
+    {
+        int major;
+        int minor;
+        int patch;
+        pal::string_t pre;
+        pal::string_t build;
+    };
+
+    pal::string_t as_str(const ver_t& ver)
+    {
+        pal::stringstream_t stream;
+        stream << ver.major << _X(".") << ver.minor << _X(".") << ver.patch;
+        if (!ver.pre.empty())
+        {
+            stream << ver.pre;
+        }
+        if (!ver.build.empty())
+        {
+            stream << ver.build;
+        }
+        return stream.str();
+    }
+
+    pal::string_t getId(const pal::string_t &ids, size_t idStart)
+    {
+        size_t next = ids.find(_X('.'), idStart);
+
+        return next == pal::string_t::npos ? ids.substr(idStart) : ids.substr(idStart, next - idStart);
+    }
+
+    int compare(const ver_t& a, const ver_t& b)
+    {
+        if (a.major != b.major)
+        {
+            return (a.major > b.major) ? 1 : -1;
+        }
+
+        if (a.minor != b.minor)
+        {
+            return (a.minor > b.minor) ? 1 : -1;
+        }
+
+        if (a.patch != b.patch)
+        {
+            return (a.patch > b.patch) ? 1 : -1;
+        }
+
+        if (a.pre.empty() || b.pre.empty())
+        {
+            return a.pre.empty() ? !b.pre.empty() : -1;
+        }
+
+        size_t idStart = 1;
+        for (size_t i = idStart; true; ++i)
+        {
+            if (a.pre[i] != b.pre[i])
+            {
+                if (a.pre[i] == 0 && b.pre[i] == _X('.'))
+                {
+                    return -1;
+                }
+
+                if (b.pre[i] == 0 && a.pre[i] == _X('.'))
+                {
+                    return 1;
+                }
+
+                pal::string_t ida = getId(a.pre, idStart);
+                pal::string_t idb = getId(b.pre, idStart);
+
+                unsigned idanum = 0;
+                bool idaIsNum = try_stou(ida, &idanum);
+                unsigned idbnum = 0;
+                bool idbIsNum = try_stou(idb, &idbnum);
+
+                if (idaIsNum && idbIsNum)
+                {
+                    return (idanum > idbnum) ? 1 : -1;
+                }
+                else if (idaIsNum || idbIsNum)
+                {
+                    return idbIsNum ? 1 : -1;
+                }
+                return ida.compare(idb);
+            }
+            else
+            {
+                if (a.pre[i] == 0)
+                {
+                    break;
+                }
+                if (a.pre[i] == _X('.'))
+                {
+                    idStart = i + 1;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    // Only handles valid versions, the validation did not allocate any differently than the parsing
+    bool parse(const pal::string_t& ver, ver_t* out)
+    {
+        size_t maj_sep = ver.find(_X('.'));
+        size_t min_sep = ver.find(_X('.'), maj_sep + 1);
+        size_t pat_sep = index_of_non_numeric(ver, static_cast<unsigned>(min_sep + 1));
+
+        unsigned major = 0;
+        unsigned minor = 0;
+        unsigned patch = 0;
+        if (!try_stou(ver.substr(0, maj_sep), &major) ||
+            !try_stou(ver.substr(maj_sep + 1, min_sep - maj_sep - 1), &minor) ||
+            !try_stou(pat_sep == pal::string_t::npos ? ver.substr(min_sep + 1) : ver.substr(min_sep + 1, pat_sep - min_sep - 1), &patch))
+        {
+            return false;
+        }
+
+        pal::string_t pre;
+        pal::string_t build;
+        if (pat_sep != pal::string_t::npos)
+        {
+            size_t pre_sep = ver.find(_X('+'), pat_sep);
+            pre = (pre_sep == pal::string_t::npos) ? ver.substr(pat_sep) : ver.substr(pat_sep, pre_sep - pat_sep);
+            if (pre_sep != pal::string_t::npos)
+            {
+                build = ver.substr(pre_sep);
+            }
+        }
+
+        *out = ver_t { static_cast<int>(major), static_cast<int>(minor), static_cast<int>(patch), pre, build };
+        return true;
+    }
+}
+
+// A realistic set of installed framework and SDK versions: 300 entries over several majors,
+// with servicing releases and the previews and release candidates which preceded them.
+std::vector<pal::string_t> getInstalledVersions()
+{
+    const pal::char_t* labels[] =
+    {
+        _X("-preview1-26216-03"),
+        _X("-preview.3.19128.7"),
+        _X("-preview.8.20407.11"),
+        _X("-rc.1.20451.14"),
+        _X("-rc.2.20475.5+4ee35a1"),
+        _X(""),
+        _X("+servicing.21209.4"),
+    };
+
+    std::vector<pal::string_t> versions;
+    for (int major = 2; versions.size() < 300; ++major)
+    {
+        for (int minor = 0; minor < 3 && versions.size() < 300; ++minor)
+        {
+            for (int patch = 0; patch < 16 && versions.size() < 300; ++patch)
+            {
+                const pal::char_t* label = labels[(major + minor + patch) % (sizeof(labels) / sizeof(labels[0]))];
+                pal::stringstream_t stream;
+                stream << major << _X(".") << minor << _X(".") << patch << label;
+                versions.push_back(stream.str());
+            }
+        }
+    }
+
+    return versions;
+}
+
+void checkBaseline()
+{
+    std::vector<pal::string_t> strs = getInstalledVersions();
+    for (size_t i = 0; i < cases; ++i)
+    {
+        strs.push_back(orderedCases[i].str);
+    }
+
+    std::vector<fx_ver_t> vers(strs.size());
+    std::vector<baseline::ver_t> baseline_vers(strs.size());
+    for (size_t i = 0; i < strs.size(); ++i)
+    {
+        TEST_ASSERT(fx_ver_t::parse(strs[i], &vers[i]));
+        TEST_ASSERT(baseline::parse(strs[i], &baseline_vers[i]));
+        TEST_ASSERT(vers[i].as_str() == baseline::as_str(baseline_vers[i]));
+
+        pal::char_t buffer[64];
+        TEST_ASSERT(vers[i].as_str(buffer, 64) == strs[i].length());
+        TEST_ASSERT(strs[i] == buffer);
+        TEST_ASSERT(vers[i].as_str(buffer, strs[i].length()) == strs[i].length());
+    }
+
+    for (size_t i = 0; i < vers.size(); ++i)
+    {
+        for (size_t j = 0; j < vers.size(); ++j)
+        {
+            int expected = baseline::compare(baseline_vers[i], baseline_vers[j]);
+            TEST_ASSERT((vers[i] < vers[j]) == (expected < 0));
+            TEST_ASSERT((vers[i] == vers[j]) == (expected == 0));
+            TEST_ASSERT((vers[i] > vers[j]) == (expected > 0));
+        }
+    }
+}
+
+template<typename T>
+long long time_us(int iterations, T action)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        action();
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / iterations;
+}
+
+// Parses, sorts and formats the installed versions, as the framework and SDK resolution does
+// when it looks for the best match, with the baseline and the current implementation.
+int benchmark(int iterations)
+{
+    std::vector<pal::string_t> strs = getInstalledVersions();
+
+    std::vector<baseline::ver_t> baseline_vers(strs.size());
+    long long baseline_parse_us = time_us(iterations, [&]()
+    {
+        for (size_t i = 0; i < strs.size(); ++i)
+        {
+            baseline::parse(strs[i], &baseline_vers[i]);
+        }
+    });
+
+    std::vector<fx_ver_t> vers(strs.size());
+    long long parse_us = time_us(iterations, [&]()
+    {
+        for (size_t i = 0; i < strs.size(); ++i)
+        {
+            fx_ver_t::parse(strs[i], &vers[i]);
+        }
+    });
+
+    // Sort indices rather than the versions, so that only the comparisons are measured
+    std::vector<size_t> order(strs.size());
+    long long baseline_sort_us = time_us(iterations, [&]()
+    {
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return baseline::compare(baseline_vers[a], baseline_vers[b]) < 0; });
+    });
+
+    long long sort_us = time_us(iterations, [&]()
+    {
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return vers[a] < vers[b]; });
+    });
+
+    size_t length = 0;
+    long long baseline_format_us = time_us(iterations, [&]()
+    {
+        for (const baseline::ver_t& ver : baseline_vers)
+        {
+            length += baseline::as_str(ver).length();
+        }
+    });
+
+    long long format_us = time_us(iterations, [&]()
+    {
+        pal::char_t buffer[64];
+        for (const fx_ver_t& ver : vers)
+        {
+            length += ver.as_str(buffer, 64);
+        }
+    });
+
+    trace::println(_X("Versions: %d"), static_cast<int>(strs.size()));
+    trace::println(_X("Parse:  %lld us baseline, %lld us current"), baseline_parse_us, parse_us);
+    trace::println(_X("Sort:   %lld us baseline, %lld us current"), baseline_sort_us, sort_us);
+    trace::println(_X("Format: %lld us baseline, %lld us current"), baseline_format_us, format_us);
+
+    return length > 0 ? 0 : 1;
+}
+
 #if defined(_WIN32)
 int __cdecl wmain(const int argc, const pal::char_t* argv[])
 #else
 int main(const int argc, const pal::char_t* argv[])
 #endif
 {
+    if (argc > 1)
+    {
+        // test_fx_ver benchmark [iterations]
+        int iterations = argc > 2 ? pal::xtoi(argv[2]) : 100;
+        return benchmark(iterations > 0 ? iterations : 1);
+    }
+
     checkInvalidVersions();
     checkParsing();
     checkPrecedence();
+    checkBaseline();
 }
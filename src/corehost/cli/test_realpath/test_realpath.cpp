@@ -0,0 +1,210 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "pal.h"
+#include "test_utils.h"
+#include "trace.h"
+#include "utils.h"
+#include <atomic>
+#include <thread>
+
+using namespace test_utils;
+
+namespace
+{
+    const int file_count = 500;
+
+    pal::string_t get_file_name(int i)
+    {
+        return _X("System.File") + pal::to_string(i) + _X(".dll");
+    }
+
+    // A framework directory with many files, reached through a symlinked install location the way
+    // a package manager might set it up.
+    struct test_layout_t
+    {
+        test_dir_t root_dir;
+        pal::string_t root;
+        pal::string_t real_fx_dir;
+        pal::string_t fx_dir;
+
+        test_layout_t()
+            : root_dir(_X("test_realpath"))
+            , root(root_dir.dir)
+        {
+            TEST_ASSERT(pal::realpath(&root));
+
+            pal::string_t real_dotnet_dir = combine(root, _X("real"));
+            create_dir(real_dotnet_dir);
+            real_fx_dir = combine(real_dotnet_dir, _X("fx"));
+            create_dir(real_fx_dir);
+            for (int i = 0; i < file_count; ++i)
+            {
+                create_file(combine(real_fx_dir, get_file_name(i).c_str()));
+            }
+
+            fx_dir = combine(root, _X("dotnet"));
+#if defined(_WIN32)
+            fx_dir = real_fx_dir;
+#else
+            TEST_ASSERT(::symlink(real_dotnet_dir.c_str(), fx_dir.c_str()) == 0);
+            fx_dir = combine(fx_dir, _X("fx"));
+
+            // A file which is itself a symlink to a file in another directory
+            pal::string_t other_dir = combine(root, _X("other"));
+            create_dir(other_dir);
+            create_file(combine(other_dir, _X("Target.dll")));
+            TEST_ASSERT(::symlink(combine(other_dir, _X("Target.dll")).c_str(), combine(real_fx_dir, _X("Link.dll")).c_str()) == 0);
+#endif
+        }
+    };
+
+    void check_same_as_realpath(const pal::string_t& path)
+    {
+        pal::string_t expected = path;
+        bool expected_result = pal::realpath(&expected, true);
+
+        pal::string_t actual = path;
+        bool actual_result = pal::realpath_cached(&actual, true);
+
+        TEST_ASSERT(actual_result == expected_result);
+        TEST_ASSERT(!actual_result || actual == expected);
+    }
+
+    void checkResolution(const test_layout_t& layout)
+    {
+        pal::clear_realpath_cache();
+
+        for (int i = 0; i < file_count; ++i)
+        {
+            check_same_as_realpath(combine(layout.fx_dir, get_file_name(i).c_str()));
+        }
+
+        // Files which don't exist, in directories which do and don't exist
+        check_same_as_realpath(combine(layout.fx_dir, _X("Missing.dll")));
+        check_same_as_realpath(combine(combine(layout.fx_dir, _X("missing")), _X("Missing.dll")));
+
+        // Paths which are resolved without the cache
+        check_same_as_realpath(layout.fx_dir);
+        check_same_as_realpath(layout.fx_dir + DIR_SEPARATOR);
+        check_same_as_realpath(combine(combine(layout.fx_dir, _X("..")), _X("fx")));
+        check_same_as_realpath(_X("test_realpath.missing"));
+
+#if !defined(_WIN32)
+        check_same_as_realpath(combine(layout.fx_dir, _X("Link.dll")));
+
+        // A file in place of a directory
+        check_same_as_realpath(combine(combine(layout.fx_dir, get_file_name(0).c_str()), _X("Missing.dll")));
+#endif
+    }
+
+    void checkConcurrentResolution(const test_layout_t& layout)
+    {
+        pal::clear_realpath_cache();
+
+        const int thread_count = 8;
+        std::atomic<int> failures(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t)
+        {
+            threads.push_back(std::thread([&layout, &failures, t]()
+            {
+                for (int i = t; i < file_count; i += thread_count)
+                {
+                    pal::string_t path = combine(layout.fx_dir, get_file_name(i).c_str());
+                    if (!pal::realpath_cached(&path) || path != combine(layout.real_fx_dir, get_file_name(i).c_str()))
+                    {
+                        failures++;
+                    }
+                }
+            }));
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        TEST_ASSERT(failures == 0);
+    }
+
+    void checkInvalidation(const test_layout_t& layout)
+    {
+#if !defined(_WIN32)
+        // Retargeting the symlinked directory is only seen once the cache is cleared
+        pal::clear_realpath_cache();
+        pal::string_t path = combine(layout.fx_dir, get_file_name(0).c_str());
+        TEST_ASSERT(pal::realpath_cached(&path));
+
+        pal::string_t other_dotnet_dir = combine(layout.root, _X("other_dotnet"));
+        create_dir(other_dotnet_dir);
+        create_dir(combine(other_dotnet_dir, _X("fx")));
+        create_file(combine(combine(other_dotnet_dir, _X("fx")), get_file_name(0).c_str()));
+
+        pal::string_t link = combine(layout.root, _X("dotnet"));
+        TEST_ASSERT(pal::remove(link.c_str()) == 0);
+        TEST_ASSERT(::symlink(other_dotnet_dir.c_str(), link.c_str()) == 0);
+
+        pal::clear_realpath_cache();
+        check_same_as_realpath(combine(layout.fx_dir, get_file_name(0).c_str()));
+        path = combine(layout.fx_dir, get_file_name(0).c_str());
+        TEST_ASSERT(pal::realpath_cached(&path));
+        TEST_ASSERT(path.compare(0, other_dotnet_dir.length(), other_dotnet_dir) == 0);
+#endif
+    }
+
+    // Compares resolving all of the files in the framework directory, as a TPA list does, with and without the cache.
+    int benchmark(int iterations)
+    {
+        test_layout_t layout;
+
+        std::vector<pal::string_t> paths;
+        for (int i = 0; i < file_count; ++i)
+        {
+            paths.push_back(combine(layout.fx_dir, get_file_name(i).c_str()));
+        }
+
+        long long realpath_us = time_us(iterations, [&]()
+        {
+            for (const auto& path : paths)
+            {
+                pal::string_t real = path;
+                pal::realpath(&real);
+            }
+        });
+
+        long long cached_us = time_us(iterations, [&]()
+        {
+            pal::clear_realpath_cache();
+            for (const auto& path : paths)
+            {
+                pal::string_t real = path;
+                pal::realpath_cached(&real);
+            }
+        });
+
+        trace::println(_X("Resolving %d files:           %lld us per iteration"), file_count, realpath_us);
+        trace::println(_X("Resolving them with the cache: %lld us per iteration"), cached_us);
+
+        return 0;
+    }
+}
+
+#if defined(_WIN32)
+int __cdecl wmain(const int argc, const pal::char_t* argv[])
+#else
+int main(const int argc, const pal::char_t* argv[])
+#endif
+{
+    int iterations;
+    if (get_benchmark_iterations(argc, argv, &iterations))
+    {
+        return benchmark(iterations);
+    }
+
+    test_layout_t layout;
+    checkResolution(layout);
+    checkConcurrentResolution(layout);
+    checkInvalidation(layout);
+}
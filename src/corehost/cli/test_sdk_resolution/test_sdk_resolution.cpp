@@ -0,0 +1,212 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "install_index.h"
+#include "pal.h"
+#include "sdk_resolution_memo.h"
+#include "sdk_resolver.h"
+#include "test_utils.h"
+#include "trace.h"
+#include "utils.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace test_utils;
+
+namespace
+{
+    const int working_dir_count = 24;
+
+    // The versions are higher than any real SDK, so that SDKs installed in the global locations don't win
+    const pal::char_t* latest_version = _X("99.0.100");
+    const pal::char_t* pinned_versions[] = { _X("97.0.100"), _X("98.0.100") };
+
+    void write_global_json(const pal::string_t& dir, const pal::char_t* version)
+    {
+        pal::string_t content = _X("{ \"sdk\": { \"version\": \"");
+        content.append(version);
+        content.append(_X("\", \"rollForward\": \"disable\" } }"));
+        write_file(combine(dir, _X("global.json")), content);
+    }
+
+    // An install location with a few SDKs, and working directories nested in directories which either
+    // pin one of the SDKs with a global.json or have none.
+    struct test_layout_t
+    {
+        test_dir_t root_dir;
+        const pal::string_t& root;
+        pal::string_t dotnet_dir;
+        pal::string_t sdk_dir;
+        std::vector<pal::string_t> pin_dirs;
+        std::vector<pal::string_t> working_dirs;
+
+        test_layout_t()
+            : root_dir(_X("test_sdk_resolution"))
+            , root(root_dir.dir)
+        {
+            dotnet_dir = combine(root, _X("dotnet"));
+            create_dir(dotnet_dir);
+            sdk_dir = combine(dotnet_dir, _X("sdk"));
+            create_dir(sdk_dir);
+            create_dir(combine(sdk_dir, pinned_versions[0]));
+            create_dir(combine(sdk_dir, pinned_versions[1]));
+            create_dir(combine(sdk_dir, latest_version));
+
+            for (int i = 0; i < working_dir_count; ++i)
+            {
+                pal::string_t pin_dir = combine(root, (_X("project") + pal::to_string(i)).c_str());
+                create_dir(pin_dir);
+                if (get_pinned_version(i) != nullptr)
+                {
+                    write_global_json(pin_dir, get_pinned_version(i));
+                }
+
+                pal::string_t working_dir = combine(pin_dir, _X("src"));
+                create_dir(working_dir);
+                working_dir = combine(working_dir, _X("lib"));
+                create_dir(working_dir);
+
+                pin_dirs.push_back(pin_dir);
+                working_dirs.push_back(working_dir);
+            }
+        }
+
+        static const pal::char_t* get_pinned_version(int i)
+        {
+            return i % 3 == 2 ? nullptr : pinned_versions[i % 3];
+        }
+
+        pal::string_t get_expected_sdk_dir(int i) const
+        {
+            return combine(sdk_dir, get_pinned_version(i) != nullptr ? get_pinned_version(i) : latest_version);
+        }
+    };
+
+    pal::string_t resolve(const test_layout_t& layout, int i, pal::string_t* global_file = nullptr)
+    {
+        pal::string_t sdk_dir;
+        pal::string_t global_file_local;
+        sdk_resolution_memo::resolve_sdk(layout.dotnet_dir, layout.working_dirs[i], true, &sdk_dir, global_file != nullptr ? global_file : &global_file_local);
+        return sdk_dir;
+    }
+
+    void checkConcurrentResolution(const test_layout_t& layout)
+    {
+        const int thread_count = 16;
+        const int iterations = 50;
+
+        // Each thread resolves all of the working directories, starting at a different one
+        std::atomic<int> failures(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t)
+        {
+            threads.push_back(std::thread([&layout, &failures, t]()
+            {
+                for (int n = 0; n < iterations; ++n)
+                {
+                    int i = (t + n) % working_dir_count;
+                    pal::string_t global_file;
+                    if (resolve(layout, i, &global_file) != layout.get_expected_sdk_dir(i)
+                        || global_file.empty() != (test_layout_t::get_pinned_version(i) == nullptr))
+                    {
+                        failures++;
+                    }
+
+                    std::vector<pal::string_t> sdk_dirs;
+                    sdk_resolution_memo::get_available_sdks(layout.dotnet_dir, &sdk_dirs);
+                    if (sdk_dirs.size() < 3 || sdk_dirs.back() != combine(layout.sdk_dir, latest_version))
+                    {
+                        failures++;
+                    }
+                }
+            }));
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        TEST_ASSERT(failures == 0);
+    }
+
+    void checkInvalidation(const test_layout_t& layout)
+    {
+        // Installing a later SDK changes the latest one
+        create_dir(combine(layout.sdk_dir, _X("99.1.100")));
+        TEST_ASSERT(resolve(layout, 2) == combine(layout.sdk_dir, _X("99.1.100")));
+        TEST_ASSERT(resolve(layout, 0) == layout.get_expected_sdk_dir(0));
+
+        std::vector<pal::string_t> sdk_dirs;
+        sdk_resolution_memo::get_available_sdks(layout.dotnet_dir, &sdk_dirs);
+        TEST_ASSERT(sdk_dirs.back() == combine(layout.sdk_dir, _X("99.1.100")));
+
+        // Uninstalling it changes it back
+        pal::rmdir(combine(layout.sdk_dir, _X("99.1.100")).c_str());
+        TEST_ASSERT(resolve(layout, 2) == combine(layout.sdk_dir, latest_version));
+
+        sdk_resolution_memo::get_available_sdks(layout.dotnet_dir, &sdk_dirs);
+        TEST_ASSERT(sdk_dirs.back() == combine(layout.sdk_dir, latest_version));
+
+        // Changing a global.json changes the SDK it pins
+        write_global_json(layout.pin_dirs[0], latest_version);
+        TEST_ASSERT(resolve(layout, 0) == combine(layout.sdk_dir, latest_version));
+
+        // Even when the change keeps its size and is made right after the last resolution
+        TEST_ASSERT(resolve(layout, 1) == combine(layout.sdk_dir, pinned_versions[1]));
+        write_global_json(layout.pin_dirs[1], pinned_versions[0]);
+        TEST_ASSERT(resolve(layout, 1) == combine(layout.sdk_dir, pinned_versions[0]));
+
+        // A nearer global.json takes over
+        write_global_json(layout.working_dirs[2], pinned_versions[1]);
+        pal::string_t global_file;
+        TEST_ASSERT(resolve(layout, 2, &global_file) == combine(layout.sdk_dir, pinned_versions[1]));
+        TEST_ASSERT(global_file == combine(layout.working_dirs[2], _X("global.json")));
+
+        // Removing it makes the resolution use the latest SDK again
+        pal::remove(combine(layout.working_dirs[2], _X("global.json")).c_str());
+        TEST_ASSERT(resolve(layout, 2, &global_file) == combine(layout.sdk_dir, latest_version));
+        TEST_ASSERT(global_file.empty());
+    }
+
+    // Compares resolving an SDK from scratch, as every call to hostfxr_resolve_sdk2 used to, with resolving it from the memo.
+    int benchmark(int iterations)
+    {
+        test_layout_t layout;
+
+        long long full_us = time_us(iterations, [&]()
+        {
+            install_index_cache_t install_indexes;
+            sdk_resolver::from_nearest_global_file(layout.working_dirs[0]).resolve(layout.dotnet_dir, install_indexes);
+        });
+
+        // Resolutions are only memoized once their inputs are older than the time stamp granularity
+        std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+        resolve(layout, 0);
+        long long memoized_us = time_us(iterations, [&]() { resolve(layout, 0); });
+
+        trace::println(_X("Resolving an SDK:         %lld us per iteration"), full_us);
+        trace::println(_X("Resolving it memoized:    %lld us per iteration"), memoized_us);
+
+        return 0;
+    }
+}
+
+#if defined(_WIN32)
+int __cdecl wmain(const int argc, const pal::char_t* argv[])
+#else
+int main(const int argc, const pal::char_t* argv[])
+#endif
+{
+    int iterations;
+    if (get_benchmark_iterations(argc, argv, &iterations))
+    {
+        return benchmark(iterations);
+    }
+
+    test_layout_t layout;
+    checkConcurrentResolution(layout);
+    checkInvalidation(layout);
+}
@@ -0,0 +1,144 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "deps_format.h"
+#include "pal.h"
+#include "trace.h"
+#include "utils.h"
+#include <chrono>
+
+#define TEST_ASSERT(a) \
+  if (!(a)) \
+  { \
+    fprintf(stderr, "TEST_ASSERT failed '%s' at %d\n", #a, __LINE__); \
+    exit(1); \
+  }
+
+namespace
+{
+    int g_evaluations = 0;
+
+    const pal::char_t* evaluate(const pal::char_t* value)
+    {
+        g_evaluations++;
+        return value;
+    }
+
+    void checkLazyArguments()
+    {
+        // Tracing is disabled until trace::enable is called
+        TEST_ASSERT(!trace::is_enabled());
+        TRACE_VERBOSE(_X("verbose %s"), evaluate(_X("value")));
+        TRACE_INFO(_X("info %s"), evaluate(_X("value")));
+        TEST_ASSERT(g_evaluations == 0);
+
+        // The macros are single statements
+        if (g_evaluations != 0)
+            TRACE_VERBOSE(_X("verbose"));
+        else
+            TRACE_INFO(_X("info"));
+
+        // Collect the enabled output in a buffer instead of writing it out
+        trace::buffer_t buffer;
+        trace::set_buffer(&buffer);
+        trace::enable();
+        TEST_ASSERT(trace::is_info_enabled());
+
+        TRACE_INFO(_X("info %s"), evaluate(_X("value")));
+        TEST_ASSERT(g_evaluations == 1);
+        TEST_ASSERT(buffer.size() == 1 && buffer[0].message == _X("info value"));
+
+        if (trace::is_verbose_enabled())
+        {
+            TRACE_VERBOSE(_X("verbose %s"), evaluate(_X("value")));
+            TEST_ASSERT(g_evaluations == 2);
+            TEST_ASSERT(buffer.size() == 2 && buffer[1].message == _X("verbose value"));
+        }
+
+        trace::set_buffer(nullptr);
+    }
+
+    template<typename T>
+    long long time_us(int iterations, T action)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            action();
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / iterations;
+    }
+
+    // Loads a deps file, e.g. Microsoft.NETCore.App.deps.json, with tracing disabled and compares what tracing
+    // its assets costs when the arguments are evaluated up front, as trace::info does, and when they are not.
+    int benchmark(const pal::string_t& deps_path, int iterations)
+    {
+        TEST_ASSERT(!trace::is_enabled());
+
+        deps_json_t deps;
+        long long load_us = time_us(iterations, [&]() { deps = deps_json_t(false, deps_path); });
+        TEST_ASSERT(deps.is_valid());
+
+        size_t asset_count = 0;
+        for (size_t i = 0; i < deps_entry_t::asset_types::count; ++i)
+        {
+            asset_count += deps.get_entries(static_cast<deps_entry_t::asset_types>(i)).size();
+        }
+
+        auto trace_assets = [&](bool lazy)
+        {
+            for (size_t i = 0; i < deps_entry_t::asset_types::count; ++i)
+            {
+                for (const auto& entry : deps.get_entries(static_cast<deps_entry_t::asset_types>(i)))
+                {
+                    if (lazy)
+                    {
+                        TRACE_INFO(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
+                            deps_entry_t::s_known_asset_types[i],
+                            entry.asset.relative_path.c_str(),
+                            entry.asset.assembly_version.as_str().c_str(),
+                            entry.asset.file_version.as_str().c_str(),
+                            entry.library_name.c_str());
+                    }
+                    else
+                    {
+                        trace::info(_X("Adding %s asset %s assemblyVersion=%s fileVersion=%s from %s"),
+                            deps_entry_t::s_known_asset_types[i],
+                            entry.asset.relative_path.c_str(),
+                            entry.asset.assembly_version.as_str().c_str(),
+                            entry.asset.file_version.as_str().c_str(),
+                            entry.library_name.c_str());
+                    }
+                }
+            }
+        };
+
+        long long eager_us = time_us(iterations, [&]() { trace_assets(false); });
+        long long lazy_us = time_us(iterations, [&]() { trace_assets(true); });
+
+        trace::println(_X("Assets: %d"), static_cast<int>(asset_count));
+        trace::println(_X("Deps load with tracing disabled:     %lld us per iteration"), load_us);
+        trace::println(_X("Tracing the assets, eager arguments: %lld us per iteration"), eager_us);
+        trace::println(_X("Tracing the assets, lazy arguments:  %lld us per iteration"), lazy_us);
+
+        return 0;
+    }
+}
+
+#if defined(_WIN32)
+int __cdecl wmain(const int argc, const pal::char_t* argv[])
+#else
+int main(const int argc, const pal::char_t* argv[])
+#endif
+{
+    if (argc > 1)
+    {
+        int iterations = argc > 2 ? pal::xtoi(argv[2]) : 100;
+        return benchmark(argv[1], iterations > 0 ? iterations : 1);
+    }
+
+    checkLazyArguments();
+}
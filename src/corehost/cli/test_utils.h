@@ -0,0 +1,139 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __TEST_UTILS_H_
+#define __TEST_UTILS_H_
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "pal.h"
+#include "utils.h"
+
+// Helpers shared by the native tests, which create their test files in a temporary directory.
+//
+// Passing an iteration count as the only argument makes a test run its benchmark instead of its checks.
+
+#define TEST_ASSERT(a) \
+  if (!(a)) \
+  { \
+    fprintf(stderr, "TEST_ASSERT failed '%s' at %d\n", #a, __LINE__); \
+    exit(1); \
+  }
+
+namespace test_utils
+{
+    inline pal::string_t combine(const pal::string_t& dir, const pal::char_t* name)
+    {
+        pal::string_t path = dir;
+        append_path(&path, name);
+        return path;
+    }
+
+    inline void create_dir(const pal::string_t& dir)
+    {
+        pal::mkdir(dir.c_str(), 0755);
+        TEST_ASSERT(pal::directory_exists(dir));
+    }
+
+    inline void create_file(const pal::string_t& path)
+    {
+        FILE* file = pal::file_open(path, _X("wb"));
+        TEST_ASSERT(file != nullptr);
+        fclose(file);
+    }
+
+    // Writes the content encoded in UTF-8
+    inline void write_file(const pal::string_t& path, const pal::string_t& content)
+    {
+        std::vector<char> utf8_content;
+        TEST_ASSERT(pal::pal_utf8string(content, &utf8_content));
+
+        FILE* file = pal::file_open(path, _X("wb"));
+        TEST_ASSERT(file != nullptr);
+        TEST_ASSERT(fwrite(utf8_content.data(), 1, utf8_content.size() - 1, file) == utf8_content.size() - 1);
+        fclose(file);
+    }
+
+    inline void remove_dir(const pal::string_t& dir)
+    {
+        std::vector<pal::string_t> dirs;
+        pal::readdir_onlydirectories(dir, &dirs);
+        for (const auto& name : dirs)
+        {
+            remove_dir(combine(dir, name.c_str()));
+        }
+
+        std::vector<pal::string_t> files;
+        pal::readdir(dir, &files);
+        for (const auto& name : files)
+        {
+            pal::remove(combine(dir, name.c_str()).c_str());
+        }
+
+        pal::rmdir(dir.c_str());
+    }
+
+    // An empty directory in the temporary directory, which is removed along with its contents when done.
+    // The process id is part of the name, so that concurrent runs of the tests don't interfere.
+    struct test_dir_t
+    {
+        pal::string_t dir;
+
+        test_dir_t(const pal::char_t* name)
+        {
+            TEST_ASSERT(pal::get_temp_directory(dir));
+            dir = combine(dir, (pal::string_t(name) + _X(".") + pal::to_string(pal::get_pid())).c_str());
+            remove_dir(dir);
+            create_dir(dir);
+        }
+
+        ~test_dir_t()
+        {
+            remove_dir(dir);
+        }
+
+        test_dir_t(const test_dir_t&) = delete;
+        test_dir_t& operator=(const test_dir_t&) = delete;
+
+        void add_file(const pal::string_t& name) const
+        {
+            create_file(combine(dir, name.c_str()));
+        }
+    };
+
+    // Average duration of the action in microseconds
+    template<typename T>
+    long long time_us(int iterations, T action)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            action();
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / iterations;
+    }
+
+    // Returns true if the benchmark was asked for, along with the number of iterations to run.
+    inline bool get_benchmark_iterations(const int argc, const pal::char_t* argv[], int* iterations)
+    {
+        if (argc <= 1)
+        {
+            return false;
+        }
+
+        *iterations = pal::xtoi(argv[1]);
+        if (*iterations <= 0)
+        {
+            *iterations = 1;
+        }
+
+        return true;
+    }
+}
+
+#endif // __TEST_UTILS_H_
@@ -52,29 +52,35 @@ bool version_t::operator >=(const version_t& b) const
 
 pal::string_t version_t::as_str() const
 {
-    pal::stringstream_t stream;
+    pal::char_t buffer[48];
+    size_t length = as_str(buffer, sizeof(buffer) / sizeof(buffer[0]));
+    assert(length < sizeof(buffer) / sizeof(buffer[0]));
+    return pal::string_t(buffer, length);
+}
 
-    if (m_major >= 0)
-    {
-        stream << m_major;
+size_t version_t::as_str(pal::char_t* buffer, size_t size) const
+{
+    // Four segments of at most 11 characters each and their separators
+    pal::char_t str[47];
+    size_t length = 0;
 
-        if (m_minor >= 0)
+    const int segments[] = { m_major, m_minor, m_build, m_revision };
+    for (size_t i = 0; i < sizeof(segments) / sizeof(segments[0]) && segments[i] >= 0; ++i)
+    {
+        if (i > 0)
         {
-            stream << _X(".") << m_minor;
-
-            if (m_build >= 0)
-            {
-                stream << _X(".") << m_build;
-
-                if (m_revision >= 0)
-                {
-                    stream << _X(".") << m_revision;
-                }
-            }
+            str[length++] = _X('.');
         }
+        length += write_int(segments[i], str + length);
     }
 
-    return stream.str();
+    if (length < size)
+    {
+        std::copy(str, str + length, buffer);
+        buffer[length] = 0;
+    }
+
+    return length;
 }
 
 /*static*/ int version_t::compare(const version_t&a, const version_t& b)
@@ -102,62 +108,37 @@ pal::string_t version_t::as_str() const
     return 0;
 }
 
-bool parse_internal(const pal::string_t& ver, version_t* ver_out)
+static bool parse_internal(const pal::string_t& ver, version_t* ver_out)
 {
-    unsigned major = -1;
-    size_t maj_start = 0;
-    size_t maj_sep = ver.find(_X('.'));
-    if (maj_sep == pal::string_t::npos)
-    {
-        return false; // minor required
-    }
-    if (!try_stou(ver.substr(maj_start, maj_sep), &major))
-    {
-        return false;
-    }
+    // Parses the segments in place; the major and minor segments are required
+    unsigned segments[] = { (unsigned)-1, (unsigned)-1, (unsigned)-1, (unsigned)-1 };
+    const size_t max_segments = sizeof(segments) / sizeof(segments[0]);
 
-    unsigned minor = -1;
-    size_t min_start = maj_sep + 1;
-    size_t min_sep = ver.find(_X('.'), min_start);
-    if (min_sep == pal::string_t::npos)
+    size_t count = 0;
+    size_t start = 0;
+    while (true)
     {
-        if (!try_stou(ver.substr(min_start), &minor))
+        size_t sep = (count + 1 < max_segments) ? ver.find(_X('.'), start) : pal::string_t::npos;
+        size_t end = (sep == pal::string_t::npos) ? ver.length() : sep;
+        if (!try_stou(ver.c_str() + start, end - start, &segments[count]))
         {
             return false;
         }
-        *ver_out = version_t(major, minor, -1, -1);
-        return true; // build and revision not required
-    }
-    if (!try_stou(ver.substr(min_start, min_sep - min_start), &minor))
-    {
-        return false;
-    }
 
-    unsigned build = -1;
-    size_t build_start = min_sep + 1;
-    size_t build_sep = ver.find(_X('.'), build_start);
-    if (build_sep == pal::string_t::npos)
-    {
-        if (!try_stou(ver.substr(build_start), &build))
+        count++;
+        if (sep == pal::string_t::npos)
         {
-            return false;
+            break;
         }
-        *ver_out = version_t(major, minor, build, -1);
-        return true; // revision not required
-    }
-    if (!try_stou(ver.substr(build_start, build_sep - build_start), &build))
-    {
-        return false;
+        start = sep + 1;
     }
 
-    unsigned revision = -1;
-    size_t revision_start = build_sep + 1;
-    if (!try_stou(ver.substr(revision_start), &revision))
+    if (count < 2)
     {
-        return false;
+        return false; // minor required
     }
-    *ver_out = version_t(major, minor, build, revision);
 
+    *ver_out = version_t(segments[0], segments[1], segments[2], segments[3]);
     return true;
 }
 
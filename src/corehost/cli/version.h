@@ -24,6 +24,9 @@ struct version_t
     void set_revision(int m) { m_revision = m; }
 
     pal::string_t as_str() const;
+    // Writes the version to buffer, null terminated, if it fits into size characters.
+    // Returns the length of the version either way, so that the caller can tell whether it fit.
+    size_t as_str(pal::char_t* buffer, size_t size) const;
 
     bool operator ==(const version_t& b) const;
     bool operator !=(const version_t& b) const;
@@ -0,0 +1,103 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "env_snapshot.h"
+#include <array>
+
+namespace
+{
+    const pal::char_t* env_names[] =
+    {
+        _X("COREHOST_TRACE"),
+        _X("COREHOST_TRACEFILE"),
+        _X("COREHOST_TRACE_VERBOSITY"),
+        _X("CORE_BREADCRUMBS"),
+        _X("CORE_SERVICING"),
+        _X("DOTNET_ADDITIONAL_DEPS"),
+        _X("DOTNET_BUNDLE_EXTRACT_BASE_DIR"),
+        _X("DOTNET_DEPS_CACHE"),
+        _X("DOTNET_DEPS_DOM_LOADER"),
+        _X("DOTNET_DEPS_PARALLEL_PARSING"),
+        _X("DOTNET_DISABLE_DEPS_HANDOFF"),
+        _X("DOTNET_DISABLE_GUI_ERRORS"),
+        _X("DOTNET_INSTALL_INDEX"),
+        _X("DOTNET_MULTILEVEL_LOOKUP"),
+        _X("DOTNET_ROLL_FORWARD"),
+        _X("DOTNET_ROLL_FORWARD_ON_NO_CANDIDATE_FX"),
+        _X("DOTNET_ROLL_FORWARD_TO_PRERELEASE"),
+        _X("DOTNET_RUNTIME_ID"),
+        _X("DOTNET_SHARED_STORE"),
+        _X("DOTNET_STARTUP_CACHE"),
+        _X("DOTNET_STARTUP_HOOKS"),
+    };
+
+    static_assert(sizeof(env_names) / sizeof(env_names[0]) == static_cast<size_t>(env_key_t::__Last), "Invalid env_names - not all env_key_t values are covered");
+
+    struct env_value_t
+    {
+        bool is_set;
+        bool is_enabled;
+        pal::string_t value;
+    };
+
+    typedef std::array<env_value_t, static_cast<size_t>(env_key_t::__Last)> env_values_t;
+
+    pal::mutex_t g_snapshot_lock;
+    bool g_captured = false;
+    env_values_t g_values;
+
+    void read_values(env_values_t* values)
+    {
+        for (size_t i = 0; i < values->size(); ++i)
+        {
+            env_value_t& value = (*values)[i];
+            value.is_set = pal::getenv(env_names[i], &value.value);
+            value.is_enabled = value.is_set && pal::xtoi(value.value.c_str()) == 1;
+        }
+    }
+
+    // The snapshot is captured on first use in case a module reads a variable before its entry point set up tracing
+    void ensure_captured()
+    {
+        if (!g_captured)
+        {
+            read_values(&g_values);
+            g_captured = true;
+        }
+    }
+}
+
+void env_snapshot::capture()
+{
+    env_values_t values;
+    read_values(&values);
+
+    std::lock_guard<pal::mutex_t> lock(g_snapshot_lock);
+    g_values.swap(values);
+    g_captured = true;
+}
+
+bool env_snapshot::get(env_key_t key, pal::string_t* recv)
+{
+    std::lock_guard<pal::mutex_t> lock(g_snapshot_lock);
+    ensure_captured();
+
+    const env_value_t& value = g_values[static_cast<size_t>(key)];
+    if (!value.is_set)
+    {
+        recv->clear();
+        return false;
+    }
+
+    recv->assign(value.value);
+    return true;
+}
+
+bool env_snapshot::is_enabled(env_key_t key)
+{
+    std::lock_guard<pal::mutex_t> lock(g_snapshot_lock);
+    ensure_captured();
+
+    return g_values[static_cast<size_t>(key)].is_enabled;
+}
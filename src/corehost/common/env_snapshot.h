@@ -0,0 +1,58 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#ifndef __ENV_SNAPSHOT_H__
+#define __ENV_SNAPSHOT_H__
+
+#include "pal.h"
+
+// Environment variables which configure the hosts
+enum class env_key_t
+{
+    COREHOST_TRACE,
+    COREHOST_TRACEFILE,
+    COREHOST_TRACE_VERBOSITY,
+    CORE_BREADCRUMBS,
+    CORE_SERVICING,
+    DOTNET_ADDITIONAL_DEPS,
+    DOTNET_BUNDLE_EXTRACT_BASE_DIR,
+    DOTNET_DEPS_CACHE,
+    DOTNET_DEPS_DOM_LOADER,
+    DOTNET_DEPS_PARALLEL_PARSING,
+    DOTNET_DISABLE_DEPS_HANDOFF,
+    DOTNET_DISABLE_GUI_ERRORS,
+    DOTNET_INSTALL_INDEX,
+    DOTNET_MULTILEVEL_LOOKUP,
+    DOTNET_ROLL_FORWARD,
+    DOTNET_ROLL_FORWARD_ON_NO_CANDIDATE_FX,
+    DOTNET_ROLL_FORWARD_TO_PRERELEASE,
+    DOTNET_RUNTIME_ID,
+    DOTNET_SHARED_STORE,
+    DOTNET_STARTUP_CACHE,
+    DOTNET_STARTUP_HOOKS,
+
+    __Last // Sentinel value
+};
+
+// Snapshot of the environment variables in env_key_t, so that each of them is read from the
+// environment once per host entry rather than every time a setting is checked.
+//
+// The snapshot is captured by trace::setup, which every entry point of every host calls first.
+// Each module (hostfxr, hostpolicy, ...) has its own snapshot. It is captured again on each entry,
+// since a process which hosts the runtime can change its environment between calls.
+//
+// Variables which are only used for testing are read with test_only_getenv and are not part of the snapshot.
+namespace env_snapshot
+{
+    // Reads all of the variables from the environment
+    void capture();
+
+    // Same as pal::getenv, but reads the value from the snapshot
+    bool get(env_key_t key, pal::string_t* recv);
+
+    // True if the variable is set to 1, which is how the opt-in settings are enabled
+    bool is_enabled(env_key_t key);
+}
+
+#endif // __ENV_SNAPSHOT_H__
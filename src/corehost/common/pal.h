@@ -19,6 +19,7 @@
 #include <memory>
 #include <algorithm>
 #include <cassert>
+#include <functional>
 
 #if defined(_WIN32)
 
@@ -255,10 +256,46 @@ namespace pal
     }
 
     void* map_file_readonly(const string_t& path, size_t& length);
+    // Maps the file as a private copy-on-write view: writes are never flushed back to the file.
+    void* mmap_copy_on_write(const string_t& path, size_t* length = nullptr);
     bool touch_file(const string_t& path);
     bool realpath(string_t* path, bool skip_error_logging = false);
+
+    // Same as realpath, but remembers the canonical form of the directories which were resolved, so that
+    // resolving another file in one of them only checks the file itself. The directories are remembered
+    // until clear_realpath_cache is called, which the hosts do on each entry.
+    bool realpath_cached(string_t* path, bool skip_error_logging = false);
+    void clear_realpath_cache();
+    void trace_realpath_cache_stats();
+
     bool file_exists(const string_t& path);
+
+    // Size and last write time of a file or directory. The time is in platform specific
+    // units and is only meant to be compared against other stamps of the same path, or
+    // against get_file_time_now.
+    struct file_stamp_t
+    {
+        uint64_t size;
+        int64_t last_write_time;
+
+        bool operator==(const file_stamp_t& other) const { return size == other.size && last_write_time == other.last_write_time; }
+        bool operator!=(const file_stamp_t& other) const { return !(*this == other); }
+    };
+    bool get_file_stamp(const string_t& path, file_stamp_t* stamp);
+
+    // The current time and a number of seconds, in the units of file_stamp_t::last_write_time
+    int64_t get_file_time_now();
+    int64_t file_time_from_seconds(int64_t seconds);
+
     inline bool directory_exists(const string_t& path) { return file_exists(path); }
+
+    // Called with the name of each entry by enumerate_dir. The name is only valid during the call.
+    typedef std::function<void(const char_t* name)> dir_entry_callback_t;
+
+    // Passes the names of the files and directories (or only of the directories) in the directory which match
+    // the pattern to on_entry, as they are read, without collecting them first. The "." and ".." entries are skipped.
+    void enumerate_dir(const string_t& path, const string_t& pattern, bool onlydirectories, const dir_entry_callback_t& on_entry);
+
     void readdir(const string_t& path, const string_t& pattern, std::vector<string_t>* list);
     void readdir(const string_t& path, std::vector<string_t>* list);
     void readdir_onlydirectories(const string_t& path, const string_t& pattern, std::vector<string_t>* list);
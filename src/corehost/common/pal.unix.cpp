@@ -3,6 +3,7 @@
 // See the LICENSE file in the project root for more information.
 
 #include "pal.h"
+#include "env_snapshot.h"
 #include "utils.h"
 #include "trace.h"
 
@@ -14,6 +15,10 @@
 #include <fnmatch.h>
 #include <ctime>
 
+#if defined(__LINUX__)
+#include <sys/syscall.h>
+#endif
+
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
 #include <sys/param.h>
@@ -57,35 +62,53 @@ bool pal::touch_file(const pal::string_t& path)
     return true;
 }
 
-void* pal::map_file_readonly(const pal::string_t& path, size_t& length)
+namespace
 {
-    int fd = open(path.c_str(), O_RDONLY, (S_IRUSR | S_IRGRP | S_IROTH));
-    if (fd == -1)
+    void* map_file(const pal::string_t& path, size_t* length, int prot, int flags)
     {
-        trace::warning(_X("Failed to map file. open(%s) failed with error %d"), path.c_str(), errno);
-        return nullptr;
-    }
+        int fd = open(path.c_str(), O_RDONLY, (S_IRUSR | S_IRGRP | S_IROTH));
+        if (fd == -1)
+        {
+            trace::warning(_X("Failed to map file. open(%s) failed with error %d"), path.c_str(), errno);
+            return nullptr;
+        }
 
-    struct stat buf;
-    if (fstat(fd, &buf) != 0)
-    {
-        trace::warning(_X("Failed to map file. fstat(%s) failed with error %d"), path.c_str(), errno);
-        close(fd);
-        return nullptr;
-    }
+        struct stat buf;
+        if (fstat(fd, &buf) != 0)
+        {
+            trace::warning(_X("Failed to map file. fstat(%s) failed with error %d"), path.c_str(), errno);
+            close(fd);
+            return nullptr;
+        }
 
-    length = buf.st_size;
-    void* address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        size_t size = buf.st_size;
+        void* address = mmap(nullptr, size, prot, flags, fd, 0);
+
+        if (address == MAP_FAILED)
+        {
+            trace::warning(_X("Failed to map file. mmap(%s) failed with error %d"), path.c_str(), errno);
+            close(fd);
+            return nullptr;
+        }
+
+        if (length != nullptr)
+        {
+            *length = size;
+        }
 
-    if(address == nullptr)
-    {
-        trace::warning(_X("Failed to map file. mmap(%s) failed with error %d"), path.c_str(), errno);
         close(fd);
-        return nullptr;
+        return address;
     }
+}
 
-    close(fd);
-    return address;
+void* pal::map_file_readonly(const pal::string_t& path, size_t& length)
+{
+    return map_file(path, &length, PROT_READ, MAP_SHARED);
+}
+
+void* pal::mmap_copy_on_write(const pal::string_t& path, size_t* length)
+{
+    return map_file(path, length, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 }
 
 bool pal::getcwd(pal::string_t* recv)
@@ -236,7 +259,7 @@ bool pal::get_default_breadcrumb_store(string_t* recv)
 {
     recv->clear();
     pal::string_t ext;
-    if (pal::getenv(_X("CORE_BREADCRUMBS"), &ext) && pal::realpath(&ext))
+    if (env_snapshot::get(env_key_t::CORE_BREADCRUMBS, &ext) && pal::realpath(&ext))
     {
         // We should have the path in ext.
         trace::info(_X("Realpath CORE_BREADCRUMBS [%s]"), ext.c_str());
@@ -268,7 +291,7 @@ bool pal::get_default_servicing_directory(string_t* recv)
 {
     recv->clear();
     pal::string_t ext;
-    if (pal::getenv(_X("CORE_SERVICING"), &ext) && pal::realpath(&ext))
+    if (env_snapshot::get(env_key_t::CORE_SERVICING, &ext) && pal::realpath(&ext))
     {
         // We should have the path in ext.
         trace::info(_X("Realpath CORE_SERVICING [%s]"), ext.c_str());
@@ -779,101 +802,395 @@ bool pal::realpath(pal::string_t* path, bool skip_error_logging)
     return true;
 }
 
+namespace
+{
+    // Canonical forms of the directories resolved by realpath_cached
+    pal::mutex_t g_realpath_cache_lock;
+    std::unordered_map<pal::string_t, pal::string_t> g_realpath_dirs;
+    size_t g_realpath_dir_hits = 0;
+    size_t g_realpath_dir_misses = 0;
+    size_t g_realpath_uncached = 0;
+
+    // Returns the position of the file name if the path is an absolute path to a file in a directory,
+    // without any empty, . or .. components. Other paths are resolved by realpath directly.
+    size_t get_cacheable_file_name_pos(const pal::string_t& path)
+    {
+        if (path.empty() || path[0] != '/')
+        {
+            return pal::string_t::npos;
+        }
+
+        size_t pos = 0;
+        while (pos < path.length())
+        {
+            size_t next = path.find('/', pos + 1);
+            size_t length = (next == pal::string_t::npos ? path.length() : next) - pos - 1;
+            const pal::char_t* component = path.c_str() + pos + 1;
+            if (length == 0
+                || (length == 1 && component[0] == '.')
+                || (length == 2 && component[0] == '.' && component[1] == '.'))
+            {
+                return pal::string_t::npos;
+            }
+
+            if (next == pal::string_t::npos)
+            {
+                // Files directly in the root are rare enough not to be worth the special case
+                return pos == 0 ? pal::string_t::npos : pos + 1;
+            }
+
+            pos = next;
+        }
+
+        return pal::string_t::npos;
+    }
+
+    bool realpath_uncached(pal::string_t* path, bool skip_error_logging)
+    {
+        {
+            std::lock_guard<pal::mutex_t> lock(g_realpath_cache_lock);
+            g_realpath_uncached++;
+        }
+
+        return pal::realpath(path, skip_error_logging);
+    }
+}
+
+bool pal::realpath_cached(pal::string_t* path, bool skip_error_logging)
+{
+    size_t file_name_pos = get_cacheable_file_name_pos(*path);
+    if (file_name_pos == pal::string_t::npos)
+    {
+        return realpath_uncached(path, skip_error_logging);
+    }
+
+    pal::string_t dir = path->substr(0, file_name_pos - 1);
+    pal::string_t resolved;
+    bool found;
+    {
+        std::lock_guard<pal::mutex_t> lock(g_realpath_cache_lock);
+        auto existing = g_realpath_dirs.find(dir);
+        found = existing != g_realpath_dirs.end();
+        if (found)
+        {
+            resolved = existing->second;
+            g_realpath_dir_hits++;
+        }
+    }
+
+    if (!found)
+    {
+        resolved = dir;
+        if (!pal::realpath(&resolved, true))
+        {
+            // Let realpath report the failure for the whole path
+            return realpath_uncached(path, skip_error_logging);
+        }
+
+        std::lock_guard<pal::mutex_t> lock(g_realpath_cache_lock);
+        g_realpath_dirs[dir] = resolved;
+        g_realpath_dir_misses++;
+    }
+
+    if (resolved.back() != '/')
+    {
+        resolved.push_back('/');
+    }
+
+    resolved.append(*path, file_name_pos, pal::string_t::npos);
+
+    // Only the file itself needs to be checked now. If it is a symlink, it is left to realpath to follow it.
+    struct stat buf;
+    if (::lstat(resolved.c_str(), &buf) != 0)
+    {
+        if (errno == ENOENT)
+        {
+            return false;
+        }
+
+        return realpath_uncached(path, skip_error_logging);
+    }
+
+    if (S_ISLNK(buf.st_mode))
+    {
+        return realpath_uncached(path, skip_error_logging);
+    }
+
+    path->swap(resolved);
+    return true;
+}
+
+void pal::clear_realpath_cache()
+{
+    std::lock_guard<pal::mutex_t> lock(g_realpath_cache_lock);
+    g_realpath_dirs.clear();
+    g_realpath_dir_hits = 0;
+    g_realpath_dir_misses = 0;
+    g_realpath_uncached = 0;
+}
+
+void pal::trace_realpath_cache_stats()
+{
+    if (!trace::is_enabled())
+    {
+        return;
+    }
+
+    std::lock_guard<pal::mutex_t> lock(g_realpath_cache_lock);
+    trace::verbose(_X("Resolved paths: %zu with a cached directory, %zu with a new directory, %zu without the cache"),
+        g_realpath_dir_hits, g_realpath_dir_misses, g_realpath_uncached);
+}
+
 bool pal::file_exists(const pal::string_t& path)
 {
     return (::access(path.c_str(), F_OK) == 0);
 }
 
-static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+bool pal::get_file_stamp(const pal::string_t& path, pal::file_stamp_t* stamp)
+{
+    struct stat buf;
+    if (::stat(path.c_str(), &buf) != 0)
+    {
+        return false;
+    }
+
+    stamp->size = static_cast<uint64_t>(buf.st_size);
+#if defined(__APPLE__)
+    stamp->last_write_time = static_cast<int64_t>(buf.st_mtimespec.tv_sec) * 1000000000 + buf.st_mtimespec.tv_nsec;
+#else
+    stamp->last_write_time = static_cast<int64_t>(buf.st_mtim.tv_sec) * 1000000000 + buf.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+int64_t pal::get_file_time_now()
 {
-    assert(list != nullptr);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
 
-    std::vector<pal::string_t>& files = *list;
+int64_t pal::file_time_from_seconds(int64_t seconds)
+{
+    return seconds * 1000000000;
+}
 
-    auto dir = opendir(path.c_str());
-    if (dir != nullptr)
+namespace
+{
+    // Matches entry names against a pattern. The "*" pattern and "*<suffix>" patterns, which are the
+    // only ones the hosts use, are matched without fnmatch.
+    class name_matcher_t
     {
-        struct dirent* entry = nullptr;
-        while ((entry = readdir(dir)) != nullptr)
+    public:
+        name_matcher_t(const pal::string_t& pattern)
+            : m_pattern(pattern)
+            , m_match_all(pattern == _X("*"))
+            , m_match_suffix(false)
         {
-            if (fnmatch(pattern.c_str(), entry->d_name, FNM_PATHNAME) != 0)
+            if (!m_match_all && pattern.length() > 1 && pattern[0] == '*'
+                && pattern.find_first_of(_X("*?[\\"), 1) == pal::string_t::npos)
             {
-                continue;
+                m_match_suffix = true;
+                m_suffix = pattern.c_str() + 1;
+                m_suffix_length = pattern.length() - 1;
             }
+        }
+
+        bool matches(const char* name) const
+        {
+            if (m_match_all)
+            {
+                return true;
+            }
+
+            if (m_match_suffix)
+            {
+                size_t length = strlen(name);
+                return length >= m_suffix_length && memcmp(name + length - m_suffix_length, m_suffix, m_suffix_length) == 0;
+            }
+
+            return fnmatch(m_pattern.c_str(), name, FNM_PATHNAME) == 0;
+        }
+
+    private:
+        const pal::string_t& m_pattern;
+        bool m_match_all;
+        bool m_match_suffix;
+        const char* m_suffix;
+        size_t m_suffix_length;
+    };
+
+    enum class entry_kind_t
+    {
+        skip,
+        file,
+        directory,
+        unknown // Needs a stat to tell
+    };
+
+    entry_kind_t get_entry_kind(const char* name, unsigned char type, bool onlydirectories)
+    {
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        {
+            return entry_kind_t::skip;
+        }
+
+        switch (type)
+        {
+        case DT_DIR:
+            return entry_kind_t::directory;
+
+        case DT_REG:
+            return onlydirectories ? entry_kind_t::skip : entry_kind_t::file;
+
+        // Symlinks and file systems that do not support d_type
+        case DT_LNK:
+        case DT_UNKNOWN:
+            return entry_kind_t::unknown;
+
+        default:
+            return entry_kind_t::skip;
+        }
+    }
+
+    // Stats an entry whose kind wasn't known from the listing to tell whether it is wanted. This is done
+    // right when the entry is listed, so that the entries are passed on in the order they are listed.
+    bool is_unknown_entry_wanted(int dir_fd, const char* name, bool onlydirectories)
+    {
+        struct stat sb;
+        if (fstatat(dir_fd, name, &sb, 0) == -1)
+        {
+            return false;
+        }
+
+        return S_ISDIR(sb.st_mode) || (!onlydirectories && S_ISREG(sb.st_mode));
+    }
+
+#if defined(__LINUX__)
+    // Layout of the entries returned by getdents64
+    struct linux_dirent64_t
+    {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    // Reads the directory entries straight into a large buffer, which takes fewer system calls than
+    // readdir for large directories and hands out the names without copying them.
+    void enumerate_entries(int dir_fd, const name_matcher_t& matcher, bool onlydirectories, const pal::dir_entry_callback_t& on_entry)
+    {
+        const size_t buffer_size = 32 * 1024;
+        std::unique_ptr<char[]> buffer(new char[buffer_size]);
 
-            // We are interested in files only
-            switch (entry->d_type)
+        while (true)
+        {
+            long read = syscall(SYS_getdents64, dir_fd, buffer.get(), buffer_size);
+            if (read <= 0)
             {
-            case DT_DIR:
                 break;
+            }
+
+            for (long pos = 0; pos < read;)
+            {
+                const linux_dirent64_t* entry = reinterpret_cast<const linux_dirent64_t*>(buffer.get() + pos);
+                pos += entry->d_reclen;
 
-            case DT_REG:
-                if (onlydirectories)
+                entry_kind_t kind = get_entry_kind(entry->d_name, entry->d_type, onlydirectories);
+                if (kind == entry_kind_t::skip || !matcher.matches(entry->d_name))
                 {
                     continue;
                 }
-                break;
 
-            // Handle symlinks and file systems that do not support d_type
-            case DT_LNK:
-            case DT_UNKNOWN:
+                if (kind == entry_kind_t::unknown && !is_unknown_entry_wanted(dir_fd, entry->d_name, onlydirectories))
                 {
-                    struct stat sb;
+                    continue;
+                }
 
-                    if (fstatat(dirfd(dir), entry->d_name, &sb, 0) == -1)
-                    {
-                        continue;
-                    }
+                on_entry(entry->d_name);
+            }
+        }
+    }
+#else
+    void enumerate_entries(int dir_fd, const name_matcher_t& matcher, bool onlydirectories, const pal::dir_entry_callback_t& on_entry)
+    {
+        // fdopendir takes over the descriptor, so it gets its own
+        int own_fd = dup(dir_fd);
+        DIR* dir = own_fd == -1 ? nullptr : fdopendir(own_fd);
+        if (dir == nullptr)
+        {
+            if (own_fd != -1)
+            {
+                close(own_fd);
+            }
 
-                    if (onlydirectories)
-                    {
-                        if (!S_ISDIR(sb.st_mode))
-                        {
-                            continue;
-                        }
-                        break;
-                    }
-                    else if (!S_ISREG(sb.st_mode) && !S_ISDIR(sb.st_mode))
-                    {
-                        continue;
-                    }
-                }
-                break;
+            return;
+        }
 
-            default:
+        struct dirent* entry = nullptr;
+        while ((entry = ::readdir(dir)) != nullptr)
+        {
+            entry_kind_t kind = get_entry_kind(entry->d_name, entry->d_type, onlydirectories);
+            if (kind == entry_kind_t::skip || !matcher.matches(entry->d_name))
+            {
                 continue;
             }
 
-            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            if (kind == entry_kind_t::unknown && !is_unknown_entry_wanted(dir_fd, entry->d_name, onlydirectories))
             {
                 continue;
             }
 
-            files.emplace_back(entry->d_name);
+            on_entry(entry->d_name);
         }
 
         closedir(dir);
     }
+#endif
+
+    void read_dir_names(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+    {
+        assert(list != nullptr);
+
+        pal::enumerate_dir(path, pattern, onlydirectories, [list](const pal::char_t* name)
+        {
+            list->emplace_back(name);
+        });
+    }
+}
+
+void pal::enumerate_dir(const string_t& path, const string_t& pattern, bool onlydirectories, const dir_entry_callback_t& on_entry)
+{
+    int dir_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1)
+    {
+        return;
+    }
+
+    name_matcher_t matcher(pattern);
+    enumerate_entries(dir_fd, matcher, onlydirectories, on_entry);
+    close(dir_fd);
 }
 
 void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
 {
-    ::readdir(path, pattern, false, list);
+    read_dir_names(path, pattern, false, list);
 }
 
 void pal::readdir(const pal::string_t& path, std::vector<pal::string_t>* list)
 {
-    ::readdir(path, _X("*"), false, list);
+    read_dir_names(path, _X("*"), false, list);
 }
 
 void pal::readdir_onlydirectories(const pal::string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
 {
-    ::readdir(path, pattern, true, list);
+    read_dir_names(path, pattern, true, list);
 }
 
 void pal::readdir_onlydirectories(const pal::string_t& path, std::vector<pal::string_t>* list)
 {
-    ::readdir(path, _X("*"), true, list);
+    read_dir_names(path, _X("*"), true, list);
 }
 
 bool pal::is_running_in_wow64()
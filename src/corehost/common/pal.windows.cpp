@@ -76,44 +76,63 @@ bool pal::touch_file(const pal::string_t& path)
     return true;
 }
 
-void* pal::map_file_readonly(const pal::string_t& path, size_t &length)
+namespace
 {
-    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-
-    if (file == INVALID_HANDLE_VALUE)
+    void* map_file(const pal::string_t& path, size_t* length, DWORD mapping_protect, DWORD view_desired_access)
     {
-        trace::warning(_X("Failed to map file. CreateFileW(%s) failed with error %d"), path.c_str(), GetLastError());
-        return nullptr;
-    }
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 
-    LARGE_INTEGER fileSize;
-    if (GetFileSizeEx(file, &fileSize) == 0)
-    {
-        trace::warning(_X("Failed to map file. GetFileSizeEx(%s) failed with error %d"), path.c_str(), GetLastError());
-        CloseHandle(file);
-        return nullptr;
-    }
-    length = (size_t)fileSize.QuadPart;
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            trace::warning(_X("Failed to map file. CreateFileW(%s) failed with error %d"), path.c_str(), GetLastError());
+            return nullptr;
+        }
 
-    HANDLE map = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (length != nullptr)
+        {
+            LARGE_INTEGER fileSize;
+            if (GetFileSizeEx(file, &fileSize) == 0)
+            {
+                trace::warning(_X("Failed to map file. GetFileSizeEx(%s) failed with error %d"), path.c_str(), GetLastError());
+                CloseHandle(file);
+                return nullptr;
+            }
+            *length = (size_t)fileSize.QuadPart;
+        }
 
-    if (map == NULL)
-    {
-        trace::warning(_X("Failed to map file. CreateFileMappingW(%s) failed with error %d"), path.c_str(), GetLastError());
-        CloseHandle(file);
-        return nullptr;
-    }
+        HANDLE map = CreateFileMappingW(file, NULL, mapping_protect, 0, 0, NULL);
 
-    void *address = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+        if (map == NULL)
+        {
+            trace::warning(_X("Failed to map file. CreateFileMappingW(%s) failed with error %d"), path.c_str(), GetLastError());
+            CloseHandle(file);
+            return nullptr;
+        }
 
-    if (map == NULL)
-    {
-        trace::warning(_X("Failed to map file. MapViewOfFile(%s) failed with error %d"), path.c_str(), GetLastError());
+        void *address = MapViewOfFile(map, view_desired_access, 0, 0, 0);
+
+        if (address == NULL)
+        {
+            trace::warning(_X("Failed to map file. MapViewOfFile(%s) failed with error %d"), path.c_str(), GetLastError());
+        }
+
+        // The file-handle (file) and mapping object handle (map) can be safely closed
+        // once the file is mapped. The OS keeps the file open if there is an open mapping into the file.
+        CloseHandle(map);
         CloseHandle(file);
-        return nullptr;
+
+        return address;
     }
+}
 
-    return address;
+void* pal::map_file_readonly(const pal::string_t& path, size_t &length)
+{
+    return map_file(path, &length, PAGE_READONLY, FILE_MAP_READ);
+}
+
+void* pal::mmap_copy_on_write(const pal::string_t& path, size_t* length)
+{
+    return map_file(path, length, PAGE_WRITECOPY, FILE_MAP_COPY);
 }
 
 bool pal::getcwd(pal::string_t* recv)
@@ -674,6 +693,20 @@ bool pal::realpath(string_t* path, bool skip_error_logging)
     return false;
 }
 
+// Windows paths are not resolved component by component, so there is nothing to cache
+bool pal::realpath_cached(string_t* path, bool skip_error_logging)
+{
+    return pal::realpath(path, skip_error_logging);
+}
+
+void pal::clear_realpath_cache()
+{
+}
+
+void pal::trace_realpath_cache_stats()
+{
+}
+
 bool pal::file_exists(const string_t& path)
 {
     if (path.empty())
@@ -685,11 +718,42 @@ bool pal::file_exists(const string_t& path)
     return pal::realpath(&tmp, true);
 }
 
-static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+bool pal::get_file_stamp(const string_t& path, pal::file_stamp_t* stamp)
 {
-    assert(list != nullptr);
+    pal::string_t normalized_path(path);
+    if (LongFile::ShouldNormalize(normalized_path))
+    {
+        if (!pal::realpath(&normalized_path, true))
+        {
+            return false;
+        }
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!::GetFileAttributesExW(normalized_path.c_str(), GetFileExInfoStandard, &data))
+    {
+        return false;
+    }
 
-    std::vector<pal::string_t>& files = *list;
+    stamp->size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    stamp->last_write_time = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime);
+    return true;
+}
+
+int64_t pal::get_file_time_now()
+{
+    FILETIME now;
+    ::GetSystemTimeAsFileTime(&now);
+    return static_cast<int64_t>((static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime);
+}
+
+int64_t pal::file_time_from_seconds(int64_t seconds)
+{
+    return seconds * 10000000;
+}
+
+void pal::enumerate_dir(const string_t& path, const string_t& pattern, bool onlydirectories, const dir_entry_callback_t& on_entry)
+{
     pal::string_t normalized_path(path);
 
     if (LongFile::ShouldNormalize(normalized_path))
@@ -714,16 +778,25 @@ static void readdir(const pal::string_t& path, const pal::string_t& pattern, boo
     {
         if (!onlydirectories || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
         {
-            pal::string_t filepath(data.cFileName);
-            if (filepath != _X(".") && filepath != _X(".."))
+            if (wcscmp(data.cFileName, _X(".")) != 0 && wcscmp(data.cFileName, _X("..")) != 0)
             {
-                files.push_back(filepath);
+                on_entry(data.cFileName);
             }
         }
     } while (::FindNextFileW(handle, &data));
     ::FindClose(handle);
 }
 
+static void readdir(const pal::string_t& path, const pal::string_t& pattern, bool onlydirectories, std::vector<pal::string_t>* list)
+{
+    assert(list != nullptr);
+
+    pal::enumerate_dir(path, pattern, onlydirectories, [list](const pal::char_t* name)
+    {
+        list->push_back(name);
+    });
+}
+
 void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
 {
     ::readdir(path, pattern, false, list);
@@ -3,6 +3,7 @@
 // See the LICENSE file in the project root for more information.
 
 #include "trace.h"
+#include "env_snapshot.h"
 #include <mutex>
 
 // g_trace_verbosity is used to encode COREHOST_TRACE and COREHOST_TRACE_VERBOSITY to selectively control output of
@@ -16,15 +17,49 @@ static int g_trace_verbosity = 0;
 static FILE * g_trace_file = stderr;
 static pal::mutex_t g_trace_mutex;
 thread_local static trace::error_writer_fn g_error_writer = nullptr;
+thread_local static trace::buffer_t* g_buffer = nullptr;
+
+namespace
+{
+    // Appends the message to the buffer of the current thread, if there is one.
+    bool try_buffer(bool is_error, const pal::char_t* format, va_list args)
+    {
+        if (g_buffer == nullptr)
+        {
+            return false;
+        }
+
+        va_list dup_args;
+        va_copy(dup_args, args);
+        int count = pal::str_vprintf(nullptr, 0, format, args) + 1;
+        std::vector<pal::char_t> buffer(count);
+        pal::str_vprintf(&buffer[0], count, format, dup_args);
+        va_end(dup_args);
+
+        g_buffer->push_back({ is_error, pal::string_t(buffer.data()) });
+        return true;
+    }
+
+    void write_to_trace_file(const pal::char_t* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        pal::file_vprintf(g_trace_file, format, args);
+        va_end(args);
+    }
+}
 
 //
 // Turn on tracing for the corehost based on "COREHOST_TRACE" & "COREHOST_TRACEFILE" env.
 //
 void trace::setup()
 {
+    // Every host entry point sets up tracing first, so this is where the environment is read
+    env_snapshot::capture();
+
     // Read trace environment variable
     pal::string_t trace_str;
-    if (!pal::getenv(_X("COREHOST_TRACE"), &trace_str))
+    if (!env_snapshot::get(env_key_t::COREHOST_TRACE, &trace_str))
     {
         return;
     }
@@ -54,7 +89,7 @@ bool trace::enable()
         std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
 
         g_trace_file = stderr;
-        if (pal::getenv(_X("COREHOST_TRACEFILE"), &tracefile_str))
+        if (env_snapshot::get(env_key_t::COREHOST_TRACEFILE, &tracefile_str))
         {
             FILE *tracefile = pal::file_open(tracefile_str, _X("a"));
 
@@ -69,7 +104,7 @@ bool trace::enable()
         }
 
         pal::string_t trace_str;
-        if (!pal::getenv(_X("COREHOST_TRACE_VERBOSITY"), &trace_str))
+        if (!env_snapshot::get(env_key_t::COREHOST_TRACE_VERBOSITY, &trace_str))
         {
             g_trace_verbosity = 4;  // Verbose trace by default
         }
@@ -91,15 +126,27 @@ bool trace::is_enabled()
     return g_trace_verbosity;
 }
 
+bool trace::is_verbose_enabled()
+{
+    return g_trace_verbosity > 3;
+}
+
+bool trace::is_info_enabled()
+{
+    return g_trace_verbosity > 2;
+}
+
 void trace::verbose(const pal::char_t* format, ...)
 {
     if (g_trace_verbosity > 3)
     {
-        std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
-
         va_list args;
         va_start(args, format);
-        pal::file_vprintf(g_trace_file, format, args);
+        if (!try_buffer(false, format, args))
+        {
+            std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
+            pal::file_vprintf(g_trace_file, format, args);
+        }
         va_end(args);
     }
 }
@@ -108,22 +155,30 @@ void trace::info(const pal::char_t* format, ...)
 {
     if (g_trace_verbosity > 2)
     {
-        std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
-
         va_list args;
         va_start(args, format);
-        pal::file_vprintf(g_trace_file, format, args);
+        if (!try_buffer(false, format, args))
+        {
+            std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
+            pal::file_vprintf(g_trace_file, format, args);
+        }
         va_end(args);
     }
 }
 
 void trace::error(const pal::char_t* format, ...)
 {
+    va_list args;
+    va_start(args, format);
+    if (try_buffer(true, format, args))
+    {
+        va_end(args);
+        return;
+    }
+
     std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
 
     // Always print errors
-    va_list args;
-    va_start(args, format);
 
     va_list trace_args;
     va_copy(trace_args, args);
@@ -173,11 +228,13 @@ void trace::warning(const pal::char_t* format, ...)
 {
     if (g_trace_verbosity > 1)
     {
-        std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
-
         va_list args;
         va_start(args, format);
-        pal::file_vprintf(g_trace_file, format, args);
+        if (!try_buffer(false, format, args))
+        {
+            std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
+            pal::file_vprintf(g_trace_file, format, args);
+        }
         va_end(args);
     }
 }
@@ -204,3 +261,32 @@ trace::error_writer_fn trace::get_error_writer()
     // No need for locking since g_error_writer is thread local.
     return g_error_writer;
 }
+
+trace::buffer_t* trace::set_buffer(trace::buffer_t* buffer)
+{
+    // No need for locking since g_buffer is thread local.
+    buffer_t* previous_buffer = g_buffer;
+    g_buffer = buffer;
+    return previous_buffer;
+}
+
+void trace::write_buffer(const trace::buffer_t& buffer)
+{
+    // The messages have been filtered by verbosity when they were buffered.
+    for (const buffered_message_t& message : buffer)
+    {
+        if (message.is_error)
+        {
+            trace::error(_X("%s"), message.message.c_str());
+        }
+        else if (g_buffer != nullptr)
+        {
+            g_buffer->push_back(message);
+        }
+        else
+        {
+            std::lock_guard<pal::mutex_t> lock(g_trace_mutex);
+            write_to_trace_file(_X("%s"), message.message.c_str());
+        }
+    }
+}
@@ -6,12 +6,15 @@
 #define TRACE_H
 
 #include "pal.h"
+#include <vector>
 
 namespace trace
 {
     void setup();
     bool enable();
     bool is_enabled();
+    bool is_verbose_enabled();
+    bool is_info_enabled();
     void verbose(const pal::char_t* format, ...);
     void info(const pal::char_t* format, ...);
     void warning(const pal::char_t* format, ...);
@@ -31,6 +34,33 @@ namespace trace
 
     // Returns the currently set callback for error writing
     error_writer_fn get_error_writer();
+
+    struct buffered_message_t
+    {
+        bool is_error;
+        pal::string_t message;
+    };
+
+    typedef std::vector<buffered_message_t> buffer_t;
+
+    // Sets a buffer which collects all the messages (including errors) traced on the current thread
+    // instead of writing them out, until it is reset to null. This allows work done on multiple threads
+    // to be traced in a deterministic order.
+    // The setting is per-thread (thread local), just like the error writer.
+    // The function returns the previously registered buffer for the current thread (or null)
+    buffer_t* set_buffer(buffer_t* buffer);
+
+    // Writes out the messages collected in the buffer, as if they were traced on the current thread.
+    void write_buffer(const buffer_t& buffer);
 };
 
+// Variants of trace::verbose and trace::info which check the verbosity before evaluating any of
+// their arguments. Use them on paths which run for every asset or deps entry, where the arguments
+// are costly to compute (e.g. fx_ver_t::as_str()) and tracing is almost always disabled.
+#define TRACE_VERBOSE(...) \
+    do { if (trace::is_verbose_enabled()) { trace::verbose(__VA_ARGS__); } } while (0)
+
+#define TRACE_INFO(...) \
+    do { if (trace::is_info_enabled()) { trace::info(__VA_ARGS__); } } while (0)
+
 #endif // TRACE_H
@@ -4,6 +4,8 @@
 
 #include "utils.h"
 #include "trace.h"
+#include "env_snapshot.h"
+#include <climits>
 
 bool library_exists_in_dir(const pal::string_t& lib_dir, const pal::string_t& lib_name, pal::string_t* p_lib_path)
 {
@@ -203,10 +205,14 @@ const pal::char_t* get_arch()
 pal::string_t get_current_runtime_id(bool use_fallback)
 {
     pal::string_t rid;
-    if (pal::getenv(_X("DOTNET_RUNTIME_ID"), &rid))
+    if (env_snapshot::get(env_key_t::DOTNET_RUNTIME_ID, &rid))
         return rid;
 
-    rid = pal::get_current_os_rid_platform();
+    // The OS doesn't change while the process runs, so it is only looked up once. On Linux that reads
+    // and parses /etc/os-release, and the RID is needed for every deps file which is loaded.
+    static const pal::string_t os_rid = pal::get_current_os_rid_platform();
+
+    rid = os_rid;
     if (rid.empty() && use_fallback)
         rid = pal::get_current_os_fallback_rid();
 
@@ -222,7 +228,7 @@ pal::string_t get_current_runtime_id(bool use_fallback)
 bool get_env_shared_store_dirs(std::vector<pal::string_t>* dirs, const pal::string_t& arch, const pal::string_t& tfm)
 {
     pal::string_t path;
-    if (!pal::getenv(_X("DOTNET_SHARED_STORE"), &path))
+    if (!env_snapshot::get(env_key_t::DOTNET_SHARED_STORE, &path))
     {
         return false;
     }
@@ -268,7 +274,7 @@ bool multilevel_lookup_enabled()
     pal::string_t env_lookup;
     bool multilevel_lookup = true;
 
-    if (pal::getenv(_X("DOTNET_MULTILEVEL_LOOKUP"), &env_lookup))
+    if (env_snapshot::get(env_key_t::DOTNET_MULTILEVEL_LOOKUP, &env_lookup))
     {
         auto env_val = pal::xtoi(env_lookup.c_str());
         multilevel_lookup = (env_val == 1);
@@ -336,18 +342,61 @@ size_t index_of_non_numeric(const pal::string_t& str, unsigned i)
 
 bool try_stou(const pal::string_t& str, unsigned* num)
 {
-    if (str.empty())
+    return try_stou(str.c_str(), str.length(), num);
+}
+
+bool try_stou(const pal::char_t* str, size_t length, unsigned* num)
+{
+    if (length == 0)
     {
         return false;
     }
-    if (index_of_non_numeric(str, 0) != pal::string_t::npos)
+
+    unsigned value = 0;
+    for (size_t i = 0; i < length; ++i)
     {
-        return false;
+        if (str[i] < _X('0') || str[i] > _X('9'))
+        {
+            return false;
+        }
+
+        unsigned digit = static_cast<unsigned>(str[i] - _X('0'));
+        if (value > (UINT_MAX - digit) / 10)
+        {
+            return false;
+        }
+        value = value * 10 + digit;
     }
-    *num = std::stoul(str);
+
+    *num = value;
     return true;
 }
 
+size_t write_int(int num, pal::char_t* buffer)
+{
+    pal::char_t digits[10];
+    size_t count = 0;
+
+    // Negate as unsigned so that the smallest int does not overflow
+    unsigned value = num < 0 ? 0u - static_cast<unsigned>(num) : static_cast<unsigned>(num);
+    do
+    {
+        digits[count++] = static_cast<pal::char_t>(_X('0') + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    size_t length = 0;
+    if (num < 0)
+    {
+        buffer[length++] = _X('-');
+    }
+    while (count > 0)
+    {
+        buffer[length++] = digits[--count];
+    }
+    return length;
+}
+
 pal::string_t get_dotnet_root_env_var_name()
 {
     if (pal::is_running_in_wow64())
@@ -43,6 +43,12 @@ void get_framework_and_sdk_locations(const pal::string_t& dotnet_dir, std::vecto
 bool get_file_path_from_env(const pal::char_t* env_key, pal::string_t* recv);
 size_t index_of_non_numeric(const pal::string_t& str, unsigned i);
 bool try_stou(const pal::string_t& str, unsigned* num);
+// Parses the decimal number in [str, str + length) without allocating. Fails on an empty range,
+// on characters other than digits and on numbers which don't fit into unsigned.
+bool try_stou(const pal::char_t* str, size_t length, unsigned* num);
+// Writes the decimal representation of num to buffer without a terminating null and returns its length.
+// The buffer must have room for at least 11 characters.
+size_t write_int(int num, pal::char_t* buffer);
 pal::string_t get_dotnet_root_env_var_name();
 pal::string_t get_deps_from_app_binary(const pal::string_t& app_base, const pal::string_t& app);
 void get_runtime_config_paths(const pal::string_t& path, const pal::string_t& name, pal::string_t* cfg, pal::string_t* dev_cfg);
@@ -0,0 +1,101 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+using FluentAssertions;
+using Microsoft.DotNet.Cli.Build.Framework;
+using System.IO;
+using Xunit;
+
+namespace Microsoft.DotNet.CoreSetup.Test.HostActivation.DependencyResolution
+{
+    public class DepsCache :
+        ComponentDependencyResolutionBase,
+        IClassFixture<DepsCache.SharedTestState>
+    {
+        private const string DepsCacheEnvironmentVariable = "DOTNET_DEPS_CACHE";
+
+        private SharedTestState SharedState { get; }
+
+        public DepsCache(SharedTestState sharedState)
+        {
+            SharedState = sharedState;
+        }
+
+        [Fact]
+        public void CacheIsWrittenAndUsed()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                string depsCache = Path.ChangeExtension(app.DepsJson, ".bin");
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"Wrote deps cache [{depsCache}]");
+
+                File.Exists(depsCache).Should().BeTrue();
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"from cache [{depsCache}]");
+            }
+        }
+
+        [Fact]
+        public void CacheIsNotUsedWhenDisabled()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app, enableCache: false)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app);
+
+                File.Exists(Path.ChangeExtension(app.DepsJson, ".bin")).Should().BeFalse();
+            }
+        }
+
+        [Fact]
+        public void ChangedDepsFileInvalidatesCache()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                string depsCache = Path.ChangeExtension(app.DepsJson, ".bin");
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app);
+
+                File.Copy(Path.Combine(app.Location, "Dependency.dll"), Path.Combine(app.Location, "Renamed.dll"));
+                File.WriteAllText(app.DepsJson, File.ReadAllText(app.DepsJson).Replace("Dependency.dll", "Renamed.dll"));
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Renamed.dll", app)
+                    .And.NotHaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"Deps cache [{depsCache}] is stale or invalid");
+            }
+        }
+
+        private TestApp CreateAppWithDependency()
+        {
+            return NetCoreAppBuilder.PortableForNETCoreApp(SharedState.FrameworkReferenceApp)
+                .WithProject(p => p.WithAssemblyGroup(null, g => g.WithMainAssembly()))
+                .WithPackage("Dependency", "1.0.0", p => p.WithAssemblyGroup(null, g => g.WithAsset("Dependency.dll")))
+                .Build();
+        }
+
+        private CommandResult RunApp(TestApp app, bool enableCache = true)
+        {
+            return SharedState.DotNetWithNetCoreApp.Exec(app.AppDll)
+                .EnableTracingAndCaptureOutputs()
+                .EnvironmentVariable(DepsCacheEnvironmentVariable, enableCache ? "1" : "0")
+                .Execute();
+        }
+
+        public class SharedTestState : ComponentSharedTestStateBase
+        {
+        }
+    }
+}
@@ -0,0 +1,65 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+using FluentAssertions;
+using Microsoft.DotNet.Cli.Build.Framework;
+using System.Text.RegularExpressions;
+using Xunit;
+
+namespace Microsoft.DotNet.CoreSetup.Test.HostActivation.DependencyResolution
+{
+    // hostfxr parses the root deps.json to find the hostpolicy version and hands the result over
+    // to hostpolicy, which should then use it instead of reading the same file again.
+    public class HostLoadedDeps :
+        ComponentDependencyResolutionBase,
+        IClassFixture<HostLoadedDeps.SharedTestState>
+    {
+        private SharedTestState SharedState { get; }
+
+        public HostLoadedDeps(SharedTestState sharedState)
+        {
+            SharedState = sharedState;
+        }
+
+        [Fact]
+        public void FrameworkDependentApp()
+        {
+            using (TestApp app = NetCoreAppBuilder.PortableForNETCoreApp(SharedState.FrameworkReferenceApp)
+                .WithProject(p => p.WithAssemblyGroup(null, g => g.WithMainAssembly()))
+                .WithPackage("Dependency", "1.0.0", p => p.WithAssemblyGroup(null, g => g.WithAsset("Dependency.dll")))
+                .Build())
+            {
+                CommandResult result = SharedState.DotNetWithNetCoreApp.Exec(app.AppDll)
+                    .EnableTracingAndCaptureOutputs()
+                    .Execute();
+
+                result.Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining("loaded by the host");
+                Regex.Matches(result.StdErr, "Loading deps file.*Microsoft.NETCore.App.deps.json").Count.Should().Be(1);
+            }
+        }
+
+        [Fact]
+        public void SelfContainedApp()
+        {
+            CommandResult result = SharedState.DotNetWithNetCoreApp.Exec(SharedState.SelfContainedApp.AppDll)
+                .EnableTracingAndCaptureOutputs()
+                .Execute();
+
+            result.Should().Pass()
+                .And.HaveStdErrContaining($"Using deps file [{SharedState.SelfContainedApp.DepsJson}] loaded by the host");
+        }
+
+        public class SharedTestState : ComponentSharedTestStateBase
+        {
+            public TestApp SelfContainedApp { get; }
+
+            public SharedTestState()
+            {
+                SelfContainedApp = CreateSelfContainedAppWithMockCoreClr("HostLoadedDepsSelfContainedApp", "1.0.0");
+            }
+        }
+    }
+}
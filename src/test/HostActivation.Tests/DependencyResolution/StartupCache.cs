@@ -0,0 +1,248 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+using FluentAssertions;
+using Microsoft.DotNet.Cli.Build.Framework;
+using System;
+using System.IO;
+using Xunit;
+
+namespace Microsoft.DotNet.CoreSetup.Test.HostActivation.DependencyResolution
+{
+    public class StartupCache :
+        ComponentDependencyResolutionBase,
+        IClassFixture<StartupCache.SharedTestState>
+    {
+        private const string StartupCacheEnvironmentVariable = "DOTNET_STARTUP_CACHE";
+
+        private SharedTestState SharedState { get; }
+
+        public StartupCache(SharedTestState sharedState)
+        {
+            SharedState = sharedState;
+        }
+
+        [Fact]
+        public void CacheIsWrittenAndUsed()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                string startupCache = GetStartupCachePath(app);
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"Wrote startup cache [{startupCache}]");
+
+                File.Exists(startupCache).Should().BeTrue();
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"Using startup cache [{startupCache}]")
+                    .And.NotHaveStdErrContaining("-- Listing probe configurations...");
+            }
+        }
+
+        [Fact]
+        public void CacheIsNotUsedWhenDisabled()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app, enableCache: false)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app);
+
+                File.Exists(GetStartupCachePath(app)).Should().BeFalse();
+            }
+        }
+
+        [Fact]
+        public void CacheIsNotUsedWithAdditionalDeps()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                string additionalDeps = Path.Combine(app.Location, "additional.deps.json");
+                File.Copy(app.DepsJson, additionalDeps);
+
+                SharedState.DotNetWithNetCoreApp.Exec("exec", "--additional-deps", additionalDeps, app.AppDll)
+                    .EnableTracingAndCaptureOutputs()
+                    .EnvironmentVariable(StartupCacheEnvironmentVariable, "1")
+                    .Execute()
+                    .Should().Pass()
+                    .And.HaveStdErrContaining("The startup cache is not used together with additional deps");
+
+                File.Exists(GetStartupCachePath(app)).Should().BeFalse();
+            }
+        }
+
+        [Fact]
+        public void ChangedDepsFileInvalidatesCache()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app);
+
+                File.Copy(Path.Combine(app.Location, "Dependency.dll"), Path.Combine(app.Location, "Renamed.dll"));
+                File.WriteAllText(app.DepsJson, File.ReadAllText(app.DepsJson).Replace("Dependency.dll", "Renamed.dll"));
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Renamed.dll", app)
+                    .And.NotHaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"Startup cache [{GetStartupCachePath(app)}] is stale or invalid");
+            }
+        }
+
+        [Fact]
+        public void RemovedAppFileInvalidatesCache()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app);
+
+                File.Delete(Path.Combine(app.Location, "Dependency.dll"));
+
+                RunApp(app)
+                    .Should().Fail()
+                    .And.HaveStdErrContaining($"Startup cache [{GetStartupCachePath(app)}] is stale or invalid")
+                    .And.HaveStdErrContaining("An assembly specified in the application dependencies manifest");
+            }
+        }
+
+        [Fact]
+        public void AddedAppFileInvalidatesCache()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app);
+
+                File.WriteAllText(Path.Combine(app.Location, "New.txt"), string.Empty);
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly("Dependency.dll", app)
+                    .And.HaveStdErrContaining($"Startup cache [{GetStartupCachePath(app)}] is stale or invalid");
+            }
+        }
+
+        [Fact]
+        public void ChangedAssetDirectoryInvalidatesCache()
+        {
+            using (TestApp app = NetCoreAppBuilder.PortableForNETCoreApp(SharedState.FrameworkReferenceApp)
+                .WithProject(p => p.WithAssemblyGroup(null, g => g.WithMainAssembly()))
+                .WithPackage("Dependency", "1.0.0", p => p.WithAssemblyGroup(null, g => g.WithAsset("lib/Dependency.dll")))
+                .Build())
+            {
+                string assetDirectory = Path.Combine(app.Location, "lib");
+
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveResolvedAssembly(Path.Combine(assetDirectory, "Dependency.dll"));
+
+                File.Move(Path.Combine(assetDirectory, "Dependency.dll"), Path.Combine(assetDirectory, "Moved.dll"));
+
+                RunApp(app)
+                    .Should().Fail()
+                    .And.HaveStdErrContaining($"Directory [{assetDirectory}] changed since the startup cache was written");
+            }
+        }
+
+        [Fact]
+        public void ChangedRuntimeIdInvalidatesCache()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app)
+                    .Should().Pass();
+
+                RunApp(app, command => command.RuntimeId("some-rid"))
+                    .Should().Pass()
+                    .And.HaveStdErrContaining($"Startup cache [{GetStartupCachePath(app)}] is stale or invalid");
+            }
+        }
+
+        [Fact]
+        public void ChangedFrameworkInvalidatesCache()
+        {
+            using (TestApp app = CreateAppWithDependency())
+            {
+                RunApp(app)
+                    .Should().Pass()
+                    .And.HaveStdErrContaining($"Wrote startup cache [{GetStartupCachePath(app)}]");
+
+                // Resolve the app against a different framework installation
+                SharedState.DotNetWithOtherNetCoreApp.Exec(app.AppDll)
+                    .EnableTracingAndCaptureOutputs()
+                    .EnvironmentVariable(StartupCacheEnvironmentVariable, "1")
+                    .Execute()
+                    .Should().Pass()
+                    .And.HaveStdErrContaining($"Startup cache [{GetStartupCachePath(app)}] is stale or invalid");
+            }
+        }
+
+        [Fact]
+        public void ComponentDependenciesAreResolvedWhenAppStartsFromCache()
+        {
+            TestApp hostApp = SharedState.FrameworkReferenceApp.Copy();
+            Action<Command> enableCache = command => command.EnvironmentVariable(StartupCacheEnvironmentVariable, "1");
+
+            SharedState.RunComponentResolutionTest(hostApp.AppDll, hostApp, SharedState.DotNetWithNetCoreApp.GreatestVersionHostFxrPath, enableCache)
+                .Should().Pass();
+
+            File.Exists(GetStartupCachePath(hostApp)).Should().BeTrue();
+
+            SharedState.RunComponentResolutionTest(hostApp.AppDll, hostApp, SharedState.DotNetWithNetCoreApp.GreatestVersionHostFxrPath, enableCache)
+                .Should().Pass()
+                .And.HaveStdOutContaining("corehost_resolve_component_dependencies:Success")
+                .And.HaveStdOutContaining($"corehost_resolve_component_dependencies assemblies:[{hostApp.AppDll}{Path.PathSeparator}]");
+        }
+
+        private static string GetStartupCachePath(TestApp app)
+        {
+            return Path.ChangeExtension(app.AppDll, ".startup.bin");
+        }
+
+        private TestApp CreateAppWithDependency()
+        {
+            return NetCoreAppBuilder.PortableForNETCoreApp(SharedState.FrameworkReferenceApp)
+                .WithProject(p => p.WithAssemblyGroup(null, g => g.WithMainAssembly()))
+                .WithPackage("Dependency", "1.0.0", p => p.WithAssemblyGroup(null, g => g.WithAsset("Dependency.dll")))
+                .Build();
+        }
+
+        private CommandResult RunApp(TestApp app, bool enableCache = true)
+        {
+            return RunApp(app, command => command.EnvironmentVariable(StartupCacheEnvironmentVariable, enableCache ? "1" : "0"));
+        }
+
+        private CommandResult RunApp(TestApp app, Action<Command> customizer)
+        {
+            Command command = SharedState.DotNetWithNetCoreApp.Exec(app.AppDll)
+                .EnableTracingAndCaptureOutputs()
+                .EnvironmentVariable(StartupCacheEnvironmentVariable, "1");
+            customizer(command);
+
+            return command.Execute();
+        }
+
+        public class SharedTestState : ComponentSharedTestStateBase
+        {
+            public DotNetCli DotNetWithOtherNetCoreApp { get; }
+
+            public SharedTestState()
+            {
+                DotNetWithOtherNetCoreApp = DotNet("WithOtherNetCoreApp")
+                    .AddMicrosoftNETCoreAppFrameworkMockCoreClr("4.0.1")
+                    .Build();
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+using FluentAssertions;
+using Microsoft.DotNet.Cli.Build.Framework;
+using Newtonsoft.Json.Linq;
+using System;
+using System.IO;
+using System.Linq;
+using Xunit;
+
+namespace Microsoft.DotNet.CoreSetup.Test.HostActivation.DependencyResolution
+{
+    // The streaming deps.json loader has to produce exactly the same results as the DOM based one,
+    // so run the same apps with both loaders and compare all the properties passed to the runtime.
+    public class StreamingDepsLoader :
+        ComponentDependencyResolutionBase,
+        IClassFixture<StreamingDepsLoader.SharedTestState>
+    {
+        private const string DomLoaderEnvironmentVariable = "DOTNET_DEPS_DOM_LOADER";
+        private const string FallbackToDomLoaderMessage = "falling back to the DOM based loader";
+
+        private SharedTestState SharedState { get; }
+
+        public StreamingDepsLoader(SharedTestState sharedState)
+        {
+            SharedState = sharedState;
+        }
+
+        [Theory]
+        [InlineData("win10-x64")]
+        [InlineData("linux-x64")]
+        [InlineData("osx-x64")]
+        [InlineData("unknown-rid")]
+        public void PortableApp(string rid)
+        {
+            using (TestApp app = CreatePortableApp())
+            {
+                RunAndCompare(app, rid);
+            }
+        }
+
+        [Theory]
+        [InlineData("win10-x64")]
+        [InlineData("linux-x64")]
+        public void SelfContainedApp(string rid)
+        {
+            RunAndCompare(SharedState.SelfContainedApp, rid);
+        }
+
+        [Fact]
+        public void LibrariesBeforeTargets()
+        {
+            using (TestApp app = CreatePortableApp())
+            {
+                ReorderDepsJson(app, "runtimeTarget", "libraries", "targets");
+
+                CommandResult result = RunAndCompare(app, "win10-x64");
+                result.Should().NotHaveStdErrContaining(FallbackToDomLoaderMessage);
+            }
+        }
+
+        [Fact]
+        public void RuntimeTargetAfterTargets()
+        {
+            using (TestApp app = CreatePortableApp())
+            {
+                ReorderDepsJson(app, "targets", "libraries", "runtimeTarget");
+
+                CommandResult result = RunAndCompare(app, "win10-x64");
+                result.Should().HaveStdErrContaining(FallbackToDomLoaderMessage);
+            }
+        }
+
+        private TestApp CreatePortableApp()
+        {
+            return NetCoreAppBuilder.PortableForNETCoreApp(SharedState.FrameworkReferenceApp)
+                .WithProject(p => p
+                    .WithAssemblyGroup(null, g => g.WithMainAssembly())
+                    .WithAssemblyGroup("win", g => g.WithAsset("win/WindowsAssembly.dll"))
+                    .WithAssemblyGroup("linux", g => g.WithAsset("linux/LinuxAssembly.dll"))
+                    .WithNativeLibraryGroup("win-x64", g => g.WithAsset("win-x64/NativeWin64.dll"))
+                    .WithNativeLibraryGroup("any", g => g.WithAsset("any/NativeAny.so")))
+                .WithPackage("Dependency", "1.0.0", p => p
+                    .WithAssemblyGroup(null, g => g
+                        .WithAsset("lib/netstandard2.0/Dependency.dll", f => f
+                            .WithVersion("2.0.0.0", "2.1.0.0")
+                            .WithFileOnDiskPath("Dependency.dll")))
+                    .WithResourceAssembly("fr/Dependency.resources.dll")
+                    .WithNativeLibraryGroup(null, g => g.WithAsset("native/dependency.so")))
+                .WithPackage("Dependency.Ni", "1.0.0", p => p
+                    .WithAssemblyGroup(null, g => g
+                        .WithAsset("Dependency.Ni.dll")
+                        .WithAsset("Dependency.Ni.ni.dll")))
+                .Build();
+        }
+
+        private CommandResult RunAndCompare(TestApp app, string rid)
+        {
+            CommandResult dom = Run(app, rid, useDomLoader: true);
+            CommandResult streaming = Run(app, rid, useDomLoader: false);
+
+            dom.Should().Pass();
+            streaming.Should().Pass();
+            GetRuntimeProperties(streaming).Should().Equal(GetRuntimeProperties(dom));
+
+            return streaming;
+        }
+
+        private CommandResult Run(TestApp app, string rid, bool useDomLoader)
+        {
+            return SharedState.DotNetWithNetCoreApp.Exec(app.AppDll)
+                .EnableTracingAndCaptureOutputs()
+                .RuntimeId(rid)
+                .EnvironmentVariable(DomLoaderEnvironmentVariable, useDomLoader ? "1" : "0")
+                .Execute();
+        }
+
+        private static string[] GetRuntimeProperties(CommandResult result)
+        {
+            return result.StdOut
+                .Split(new[] { Environment.NewLine }, StringSplitOptions.RemoveEmptyEntries)
+                .Where(line => line.StartsWith("mock property["))
+                .ToArray();
+        }
+
+        private static void ReorderDepsJson(TestApp app, params string[] propertyOrder)
+        {
+            JObject depsJson = JObject.Parse(File.ReadAllText(app.DepsJson));
+            JObject reordered = new JObject();
+            foreach (string name in propertyOrder)
+            {
+                reordered.Add(name, depsJson[name]);
+            }
+
+            File.WriteAllText(app.DepsJson, reordered.ToString());
+        }
+
+        public class SharedTestState : ComponentSharedTestStateBase
+        {
+            public TestApp SelfContainedApp { get; }
+
+            public SharedTestState()
+            {
+                SelfContainedApp = CreateSelfContainedAppWithMockCoreClr(
+                    "StreamingDepsLoaderSelfContainedApp",
+                    "1.0.0",
+                    b => b
+                        .WithStandardRuntimeFallbacks()
+                        .WithPackage("Dependency", "1.0.0", p => p
+                            .WithAssemblyGroup(null, g => g.WithAsset("Dependency.dll"))
+                            .WithNativeLibraryGroup("win", g => g.WithAsset("win/dependency.dll"))));
+            }
+        }
+    }
+}
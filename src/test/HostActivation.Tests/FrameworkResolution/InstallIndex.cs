@@ -0,0 +1,152 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+using FluentAssertions;
+using Microsoft.DotNet.Cli.Build;
+using Microsoft.DotNet.Cli.Build.Framework;
+using System.IO;
+using Xunit;
+
+namespace Microsoft.DotNet.CoreSetup.Test.HostActivation.FrameworkResolution
+{
+    public class InstallIndex :
+        FrameworkResolutionBase,
+        IClassFixture<InstallIndex.SharedTestState>
+    {
+        private const string InstallIndexEnvironmentVariable = "DOTNET_INSTALL_INDEX";
+
+        private SharedTestState SharedState { get; }
+
+        public InstallIndex(SharedTestState sharedState)
+        {
+            SharedState = sharedState;
+        }
+
+        [Fact]
+        public void IndexIsWrittenAndUsed()
+        {
+            DotNetCli dotnet = SharedState.CreateDotNet("WrittenAndUsed");
+            string installIndex = GetInstallIndexPath(dotnet);
+
+            RunTest(dotnet)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.1.2")
+                .And.HaveStdErrContaining($"Wrote install index [{installIndex}]");
+
+            File.Exists(installIndex).Should().BeTrue();
+
+            RunTest(dotnet)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.1.2")
+                .And.HaveStdErrContaining($"Using install index [{installIndex}]");
+        }
+
+        [Fact]
+        public void IndexIsNotUsedWhenDisabled()
+        {
+            DotNetCli dotnet = SharedState.CreateDotNet("Disabled");
+
+            RunTest(dotnet, enableIndex: false)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.1.2");
+
+            File.Exists(GetInstallIndexPath(dotnet)).Should().BeFalse();
+        }
+
+        [Fact]
+        public void InstalledFrameworkInvalidatesIndex()
+        {
+            DotNetCli dotnet = SharedState.CreateDotNet("InstalledFramework");
+
+            RunTest(dotnet)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.1.2");
+
+            string frameworkDir = Path.Combine(dotnet.BinPath, "shared", MicrosoftNETCoreApp);
+            SharedFramework.CopyDirectory(Path.Combine(frameworkDir, "5.1.2"), Path.Combine(frameworkDir, "5.1.3"));
+
+            RunTest(dotnet)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.1.3")
+                .And.HaveStdErrContaining($"Install index [{GetInstallIndexPath(dotnet)}] is stale");
+
+            dotnet.Exec("--list-runtimes")
+                .EnvironmentVariable(InstallIndexEnvironmentVariable, "1")
+                .CaptureStdOut()
+                .Execute()
+                .Should().Pass()
+                .And.HaveStdOutContaining($"{MicrosoftNETCoreApp} 5.1.3");
+        }
+
+        [Fact]
+        public void RemovedFrameworkInvalidatesIndex()
+        {
+            DotNetCli dotnet = SharedState.CreateDotNet("RemovedFramework");
+
+            RunTest(dotnet)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.1.2");
+
+            Directory.Delete(Path.Combine(dotnet.BinPath, "shared", MicrosoftNETCoreApp, "5.1.2"), true);
+
+            RunTest(dotnet)
+                .ShouldHaveResolvedFramework(MicrosoftNETCoreApp, "5.2.0")
+                .And.HaveStdErrContaining($"Install index [{GetInstallIndexPath(dotnet)}] is stale");
+        }
+
+        [Fact]
+        public void InstalledSdkInvalidatesIndex()
+        {
+            DotNetCli dotnet = SharedState.CreateDotNet("InstalledSdk");
+
+            RunListSdks(dotnet)
+                .Should().Pass()
+                .And.NotHaveStdOutContaining("9.9.9");
+
+            Directory.CreateDirectory(Path.Combine(dotnet.BinPath, "sdk", "9.9.9"));
+
+            RunListSdks(dotnet)
+                .Should().Pass()
+                .And.HaveStdOutContaining("9.9.9")
+                .And.HaveStdErrContaining($"Install index [{GetInstallIndexPath(dotnet)}] is stale");
+        }
+
+        private static string GetInstallIndexPath(DotNetCli dotnet)
+        {
+            return Path.Combine(dotnet.BinPath, "install.index.bin");
+        }
+
+        private CommandResult RunTest(DotNetCli dotnet, bool enableIndex = true)
+        {
+            return RunTest(
+                dotnet,
+                SharedState.FrameworkReferenceApp,
+                new TestSettings()
+                    .WithRuntimeConfigCustomizer(runtimeConfig => runtimeConfig
+                        .WithFramework(MicrosoftNETCoreApp, "5.0.0"))
+                    .WithEnvironment(InstallIndexEnvironmentVariable, enableIndex ? "1" : "0"));
+        }
+
+        private static CommandResult RunListSdks(DotNetCli dotnet)
+        {
+            return dotnet.Exec("--list-sdks")
+                .EnvironmentVariable(InstallIndexEnvironmentVariable, "1")
+                .EnableTracingAndCaptureOutputs()
+                .Execute();
+        }
+
+        public class SharedTestState : SharedTestStateBase
+        {
+            public TestApp FrameworkReferenceApp { get; }
+
+            public SharedTestState()
+            {
+                FrameworkReferenceApp = CreateFrameworkReferenceApp();
+            }
+
+            // Each test modifies its own installation
+            public DotNetCli CreateDotNet(string name)
+            {
+                return DotNet(name)
+                    .AddMicrosoftNETCoreAppFrameworkMockHostPolicy("5.1.2")
+                    .AddMicrosoftNETCoreAppFrameworkMockHostPolicy("5.2.0")
+                    .Build();
+            }
+        }
+    }
+}
@@ -2,9 +2,11 @@
 // The .NET Foundation licenses this file to you under the MIT license.
 // See the LICENSE file in the project root for more information.
 
+using FluentAssertions;
 using Microsoft.DotNet.Cli.Build;
 using Microsoft.DotNet.Cli.Build.Framework;
 using System;
+using System.IO;
 using Xunit;
 
 namespace Microsoft.DotNet.CoreSetup.Test.HostActivation.FrameworkResolution
@@ -595,6 +597,55 @@ public void FrameworkResolutionRetry_FrameworkTree()
                 .And.HaveResolvedFramework(MicrosoftNETCoreApp, "5.6.0");
         }
 
+        // Same as FrameworkResolutionRetry_FrameworkChain, but verifies that the retries don't read
+        // the framework directories and runtime configs from the disk again.
+        [Fact]
+        public void FrameworkResolutionRetry_ReadsDiskOnce()
+        {
+            CommandResult result = RunTest(
+                runtimeConfig => runtimeConfig
+                    .WithRollForward(Constants.RollForwardSetting.Major)
+                    .WithFramework(MicrosoftNETCoreApp, "5.1.1")
+                    .WithFramework(HighWare, "7.3.1"),
+                dotnetCustomizer =>
+                {
+                    dotnetCustomizer.Framework(HighWare).RuntimeConfig(runtimeConfig =>
+                        runtimeConfig.GetFramework(MicrosoftNETCoreApp)
+                            .Version = "5.4.1");
+                    dotnetCustomizer.Framework(MiddleWare).RuntimeConfig(runtimeConfig =>
+                        runtimeConfig.GetFramework(MicrosoftNETCoreApp)
+                            .Version = "5.6.0");
+                });
+
+            result.Should().Pass()
+                .And.RestartedFrameworkResolution("5.1.1", "5.4.1")
+                .And.RestartedFrameworkResolution("5.4.1", "5.6.0")
+                .And.HaveResolvedFramework(MicrosoftNETCoreApp, "5.6.0");
+
+            string sharedPath = Path.Combine(SharedState.DotNetWithMultipleFrameworks.BinPath, "shared");
+            foreach (string frameworkName in new[] { MicrosoftNETCoreApp, HighWare, MiddleWare })
+            {
+                CountOccurrences(result.StdErr, $"Reading FX versions in [{Path.Combine(sharedPath, frameworkName)}]")
+                    .Should().Be(1);
+            }
+
+            CountOccurrences(result.StdErr, $"Attempting to read runtime config: {Path.Combine(sharedPath, HighWare, "7.3.1", HighWare + ".runtimeconfig.json")}")
+                .Should().Be(1);
+            CountOccurrences(result.StdErr, $"Attempting to read runtime config: {Path.Combine(sharedPath, MiddleWare, "2.1.2", MiddleWare + ".runtimeconfig.json")}")
+                .Should().Be(1);
+        }
+
+        private static int CountOccurrences(string text, string value)
+        {
+            int count = 0;
+            for (int index = text.IndexOf(value); index >= 0; index = text.IndexOf(value, index + value.Length))
+            {
+                count++;
+            }
+
+            return count;
+        }
+
         // Verifies that reconciling framework references correctly remembers whether it should prefer release versions or not.
         [Theory]
         [InlineData("6.0.0",           "6.1.1-preview.0", "6.2.1")]           // Release should prefer release even if there's a pre-release in the middle
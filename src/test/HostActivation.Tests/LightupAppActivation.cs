@@ -92,8 +92,10 @@ public void Muxer_activation_of_LightupApp_NoLightupLib_Fails()
 
         // Attempt to run the app with lightup deps.json specified and lightup library present in the expected
         // probe locations.
-        [Fact]
-        public void Muxer_activation_of_LightupApp_WithLightupLib_Succeeds()
+        [Theory]
+        [InlineData(false)]
+        [InlineData(true)]
+        public void Muxer_activation_of_LightupApp_WithLightupLib_Succeeds(bool parallelDepsParsing)
         {
             var fixtureLib = sharedTestState.LightupLibFixture_Published
                 .Copy();
@@ -135,6 +137,7 @@ public void Muxer_activation_of_LightupApp_WithLightupLib_Succeeds()
 
             // Execute the test using the custom lightup path where lightup.deps.json can be found.
             dotnet.Exec("exec", "--additional-deps", baseDir, appDll)
+                .EnvironmentVariable("DOTNET_DEPS_PARALLEL_PARSING", parallelDepsParsing ? "1" : "0")
                 .CaptureStdErr()
                 .CaptureStdOut()
                 .Execute()
@@ -345,8 +348,10 @@ public void Muxer_activation_of_LightupApp_WithLightupLib_NoLightupDepsJson_Fail
                 .And.HaveStdOutContaining("Exception: Failed to load the lightup assembly!");
         }
 
-        [Fact]
-        public void Additional_Deps_Lightup_Folder_With_Bad_JsonFile()
+        [Theory]
+        [InlineData(false)]
+        [InlineData(true)]
+        public void Additional_Deps_Lightup_Folder_With_Bad_JsonFile(bool parallelDepsParsing)
         {
             var fixture = GlobalLightupClientFixture
                 .Copy();
@@ -377,10 +382,12 @@ public void Additional_Deps_Lightup_Folder_With_Bad_JsonFile()
             // Expected: a parsing error since the json file is bad.
             dotnet.Exec("exec", "--additional-deps", additionalDepsRootPath, appDll)
                 .EnvironmentVariable("COREHOST_TRACE", "1")
+                .EnvironmentVariable("DOTNET_DEPS_PARALLEL_PARSING", parallelDepsParsing ? "1" : "0")
                 .CaptureStdOut()
                 .CaptureStdErr()
                 .Execute(fExpectedToFail: true)
                 .Should().Fail()
+                .And.HaveStdErrContaining($"A JSON parsing exception occurred in [{additionalDepsPath}]")
                 .And.HaveStdErrContaining($"Error initializing the dependency resolver: An error occurred while parsing: {additionalDepsPath}");
         }
 
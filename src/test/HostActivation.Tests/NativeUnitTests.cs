@@ -25,5 +25,75 @@ public void Native_Test_Fx_Ver()
                 .Should()
                 .Pass();
         }
+
+        [Fact]
+        public void Native_Test_Deps_Library_Scanner()
+        {
+            RepoDirectoriesProvider repoDirectoriesProvider = new RepoDirectoriesProvider();
+
+            string testPath = Path.Combine(repoDirectoriesProvider.Artifacts, "corehost_test", RuntimeInformationExtensions.GetExeFileNameForCurrentPlatform("test_deps_library_scanner"));
+
+            Command testCommand = Command.Create(testPath);
+            testCommand
+                .Execute()
+                .Should()
+                .Pass();
+        }
+
+        [Fact]
+        public void Native_Test_Trace()
+        {
+            RepoDirectoriesProvider repoDirectoriesProvider = new RepoDirectoriesProvider();
+
+            string testPath = Path.Combine(repoDirectoriesProvider.Artifacts, "corehost_test", RuntimeInformationExtensions.GetExeFileNameForCurrentPlatform("test_trace"));
+
+            Command testCommand = Command.Create(testPath);
+            testCommand
+                .Execute()
+                .Should()
+                .Pass();
+        }
+
+        [Fact]
+        public void Native_Test_Sdk_Resolution()
+        {
+            RepoDirectoriesProvider repoDirectoriesProvider = new RepoDirectoriesProvider();
+
+            string testPath = Path.Combine(repoDirectoriesProvider.Artifacts, "corehost_test", RuntimeInformationExtensions.GetExeFileNameForCurrentPlatform("test_sdk_resolution"));
+
+            Command testCommand = Command.Create(testPath);
+            testCommand
+                .Execute()
+                .Should()
+                .Pass();
+        }
+
+        [Fact]
+        public void Native_Test_Realpath()
+        {
+            RepoDirectoriesProvider repoDirectoriesProvider = new RepoDirectoriesProvider();
+
+            string testPath = Path.Combine(repoDirectoriesProvider.Artifacts, "corehost_test", RuntimeInformationExtensions.GetExeFileNameForCurrentPlatform("test_realpath"));
+
+            Command testCommand = Command.Create(testPath);
+            testCommand
+                .Execute()
+                .Should()
+                .Pass();
+        }
+
+        [Fact]
+        public void Native_Test_Deps_Resolution()
+        {
+            RepoDirectoriesProvider repoDirectoriesProvider = new RepoDirectoriesProvider();
+
+            string testPath = Path.Combine(repoDirectoriesProvider.Artifacts, "corehost_test", RuntimeInformationExtensions.GetExeFileNameForCurrentPlatform("test_deps_resolution"));
+
+            Command testCommand = Command.Create(testPath);
+            testCommand
+                .Execute()
+                .Should()
+                .Pass();
+        }
     }
 }